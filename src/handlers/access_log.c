@@ -0,0 +1,201 @@
+/**
+ * @file access_log.c
+ * @brief 内存访问日志实现
+ *
+ * 槽位的 seq 为 0 表示正在写入，否则为该记录的序号+1。
+ * 写者：fetch_add 取得序号 -> seq 置0 -> 写字段 -> release 写入 seq；
+ * 读者：acquire 读 seq -> 复制记录 -> 再读 seq，两次一致且等于期望序号才采用。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include "access_log.h"
+#include "http_utils.h"
+#include "json_writer.h"
+
+typedef struct {
+    guint64 seq;
+    gint64 time_ms;             /* 墙钟时间（毫秒） */
+    guint32 latency_us;
+    guint32 bytes;
+    guint16 status;
+    char method[8];
+    char path[ACCESS_LOG_PATH_MAX];
+    struct mg_addr rem;
+} AccessLogRecord;
+
+static AccessLogRecord g_access_log[ACCESS_LOG_SIZE];
+static guint64 g_access_log_next = 0;
+
+/* 状态码过滤：精确值，或 "4xx" 这样的类别 */
+typedef struct {
+    int value;
+    int is_class;
+} AccessLogStatusFilter;
+
+/*============================================================================
+ * 内部函数
+ *============================================================================*/
+
+/**
+ * 按序号读取一条记录
+ * @return 0成功, -1已被覆盖或正在写入
+ */
+static int access_log_read(guint64 seq, AccessLogRecord *out) {
+    AccessLogRecord *slot = &g_access_log[seq & (ACCESS_LOG_SIZE - 1)];
+
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != seq + 1) {
+        return -1;
+    }
+    memcpy(out, slot, sizeof(*out));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq + 1) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 解析 status 参数
+ * @return 0成功（无参数时 value 为0）, -1格式错误
+ */
+static int access_log_parse_status(struct mg_http_message *hm, AccessLogStatusFilter *filter) {
+    char buf[8];
+    int n = mg_http_get_var(&hm->query, "status", buf, sizeof(buf));
+
+    memset(filter, 0, sizeof(*filter));
+    if (n == 0 || n == -1 || n == -4) {
+        return 0;
+    }
+    if (n == 3 && buf[0] >= '1' && buf[0] <= '5' &&
+        g_ascii_tolower(buf[1]) == 'x' && g_ascii_tolower(buf[2]) == 'x') {
+        filter->value = buf[0] - '0';
+        filter->is_class = 1;
+        return 0;
+    }
+    if (n == 3 && g_ascii_isdigit(buf[0]) && g_ascii_isdigit(buf[1]) && g_ascii_isdigit(buf[2])) {
+        filter->value = atoi(buf);
+        return 0;
+    }
+    return -1;
+}
+
+static int access_log_status_match(const AccessLogStatusFilter *filter, int status) {
+    if (filter->value == 0) {
+        return 1;
+    }
+    return filter->is_class ? status / 100 == filter->value : status == filter->value;
+}
+
+/* 非负整数参数，无参数时返回默认值，格式错误返回-1 */
+static long access_log_get_long(struct mg_http_message *hm, const char *name, long def) {
+    char buf[16], *end = NULL;
+    int n = mg_http_get_var(&hm->query, name, buf, sizeof(buf));
+
+    if (n == 0 || n == -1 || n == -4) {
+        return def;
+    }
+    if (n < 0) {
+        return -1;
+    }
+    long v = strtol(buf, &end, 10);
+    return (end && *end == '\0' && v >= 0) ? v : -1;
+}
+
+/*============================================================================
+ * 公共接口
+ *============================================================================*/
+
+void access_log_record(const struct mg_addr *rem, struct mg_str method, struct mg_str uri,
+                       int status, size_t bytes, gint64 start_us) {
+    gint64 latency = g_get_monotonic_time() - start_us;
+    guint64 seq = __atomic_fetch_add(&g_access_log_next, 1, __ATOMIC_RELAXED);
+    AccessLogRecord *slot = &g_access_log[seq & (ACCESS_LOG_SIZE - 1)];
+
+    __atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot->time_ms = g_get_real_time() / 1000;
+    slot->latency_us = (guint32)CLAMP(latency, 0, G_MAXUINT32);
+    slot->bytes = (guint32)MIN(bytes, G_MAXUINT32);
+    slot->status = (guint16)status;
+    size_t n = MIN(method.len, sizeof(slot->method) - 1);
+    memcpy(slot->method, method.buf, n);
+    slot->method[n] = '\0';
+    n = MIN(uri.len, sizeof(slot->path) - 1);
+    memcpy(slot->path, uri.buf, n);
+    slot->path[n] = '\0';
+    if (rem) {
+        slot->rem = *rem;
+    } else {
+        memset(&slot->rem, 0, sizeof(slot->rem));
+    }
+
+    __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELEASE);
+}
+
+void handle_access_log(struct mg_connection *c, struct mg_http_message *hm) {
+    HTTP_CHECK_GET(c, hm);
+
+    AccessLogStatusFilter status;
+    char prefix[ACCESS_LOG_PATH_MAX];
+    long min_ms = access_log_get_long(hm, "min_ms", 0);
+    long limit = access_log_get_long(hm, "limit", ACCESS_LOG_DEFAULT_LIMIT);
+    int n = mg_http_get_var(&hm->query, "prefix", prefix, sizeof(prefix));
+
+    if (n < 0 && n != -1 && n != -4) {
+        n = -2;                     /* 解码失败或超长 */
+    } else if (n < 0) {
+        prefix[0] = '\0';
+    }
+    if (access_log_parse_status(hm, &status) != 0 || min_ms < 0 || limit < 0 || n == -2) {
+        HTTP_ERROR(c, 400, "无效的查询参数");
+        return;
+    }
+    if (limit > ACCESS_LOG_SIZE) {
+        limit = ACCESS_LOG_SIZE;
+    }
+    size_t prefix_len = strlen(prefix);
+    guint32 min_us = (guint32)MIN(min_ms * 1000, (long)G_MAXUINT32);
+
+    guint64 next = __atomic_load_n(&g_access_log_next, __ATOMIC_ACQUIRE);
+    guint64 oldest = next > ACCESS_LOG_SIZE ? next - ACCESS_LOG_SIZE : 0;
+    long count = 0;
+
+    JsonWriter w;
+    json_writer_init(&w);
+    json_begin_object(&w);
+    json_kv_int(&w, "total", (long long)next);
+    json_key(&w, "records");
+    json_begin_array(&w);
+
+    for (guint64 seq = next; seq > oldest && count < limit; seq--) {
+        AccessLogRecord rec;
+        char remote[64];
+
+        if (access_log_read(seq - 1, &rec) != 0 ||
+            !access_log_status_match(&status, rec.status) ||
+            rec.latency_us < min_us ||
+            strncmp(rec.path, prefix, prefix_len) != 0) {
+            continue;
+        }
+
+        mg_snprintf(remote, sizeof(remote), "%M", mg_print_ip_port, &rec.rem);
+        json_begin_object(&w);
+        json_kv_int(&w, "time", rec.time_ms);
+        json_kv_string(&w, "remote", remote);
+        json_kv_string(&w, "method", rec.method);
+        json_kv_string(&w, "path", rec.path);
+        json_kv_int(&w, "status", rec.status);
+        json_kv_int(&w, "bytes", rec.bytes);
+        json_kv_double(&w, "latency_ms", rec.latency_us / 1000.0, 2);
+        json_end_object(&w);
+        count++;
+    }
+
+    json_end_array(&w);
+    json_end_object(&w);
+    json_writer_reply(&w, c, 200, HTTP_CORS_HEADERS);
+}
@@ -0,0 +1,293 @@
+/**
+ * @file batch.c
+ * @brief 批量只读请求实现
+ *
+ * 每个子请求用只含发送缓冲的影子连接执行（与工作线程相同），
+ * 再从影子连接的完整响应中取出状态码和响应体写入批量响应。
+ * 事件循环中先处理缓存命中和非阻塞的子请求；还有阻塞型（调制解调器查询）子请求时，
+ * 整个批量任务转交工作线程执行并写出响应，完成后回到事件循环把这些结果写入GET缓存。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include "batch.h"
+#include "http_server.h"
+#include "http_cache.h"
+#include "http_utils.h"
+#include "http_worker.h"
+#include "json_writer.h"
+#include "dbus_core.h"
+#include "metrics.h"
+
+/* 子请求 */
+typedef struct {
+    char *request;                  /* 子请求路径（可带查询串） */
+    struct mg_http_message hm;      /* 指向 request；请求头在执行前从外层请求复制 */
+    RouteMatch match;
+    int status;                     /* 0可执行，否则为错误状态码 */
+    int pending;                    /* 待工作线程执行 */
+    struct mg_connection shadow;    /* 只用发送缓冲 */
+} BatchItem;
+
+typedef struct {
+    int count;
+    BatchItem items[BATCH_MAX_REQUESTS];
+} BatchJob;
+
+/*============================================================================
+ * 内部函数
+ *============================================================================*/
+
+/**
+ * 解码分块传输的响应体（JsonWriter 分块模式的列表接口）
+ * @return 0成功, -1格式错误
+ */
+static int batch_dechunk(struct mg_str body, GString *out) {
+    size_t i = 0;
+
+    while (i < body.len) {
+        size_t n = 0, start = i;
+        while (i < body.len && g_ascii_isxdigit(body.buf[i]) && n <= body.len) {
+            n = n * 16 + (size_t)g_ascii_xdigit_value(body.buf[i++]);
+        }
+        if (i == start || i + 2 > body.len || body.buf[i] != '\r' || body.buf[i + 1] != '\n') {
+            return -1;
+        }
+        i += 2;
+        if (n == 0) {
+            return 0;       /* 结束分块 */
+        }
+        if (n > body.len - i || body.len - i - n < 2) {
+            return -1;
+        }
+        g_string_append_len(out, body.buf + i, (gssize)n);
+        i += n + 2;
+    }
+    return -1;
+}
+
+static void batch_write_error(JsonWriter *w, int status, const char *message) {
+    json_kv_int(w, "status", status);
+    json_key(w, "body");
+    json_begin_object(w);
+    json_kv_string(w, "error", message);
+    json_end_object(w);
+}
+
+/* 把影子连接上的完整响应写成 {"status":...,"body":...} 的内容 */
+static void batch_write_response(JsonWriter *w, struct mg_connection *shadow) {
+    struct mg_http_message resp;
+    GString *body;
+
+    if (shadow->send.len == 0 || shadow->is_resp ||
+        mg_http_parse((const char *)shadow->send.buf, shadow->send.len, &resp) <= 0) {
+        batch_write_error(w, 500, "请求处理失败");
+        return;
+    }
+
+    /* 头部之后的全部数据；无 Content-Length 时 mg_http_parse 不计算响应体长度 */
+    struct mg_str rest = mg_str_n((const char *)shadow->send.buf + resp.head.len,
+                                  shadow->send.len - resp.head.len);
+    struct mg_str *te = mg_http_get_header(&resp, "Transfer-Encoding");
+    if (te && mg_strcasecmp(*te, mg_str("chunked")) == 0) {
+        body = g_string_sized_new(rest.len);
+        if (batch_dechunk(rest, body) != 0) {
+            g_string_free(body, TRUE);
+            batch_write_error(w, 500, "请求处理失败");
+            return;
+        }
+    } else {
+        body = g_string_new_len(rest.buf, (gssize)MIN(resp.body.len, rest.len));
+    }
+
+    json_kv_int(w, "status", mg_http_status(&resp));
+    json_key(w, "body");
+
+    /* 响应体是JSON时原样嵌入，否则作为字符串 */
+    int toklen = 0;
+    if (mg_json_get(mg_str_n(body->str, body->len), "$", &toklen) == 0 && toklen > 0) {
+        json_raw(w, body->str);
+    } else {
+        json_string_n(w, body->str, body->len);
+    }
+    g_string_free(body, TRUE);
+}
+
+/* 解析子请求并检查是否在白名单中（ROUTE_F_BATCH） */
+static void batch_item_init(BatchItem *item, char *request) {
+    const char *q = strchr(request, '?');
+
+    item->request = request;
+    item->hm.method = mg_str("GET");
+    item->hm.uri = mg_str_n(request, q ? (size_t)(q - request) : strlen(request));
+    if (q) {
+        item->hm.query = mg_str(q + 1);
+    }
+    item->hm.proto = mg_str("HTTP/1.1");
+    item->shadow.is_accepted = 1;
+    item->shadow.send.align = MG_IO_SIZE;
+
+    item->status = router_match(item->hm.uri, item->hm.method, &item->match);
+    if (item->status == 0 && !(item->match.route->flags & ROUTE_F_BATCH)) {
+        item->status = 400;
+    }
+}
+
+static void batch_free(BatchJob *job) {
+    for (int i = 0; i < job->count; i++) {
+        free(job->items[i].request);
+        mg_iobuf_free(&job->items[i].shadow.send);
+    }
+    g_free(job);
+}
+
+/* 执行待工作线程处理的子请求（工作线程中，或线程池未运行时在事件循环中） */
+static void batch_run_pending(BatchJob *job, struct mg_http_message *outer) {
+    modem_query_scope_begin();
+    for (int i = 0; i < job->count; i++) {
+        BatchItem *item = &job->items[i];
+        if (item->pending) {
+            memcpy(item->hm.headers, outer->headers, sizeof(item->hm.headers));
+            item->match.route->handler(&item->shadow, &item->hm);
+        }
+    }
+    modem_query_scope_end();
+}
+
+static void batch_reply(struct mg_connection *c, BatchJob *job) {
+    JsonWriter w;
+
+    json_writer_init(&w);
+    json_begin_object(&w);
+    for (int i = 0; i < job->count; i++) {
+        BatchItem *item = &job->items[i];
+
+        json_key(&w, item->request);
+        json_begin_object(&w);
+        if (item->status == 0) {
+            batch_write_response(&w, &item->shadow);
+        } else if (item->status == 400) {
+            batch_write_error(&w, 400, "该接口不支持批量请求");
+        } else {
+            batch_write_error(&w, item->status, item->status == 405 ? "Method not allowed" : "Endpoint not found");
+        }
+        json_end_object(&w);
+    }
+    json_end_object(&w);
+    json_writer_reply(&w, c, 200, HTTP_CORS_HEADERS);
+}
+
+/* 工作线程：执行阻塞型子请求并写出批量响应 */
+static void batch_worker(struct mg_connection *c, struct mg_http_message *hm, void *arg) {
+    BatchJob *job = (BatchJob *)arg;
+
+    batch_run_pending(job, hm);
+    batch_reply(c, job);
+}
+
+/* 事件循环：把工作线程执行的子请求结果写入GET缓存 */
+static void batch_worker_done(struct mg_http_message *hm, void *arg, int fresh) {
+    BatchJob *job = (BatchJob *)arg;
+
+    (void)hm;
+    for (int i = 0; fresh && i < job->count; i++) {
+        BatchItem *item = &job->items[i];
+        if (item->pending) {
+            http_cache_store(&item->shadow, &item->hm, item->match.route, 0);
+        }
+    }
+    batch_free(job);
+}
+
+/*============================================================================
+ * 公共接口
+ *============================================================================*/
+
+void handle_batch(struct mg_connection *c, struct mg_http_message *hm) {
+    HTTP_CHECK_POST(c, hm);
+
+    BatchJob *job;
+    char path[32];
+    int pending = 0;
+
+    int ofs = mg_json_get(hm->body, "$.requests", NULL);
+    if (ofs < 0 || hm->body.buf[ofs] != '[') {
+        HTTP_ERROR(c, 400, "requests 必须是请求路径数组");
+        return;
+    }
+
+    /* 先校验全部子请求，重复的只执行一次 */
+    job = g_new0(BatchJob, 1);
+    for (int i = 0; ; i++) {
+        snprintf(path, sizeof(path), "$.requests[%d]", i);
+        if (mg_json_get(hm->body, path, NULL) < 0) {
+            break;
+        }
+
+        char *req = mg_json_get_str(hm->body, path);
+        if (!req || strncmp(req, "/api/", 5) != 0 || strlen(req) >= BATCH_MAX_PATH) {
+            free(req);
+            HTTP_ERROR(c, 400, "无效的请求路径");
+            batch_free(job);
+            return;
+        }
+
+        int dup = 0;
+        for (int j = 0; j < job->count && !dup; j++) {
+            dup = strcmp(job->items[j].request, req) == 0;
+        }
+        if (dup) {
+            free(req);
+        } else if (job->count >= BATCH_MAX_REQUESTS) {
+            free(req);
+            HTTP_ERROR(c, 400, "请求数量超过上限");
+            batch_free(job);
+            return;
+        } else {
+            batch_item_init(&job->items[job->count++], req);
+        }
+    }
+
+    /* 缓存命中和非阻塞的子请求直接在事件循环中执行 */
+    modem_query_scope_begin();
+    for (int i = 0; i < job->count; i++) {
+        BatchItem *item = &job->items[i];
+        if (item->status != 0) {
+            continue;
+        }
+        memcpy(item->hm.headers, hm->headers, sizeof(item->hm.headers));     /* 继承外层请求头 */
+        if (http_cache_serve(&item->shadow, &item->hm, item->match.route)) {
+            continue;
+        }
+        if (item->match.route->flags & ROUTE_F_BLOCKING) {
+            item->pending = 1;
+            pending++;
+        } else {
+            http_server_call_route(&item->shadow, &item->hm, &item->match);
+        }
+    }
+    modem_query_scope_end();
+    printf("[BATCH] 执行 %d 个子请求，%d 个转交工作线程\n", job->count, pending);
+
+    if (pending > 0) {
+        RouteMatch self;
+        int ret = router_match(hm->uri, hm->method, &self) == 0 ?
+                  http_worker_submit_call(c, hm, self.route, batch_worker, batch_worker_done, job) : -1;
+        if (ret == 0) {
+            return;
+        }
+        if (ret == -2) {
+            metrics_inc(METRIC_HTTP_WORKER_REJECTED, NULL, NULL);
+            mg_http_reply(c, 503, HTTP_CORS_HEADERS "Retry-After: 1\r\n",
+                          "{\"Code\":1,\"Error\":\"服务器繁忙，请稍后重试\",\"Data\":null}");
+            batch_free(job);
+            return;
+        }
+        batch_run_pending(job, hm);     /* 线程池未运行 */
+    }
+
+    batch_reply(c, job);
+    batch_free(job);
+}
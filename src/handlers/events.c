@@ -0,0 +1,332 @@
+/**
+ * @file events.c
+ * @brief 服务器推送事件 (SSE) 实现
+ *
+ * 订阅连接在处理函数返回后保持 is_resp，mongoose 不再解析该连接上的请求，
+ * 之后只由本模块写入事件。订阅的主题掩码记录在 c->data 开头。
+ * 采样方式与工作线程相同：用只含发送缓冲的影子连接执行路由处理函数，
+ * 取出 200 响应的响应体作为事件数据。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <glib.h>
+#include "events.h"
+#include "router.h"
+#include "http_utils.h"
+
+/* 主题：每个主题对应一个同步返回的 GET 路由 */
+typedef struct {
+    const char *name;
+    const char *uri;
+    unsigned int interval;      /* 采样周期（秒） */
+    guint timer_id;             /* 周期采样定时器，无订阅者时停止 */
+    guint idle_id;              /* 待执行的立即采样 */
+    char *last;                 /* 最近一次的响应体 */
+} EventTopic;
+
+static EventTopic g_topics[] = {
+    { "sysinfo",    "/api/info",            30 },
+    { "signal",     "/api/current_band",    10 },
+    { "cells",      "/api/cells",           5 },
+    { "traffic",    "/api/get/Total",       5 },
+    { "battery",    "/api/charge/config",   30 },
+    { "sms",        "/api/sms/state",       30 },   /* 收发短信时由 sms 模块立即触发 */
+};
+
+#define EVENT_TOPIC_COUNT ((int)(sizeof(g_topics) / sizeof(g_topics[0])))
+#define EVENT_TOPIC_ALL   ((1u << EVENT_TOPIC_COUNT) - 1)
+
+/* 订阅连接标记，存放在 c->data 开头 */
+#define EVENTS_MAGIC 0x45565453u    /* "EVTS" */
+
+typedef struct {
+    uint32_t magic;
+    uint32_t topics;            /* 订阅的主题位掩码 */
+} EventSubscriber;
+
+static struct mg_mgr *g_events_mgr = NULL;
+static guint g_heartbeat_id = 0;
+
+/*============================================================================
+ * 内部函数
+ *============================================================================*/
+
+static EventSubscriber *event_subscriber(struct mg_connection *c) {
+    EventSubscriber *sub = (EventSubscriber *)c->data;
+    if (sub->magic != EVENTS_MAGIC || c->is_closing || c->is_draining) {
+        return NULL;
+    }
+    return sub;
+}
+
+/* 订阅了任一掩码内主题的连接数 */
+static int event_subscriber_count(uint32_t mask) {
+    int n = 0;
+    if (!g_events_mgr) return 0;
+    for (struct mg_connection *c = g_events_mgr->conns; c != NULL; c = c->next) {
+        EventSubscriber *sub = event_subscriber(c);
+        if (sub && (sub->topics & mask)) n++;
+    }
+    return n;
+}
+
+/* 写入一条事件，多行数据按 SSE 规则拆成多个 data: 行 */
+static void event_send(struct mg_connection *c, const char *name, const char *data) {
+    if (c->send.len > EVENTS_MAX_BACKLOG) {
+        printf("[EVENTS] 订阅连接 %lu 积压过多，断开\n", c->id);
+        c->is_closing = 1;
+        return;
+    }
+
+    mg_printf(c, "event: %s\n", name);
+    const char *p = data;
+    for (;;) {
+        const char *nl = strchr(p, '\n');
+        size_t len = nl ? (size_t)(nl - p) : strlen(p);
+        if (len > 0 && p[len - 1] == '\r') len--;
+        mg_printf(c, "data: %.*s\n", (int)len, p);
+        if (!nl || nl[1] == '\0') break;
+        p = nl + 1;
+    }
+    mg_send(c, "\n", 1);
+}
+
+/**
+ * 在影子连接上执行主题路由，返回 200 响应体（g_free 释放），失败返回NULL
+ */
+static char *event_sample(const EventTopic *topic) {
+    RouteMatch match;
+    struct mg_connection shadow;
+    struct mg_http_message hm, resp;
+    char *body = NULL;
+
+    if (router_match(mg_str(topic->uri), mg_str("GET"), &match) != 0) {
+        return NULL;
+    }
+
+    memset(&shadow, 0, sizeof(shadow));
+    shadow.is_accepted = 1;
+    shadow.send.align = MG_IO_SIZE;
+
+    memset(&hm, 0, sizeof(hm));
+    hm.method = mg_str("GET");
+    hm.uri = mg_str(topic->uri);
+    hm.proto = mg_str("HTTP/1.1");
+
+    match.route->handler(&shadow, &hm);
+
+    /* 只接受带 Content-Length 的完整 200 响应 */
+    if (shadow.send.len > 0 &&
+        mg_http_parse((const char *)shadow.send.buf, shadow.send.len, &resp) > 0 &&
+        mg_http_status(&resp) == 200 &&
+        mg_http_get_header(&resp, "Content-Length") != NULL) {
+        body = g_strndup(resp.body.buf, resp.body.len);
+    }
+
+    mg_iobuf_free(&shadow.send);
+    return body;
+}
+
+/* 采样一次，值变化时推送给该主题的所有订阅者 */
+static void event_topic_refresh(EventTopic *topic) {
+    uint32_t bit = 1u << (topic - g_topics);
+    char *body = event_sample(topic);
+
+    if (!body) {
+        return;
+    }
+    if (topic->last && strcmp(topic->last, body) == 0) {
+        g_free(body);
+        return;
+    }
+    g_free(topic->last);
+    topic->last = body;
+
+    for (struct mg_connection *c = g_events_mgr->conns; c != NULL; c = c->next) {
+        EventSubscriber *sub = event_subscriber(c);
+        if (sub && (sub->topics & bit)) {
+            event_send(c, topic->name, topic->last);
+        }
+    }
+}
+
+/* 停止无订阅者主题的采样，丢弃旧值以免新订阅者收到过期数据 */
+static int event_topic_idle(EventTopic *topic) {
+    if (event_subscriber_count(1u << (topic - g_topics)) > 0) {
+        return 0;
+    }
+    g_free(topic->last);
+    topic->last = NULL;
+    topic->timer_id = 0;
+    return 1;
+}
+
+static gboolean event_topic_timer_cb(gpointer user_data) {
+    EventTopic *topic = (EventTopic *)user_data;
+
+    if (event_topic_idle(topic)) {
+        return G_SOURCE_REMOVE;
+    }
+    event_topic_refresh(topic);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean event_topic_idle_cb(gpointer user_data) {
+    EventTopic *topic = (EventTopic *)user_data;
+
+    topic->idle_id = 0;
+    if (topic->timer_id != 0) {
+        event_topic_refresh(topic);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+/* 在下一次主循环迭代中采样（合并同一轮内的多次触发） */
+static void event_topic_schedule(EventTopic *topic) {
+    if (topic->idle_id == 0) {
+        topic->idle_id = g_idle_add(event_topic_idle_cb, topic);
+    }
+}
+
+static gboolean event_heartbeat_cb(gpointer user_data) {
+    (void)user_data;
+
+    if (event_subscriber_count(EVENT_TOPIC_ALL) == 0) {
+        g_heartbeat_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+    for (struct mg_connection *c = g_events_mgr->conns; c != NULL; c = c->next) {
+        if (event_subscriber(c)) {
+            mg_printf(c, ": ping\n\n");
+        }
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+/**
+ * 解析 topics 参数（逗号分隔），缺省为全部主题
+ * @return 主题掩码，含未知主题时返回0
+ */
+static uint32_t event_parse_topics(struct mg_http_message *hm) {
+    char buf[128];
+    uint32_t mask = 0;
+
+    int n = mg_http_get_var(&hm->query, "topics", buf, sizeof(buf));
+    if (n == 0 || n == -1 || n == -4) {
+        return EVENT_TOPIC_ALL;     /* 无查询串、无该参数或为空 */
+    }
+    if (n < 0) {
+        return 0;                   /* 解码失败或超长 */
+    }
+
+    struct mg_str s = mg_str_n(buf, (size_t)n), item;
+    while (mg_span(s, &item, &s, ',')) {
+        int i;
+        if (item.len == 0) continue;
+        for (i = 0; i < EVENT_TOPIC_COUNT; i++) {
+            if (mg_strcmp(item, mg_str(g_topics[i].name)) == 0) break;
+        }
+        if (i == EVENT_TOPIC_COUNT) {
+            return 0;
+        }
+        mask |= 1u << i;
+    }
+    return mask;
+}
+
+/*============================================================================
+ * 公共接口
+ *============================================================================*/
+
+void events_init(struct mg_mgr *mgr) {
+    g_events_mgr = mgr;
+}
+
+void events_deinit(void) {
+    for (int i = 0; i < EVENT_TOPIC_COUNT; i++) {
+        EventTopic *topic = &g_topics[i];
+        if (topic->timer_id) g_source_remove(topic->timer_id);
+        if (topic->idle_id) g_source_remove(topic->idle_id);
+        topic->timer_id = topic->idle_id = 0;
+        g_free(topic->last);
+        topic->last = NULL;
+    }
+    if (g_heartbeat_id) {
+        g_source_remove(g_heartbeat_id);
+        g_heartbeat_id = 0;
+    }
+    g_events_mgr = NULL;
+}
+
+void events_invalidate(const char *prefixes) {
+    if (!g_events_mgr || !prefixes) {
+        return;
+    }
+
+    const char *p = prefixes;
+    while (*p) {
+        while (*p == ' ') p++;
+        const char *start = p;
+        while (*p && *p != ' ') p++;
+        size_t len = (size_t)(p - start);
+        if (len == 0) continue;
+
+        for (int i = 0; i < EVENT_TOPIC_COUNT; i++) {
+            if (g_topics[i].timer_id != 0 && strncmp(g_topics[i].uri, start, len) == 0) {
+                event_topic_schedule(&g_topics[i]);
+            }
+        }
+    }
+}
+
+void handle_events(struct mg_connection *c, struct mg_http_message *hm) {
+    HTTP_CHECK_GET(c, hm);
+
+    if (!g_events_mgr) {
+        HTTP_ERROR(c, 503, "事件推送未启动");
+        return;
+    }
+
+    uint32_t mask = event_parse_topics(hm);
+    if (mask == 0) {
+        HTTP_ERROR(c, 400, "未知的订阅主题");
+        return;
+    }
+
+    /* 不调用 mg_http_reply，连接保持在响应中，直到客户端断开 */
+    mg_printf(c,
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/event-stream\r\n"
+        "Cache-Control: no-cache\r\n"
+        "X-Accel-Buffering: no\r\n"
+        "Access-Control-Allow-Origin: *\r\n"
+        "\r\n"
+        "retry: %d\n\n", EVENTS_RETRY_MS);
+
+    EventSubscriber *sub = (EventSubscriber *)c->data;
+    sub->magic = EVENTS_MAGIC;
+    sub->topics = mask;
+
+    for (int i = 0; i < EVENT_TOPIC_COUNT; i++) {
+        EventTopic *topic = &g_topics[i];
+        if (!(mask & (1u << i))) continue;
+
+        if (topic->timer_id == 0) {
+            topic->timer_id = g_timeout_add_seconds(topic->interval, event_topic_timer_cb, topic);
+        }
+        if (topic->last) {
+            event_send(c, topic->name, topic->last);
+        } else {
+            event_topic_schedule(topic);
+        }
+    }
+
+    if (g_heartbeat_id == 0) {
+        g_heartbeat_id = g_timeout_add_seconds(EVENTS_HEARTBEAT_SEC, event_heartbeat_cb, NULL);
+    }
+
+    printf("[EVENTS] 连接 %lu 订阅主题 0x%x\n", c->id, mask);
+}
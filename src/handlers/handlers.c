@@ -18,6 +18,9 @@
 #include "modem.h"
 #include "http_utils.h"
 #include "apn.h"
+#include "http_server.h"
+#include "json_writer.h"
+#include "metrics.h"
 
 
 /* GET /api/info - 获取系统信息 */
@@ -99,6 +102,27 @@ static void json_escape_string(const char *src, char *dst, size_t dst_size) {
     dst[j] = '\0';
 }
 
+/**
+ * 复制路由通配段参数（如 /api/sms/:id 中的ID）
+ * @param decode 非0则进行URL解码（支持中文名称）
+ * @return 参数长度，0表示为空
+ */
+static size_t route_param_copy(char *buf, size_t size, int decode) {
+    struct mg_str param = http_route_param();
+
+    buf[0] = '\0';
+    if (param.len == 0 || param.len >= size) {
+        return 0;
+    }
+    if (decode) {
+        int n = mg_url_decode(param.buf, param.len, buf, size, 0);
+        return n > 0 ? (size_t)n : 0;
+    }
+    memcpy(buf, param.buf, param.len);
+    buf[param.len] = '\0';
+    return param.len;
+}
+
 /* POST /api/at - 执行 AT 命令 */
 void handle_execute_at(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_POST(c, hm);
@@ -289,6 +313,17 @@ void handle_clear_cache(struct mg_connection *c, struct mg_http_message *hm) {
     }
 }
 
+/* GET /metrics - 运行指标（文本暴露格式） */
+void handle_metrics(struct mg_connection *c, struct mg_http_message *hm) {
+    HTTP_CHECK_GET(c, hm);
+
+    GString *out = g_string_sized_new(16384);
+    metrics_render(out);
+    mg_http_reply(c, 200, "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                  "Cache-Control: no-store\r\n", "%s", out->str);
+    g_string_free(out, TRUE);
+}
+
 
 /* 解析 AT 命令返回的小区数据 (Go: parseCellToVec) */
 /* 返回解析后的行数，data 是二维数组 [行][列] */
@@ -426,7 +461,7 @@ void handle_get_current_band(struct mg_connection *c, struct mg_http_message *hm
 
     if (is_5g) {
         /* 5G 网络: AT+SPENGMD=0,14,1 */
-        if (execute_at("AT+SPENGMD=0,14,1", &result) == 0 && result && strlen(result) > 100) {
+        if (execute_at_query(AT_QUERY_NR_SERVING, &result) == 0 && result && strlen(result) > 100) {
             char data[64][16][32] = {{{0}}};
             int rows = parse_cell_to_vec(result, data);
             
@@ -457,7 +492,7 @@ void handle_get_current_band(struct mg_connection *c, struct mg_http_message *hm
         if (result) { g_free(result); result = NULL; }
     } else {
         /* 4G 网络: AT+SPENGMD=0,6,0 */
-        if (execute_at("AT+SPENGMD=0,6,0", &result) == 0 && result && strlen(result) > 100) {
+        if (execute_at_query(AT_QUERY_LTE_SERVING, &result) == 0 && result && strlen(result) > 100) {
             char data[64][16][32] = {{{0}}};
             int rows = parse_cell_to_vec(result, data);
             
@@ -506,42 +541,159 @@ void handle_get_current_band(struct mg_connection *c, struct mg_http_message *hm
 
 /* ==================== 短信 API ==================== */
 #include "sms.h"
+#include "database.h"
+
+#define SMS_LIST_MAX 100
+#define SMS_SENT_LIST_MAX 150
+
+/* 分页查询单页上限 */
+#define SMS_LIST_LIMIT_MAX 200
+
+/*
+ * 列表分页参数：limit=条数，before_id=只取更早的（向前翻页），since_id=只取更新的（增量同步）。
+ * 带任一参数时响应为 {"messages":[...],"max_id":N,"has_more":bool}，
+ * max_id 是本页最大的ID（无结果时为 since_id），作为下一次的 since_id；
+ * has_more 表示区间内还有更早的记录，增量同步时为 true 说明新记录超过一页，应重新拉取。
+ * 不带参数时保持原来的数组响应。
+ */
+typedef struct {
+    int limit;
+    int before_id;
+    int since_id;
+    int paged;
+} SmsListQuery;
+
+/* 非负整数查询参数，无参数时不修改 out */
+static int sms_query_int(struct mg_http_message *hm, const char *name, int *out, int *present) {
+    char buf[16], *end = NULL;
+    int n = mg_http_get_var(&hm->query, name, buf, sizeof(buf));
+
+    if (n == 0 || n == -1 || n == -4) {
+        return 0;
+    }
+    long v = n > 0 ? strtol(buf, &end, 10) : -1;
+    if (v < 0 || v > INT_MAX || !end || *end != '\0') {
+        return -1;
+    }
+    *out = (int)v;
+    *present = 1;
+    return 0;
+}
+
+/**
+ * 解析列表分页参数
+ * @return 0成功, -1参数无效
+ */
+static int sms_list_parse(struct mg_http_message *hm, int default_limit, SmsListQuery *q) {
+    memset(q, 0, sizeof(*q));
+    q->limit = default_limit;
+
+    if (sms_query_int(hm, "limit", &q->limit, &q->paged) != 0 ||
+        sms_query_int(hm, "before_id", &q->before_id, &q->paged) != 0 ||
+        sms_query_int(hm, "since_id", &q->since_id, &q->paged) != 0 ||
+        q->limit < 1 || q->limit > SMS_LIST_LIMIT_MAX) {
+        return -1;
+    }
+    return 0;
+}
+
+/* 列表开头：分页响应是对象 */
+static void sms_list_begin(JsonWriter *w, const SmsListQuery *q) {
+    if (q->paged) {
+        json_begin_object(w);
+        json_key(w, "messages");
+    }
+    json_begin_array(w);
+}
+
+static void sms_list_end(JsonWriter *w, const SmsListQuery *q, int max_id, int has_more) {
+    json_end_array(w);
+    if (q->paged) {
+        json_kv_int(w, "max_id", max_id > q->since_id ? max_id : q->since_id);
+        json_kv_bool(w, "has_more", has_more);
+        json_end_object(w);
+    }
+}
+
+/* 收件箱列表异步任务，查询完成后作为流式输出的状态 */
+typedef struct {
+    unsigned long conn_id;
+    SmsListQuery query;
+    int count;
+    int next;                   /* 下一条要输出的记录 */
+    SmsMessage messages[];      /* query.limit + 1 条，多取的一条用于判断 has_more */
+} SmsListJob;
+
+/* 流式输出收件箱JSON：每次一条 */
+static int sms_list_fill(JsonWriter *w, void *arg) {
+    SmsListJob *job = (SmsListJob *)arg;
+    const SmsListQuery *q = &job->query;
+    int count = job->count > q->limit ? q->limit : job->count;
+
+    if (job->next == 0) {
+        sms_list_begin(w, q);
+    }
+    if (job->next < count) {
+        const SmsMessage *m = &job->messages[job->next++];
+        char time_str[32];
+        struct tm tm_info;
+        localtime_r(&m->timestamp, &tm_info);
+        strftime(time_str, sizeof(time_str), "%Y-%m-%dT%H:%M:%S", &tm_info);
+
+        json_begin_object(w);
+        json_kv_int(w, "id", m->id);
+        json_kv_string(w, "sender", m->sender);
+        json_kv_string(w, "content", m->content);
+        json_kv_string(w, "timestamp", time_str);
+        json_kv_bool(w, "read", m->is_read);
+        json_end_object(w);
+        return 0;
+    }
+
+    sms_list_end(w, q, count > 0 ? job->messages[0].id : 0, job->count > q->limit);
+    return 1;
+}
+
+/* DB工作线程：读取收件箱 */
+static void sms_list_job(void *arg) {
+    SmsListJob *job = (SmsListJob *)arg;
+    job->count = sms_get_list_range(job->messages, job->query.limit + 1,
+                                    job->query.before_id, job->query.since_id);
+}
 
-/* GET /api/sms - 获取短信列表 */
+/* 主线程：回复请求（连接可能已关闭），任务交给流式输出释放 */
+static void sms_list_done(void *arg) {
+    SmsListJob *job = (SmsListJob *)arg;
+    struct mg_connection *c = http_server_find_conn(job->conn_id);
+    if (!c) {
+        free(job);
+    } else if (job->count < 0) {
+        HTTP_ERROR(c, 500, "获取短信列表失败");
+        free(job);
+    } else {
+        json_writer_stream(c, HTTP_CORS_HEADERS, sms_list_fill, free, job);
+    }
+}
+
+/* GET /api/sms - 获取短信列表（?limit=&before_id=&since_id=） */
 void handle_sms_list(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_GET(c, hm);
 
-    SmsMessage messages[100];
-    int count = sms_get_list(messages, 100);
-    
-    if (count < 0) {
-        HTTP_ERROR(c, 500, "获取短信列表失败");
+    SmsListQuery query;
+    if (sms_list_parse(hm, SMS_LIST_MAX, &query) != 0) {
+        HTTP_ERROR(c, 400, "无效的分页参数");
         return;
     }
 
-    /* 构建JSON数组 */
-    char json[65536];
-    int offset = 0;
-    offset += snprintf(json + offset, sizeof(json) - offset, "[");
-    
-    for (int i = 0; i < count; i++) {
-        char escaped_content[2048];
-        json_escape_string(messages[i].content, escaped_content, sizeof(escaped_content));
-        
-        char time_str[32];
-        struct tm *tm_info = localtime(&messages[i].timestamp);
-        strftime(time_str, sizeof(time_str), "%Y-%m-%dT%H:%M:%S", tm_info);
-        
-        offset += snprintf(json + offset, sizeof(json) - offset,
-            "%s{\"id\":%d,\"sender\":\"%s\",\"content\":\"%s\",\"timestamp\":\"%s\",\"read\":%s}",
-            i > 0 ? "," : "",
-            messages[i].id, messages[i].sender, escaped_content, time_str,
-            messages[i].is_read ? "true" : "false");
+    SmsListJob *job = (SmsListJob *)calloc(1, sizeof(SmsListJob) +
+                                           (size_t)(query.limit + 1) * sizeof(SmsMessage));
+    if (!job) {
+        HTTP_ERROR(c, 500, "内存不足");
+        return;
     }
-    
-    offset += snprintf(json + offset, sizeof(json) - offset, "]");
-
-    HTTP_OK(c, json);
+    job->conn_id = c->id;
+    job->query = query;
+    db_async_run_or_submit(sms_list_job, sms_list_done, job);
 }
 
 /* POST /api/sms/send - 发送短信 */
@@ -577,13 +729,8 @@ void handle_sms_send(struct mg_connection *c, struct mg_http_message *hm) {
 void handle_sms_delete(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_DELETE(c, hm);
 
-    int id = 0;
-    const char *uri = hm->uri.buf;
-    const char *id_start = strstr(uri, "/api/sms/");
-    if (id_start) {
-        id_start += 9;
-        id = atoi(id_start);
-    }
+    char id_str[16];
+    int id = route_param_copy(id_str, sizeof(id_str), 0) ? atoi(id_str) : 0;
 
     if (id <= 0) {
         HTTP_ERROR(c, 400, "无效的短信ID");
@@ -597,6 +744,21 @@ void handle_sms_delete(struct mg_connection *c, struct mg_http_message *hm) {
     }
 }
 
+/* GET /api/sms/state - 收件箱/发件箱概况（变化时客户端再拉取列表） */
+void handle_sms_state(struct mg_connection *c, struct mg_http_message *hm) {
+    HTTP_CHECK_GET(c, hm);
+
+    SmsState state;
+    if (sms_get_state(&state) != 0) {
+        HTTP_ERROR(c, 500, "获取短信状态失败");
+        return;
+    }
+
+    mg_http_reply(c, 200, HTTP_CORS_HEADERS,
+        "{\"total\":%d,\"latest_id\":%d,\"sent_total\":%d,\"sent_latest_id\":%d}",
+        state.total, state.latest_id, state.sent_total, state.sent_latest_id);
+}
+
 /* GET /api/sms/webhook - 获取Webhook配置 */
 void handle_sms_webhook_get(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_GET(c, hm);
@@ -705,49 +867,80 @@ void handle_sms_webhook_test(struct mg_connection *c, struct mg_http_message *hm
     }
 }
 
-/* GET /api/sms/sent - 获取发送记录列表 */
+/* 发件箱列表异步任务，查询完成后作为流式输出的状态 */
+typedef struct {
+    unsigned long conn_id;
+    SmsListQuery query;
+    int count;
+    int next;                   /* 下一条要输出的记录 */
+    SentSmsMessage messages[];  /* query.limit + 1 条 */
+} SmsSentListJob;
+
+/* 流式输出发件箱JSON：每次一条 */
+static int sms_sent_list_fill(JsonWriter *w, void *arg) {
+    SmsSentListJob *job = (SmsSentListJob *)arg;
+    const SmsListQuery *q = &job->query;
+    int count = job->count > q->limit ? q->limit : job->count;
+
+    if (job->next == 0) {
+        sms_list_begin(w, q);
+    }
+    if (job->next < count) {
+        const SentSmsMessage *m = &job->messages[job->next++];
+        json_begin_object(w);
+        json_kv_int(w, "id", m->id);
+        json_kv_string(w, "recipient", m->recipient);
+        json_kv_string(w, "content", m->content);
+        json_kv_int(w, "timestamp", (long long)m->timestamp);
+        json_kv_string(w, "status", m->status);
+        json_end_object(w);
+        return 0;
+    }
+
+    sms_list_end(w, q, count > 0 ? job->messages[0].id : 0, job->count > q->limit);
+    return 1;
+}
+
+/* DB工作线程：读取发件箱 */
+static void sms_sent_list_job(void *arg) {
+    SmsSentListJob *job = (SmsSentListJob *)arg;
+    job->count = sms_get_sent_list_range(job->messages, job->query.limit + 1,
+                                         job->query.before_id, job->query.since_id);
+}
+
+/* 主线程：回复请求（连接可能已关闭），任务交给流式输出释放 */
+static void sms_sent_list_done(void *arg) {
+    SmsSentListJob *job = (SmsSentListJob *)arg;
+    struct mg_connection *c = http_server_find_conn(job->conn_id);
+    if (!c) {
+        free(job);
+    } else if (job->count < 0) {
+        HTTP_ERROR(c, 500, "获取发送记录失败");
+        free(job);
+    } else {
+        json_writer_stream(c, HTTP_CORS_HEADERS, sms_sent_list_fill, free, job);
+    }
+}
+
+/* GET /api/sms/sent - 获取发送记录列表（分页参数同 /api/sms） */
 void handle_sms_sent_list(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_GET(c, hm);
 
-    SentSmsMessage messages[150];
-    int count = sms_get_sent_list(messages, 150);
-    
-    if (count < 0) {
-        HTTP_ERROR(c, 500, "获取发送记录失败");
+    SmsListQuery query;
+    if (sms_list_parse(hm, SMS_SENT_LIST_MAX, &query) != 0) {
+        HTTP_ERROR(c, 400, "无效的分页参数");
         return;
     }
 
-    char json[65536];
-    int offset = snprintf(json, sizeof(json), "[");
-    
-    for (int i = 0; i < count; i++) {
-        char escaped_content[2048];
-        size_t j = 0;
-        for (size_t k = 0; messages[i].content[k] && j < sizeof(escaped_content) - 2; k++) {
-            char ch = messages[i].content[k];
-            if (ch == '"' || ch == '\\') {
-                escaped_content[j++] = '\\';
-            } else if (ch == '\n') {
-                escaped_content[j++] = '\\';
-                ch = 'n';
-            } else if (ch == '\r') {
-                escaped_content[j++] = '\\';
-                ch = 'r';
-            }
-            escaped_content[j++] = ch;
-        }
-        escaped_content[j] = '\0';
-        
-        offset += snprintf(json + offset, sizeof(json) - offset,
-            "%s{\"id\":%d,\"recipient\":\"%s\",\"content\":\"%s\",\"timestamp\":%ld,\"status\":\"%s\"}",
-            i > 0 ? "," : "",
-            messages[i].id, messages[i].recipient, escaped_content,
-            (long)messages[i].timestamp, messages[i].status);
+    SmsSentListJob *job = (SmsSentListJob *)calloc(1, sizeof(SmsSentListJob) +
+                                                   (size_t)(query.limit + 1) * sizeof(SentSmsMessage));
+    if (!job) {
+        HTTP_ERROR(c, 500, "内存不足");
+        return;
     }
-    
-    snprintf(json + offset, sizeof(json) - offset, "]");
-    
-    HTTP_OK(c, json);
+    job->conn_id = c->id;
+    job->query = query;
+    db_async_run_or_submit(sms_sent_list_job, sms_sent_list_done, job);
 }
 
 /* GET /api/sms/config - 获取短信配置 */
@@ -798,13 +991,8 @@ void handle_sms_config_save(struct mg_connection *c, struct mg_http_message *hm)
 void handle_sms_sent_delete(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_DELETE(c, hm);
 
-    int id = 0;
-    const char *uri = hm->uri.buf;
-    const char *id_start = strstr(uri, "/api/sms/sent/");
-    if (id_start) {
-        id_start += 14;
-        id = atoi(id_start);
-    }
+    char id_str[16];
+    int id = route_param_copy(id_str, sizeof(id_str), 0) ? atoi(id_str) : 0;
 
     if (id <= 0) {
         HTTP_ERROR(c, 400, "无效的ID");
@@ -861,37 +1049,6 @@ void handle_update_version(struct mg_connection *c, struct mg_http_message *hm)
     HTTP_OK(c, json);
 }
 
-/* POST /api/update/upload - 上传更新包 */
-void handle_update_upload(struct mg_connection *c, struct mg_http_message *hm) {
-    HTTP_CHECK_POST(c, hm);
-
-    struct mg_http_part part;
-    size_t ofs = 0;
-    
-    while ((ofs = mg_http_next_multipart(hm->body, ofs, &part)) > 0) {
-        if (part.filename.len > 0) {
-            update_cleanup();
-            
-            FILE *fp = fopen(UPDATE_ZIP_PATH, "wb");
-            if (!fp) {
-                HTTP_ERROR(c, 500, "无法创建文件");
-                return;
-            }
-            
-            fwrite(part.body.buf, 1, part.body.len, fp);
-            fclose(fp);
-            
-            printf("更新包上传成功: %lu bytes\n", (unsigned long)part.body.len);
-            char json[128];
-            snprintf(json, sizeof(json), "{\"status\":\"success\",\"message\":\"上传成功\",\"size\":%lu}", (unsigned long)part.body.len);
-            HTTP_OK(c, json);
-            return;
-        }
-    }
-    
-    HTTP_ERROR(c, 400, "未找到上传文件");
-}
-
 /* POST /api/update/download - 从URL下载更新包 */
 void handle_update_download(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_POST(c, hm);
@@ -1305,24 +1462,50 @@ void handle_shell_execute(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_OK(c, response);
 }
 
+/* 插件列表流式输出状态 */
+typedef struct {
+    PluginList list;
+    int started;
+} PluginListStream;
+
+/* 流式输出插件列表：每次一个插件 */
+static int plugin_list_fill(JsonWriter *w, void *arg) {
+    PluginListStream *st = (PluginListStream *)arg;
+
+    if (!st->started) {
+        st->started = 1;
+        json_begin_object(w);
+        json_kv_int(w, "Code", 0);
+        json_kv_string(w, "Error", "");
+        json_key(w, "Data");
+        json_begin_array(w);
+    }
+    if (plugin_list_next(&st->list, w)) {
+        return 0;
+    }
+    json_end_array(w);
+    json_kv_int(w, "Count", st->list.count);
+    json_end_object(w);
+    return 1;
+}
+
+static void plugin_list_stream_free(void *arg) {
+    PluginListStream *st = (PluginListStream *)arg;
+    plugin_list_close(&st->list);
+    free(st);
+}
+
 /* GET /api/plugins - 获取插件列表 */
 void handle_plugin_list(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_GET(c, hm);
 
-    char *json = malloc(512 * 1024);  /* 512KB缓冲区 */
-    if (!json) {
-        HTTP_ERROR(c, 500, "内存分配失败");
+    PluginListStream *st = (PluginListStream *)calloc(1, sizeof(PluginListStream));
+    if (!st) {
+        HTTP_ERROR(c, 500, "内存不足");
         return;
     }
-
-    int count = get_plugin_list(json, 512 * 1024);
-    
-    char response[512 * 1024 + 128];
-    snprintf(response, sizeof(response),
-        "{\"Code\":0,\"Error\":\"\",\"Data\":%s,\"Count\":%d}", json, count);
-    
-    HTTP_OK(c, response);
-    free(json);
+    plugin_list_open(&st->list);
+    json_writer_stream(c, HTTP_CORS_HEADERS, plugin_list_fill, plugin_list_stream_free, st);
 }
 
 /* POST /api/plugins - 上传插件 */
@@ -1360,33 +1543,13 @@ void handle_plugin_upload(struct mg_connection *c, struct mg_http_message *hm) {
 void handle_plugin_delete(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_DELETE(c, hm);
 
-    /* 从URI中提取插件名 */
-    const char *uri = hm->uri.buf;
-    const char *name_start = strstr(uri, "/api/plugins/");
-    if (!name_start) {
-        HTTP_ERROR(c, 400, "无效的请求路径");
-        return;
-    }
-    name_start += 13;  /* 跳过 "/api/plugins/" */
-
-    /* 提取名称直到URI结束或遇到? */
-    char encoded_name[256] = {0};
-    int i = 0;
-    while (name_start[i] && name_start[i] != '?' && name_start[i] != ' ' && i < 255) {
-        encoded_name[i] = name_start[i];
-        i++;
-    }
-    encoded_name[i] = '\0';
-
-    if (strlen(encoded_name) == 0) {
+    /* 从URI中提取插件名（URL解码支持中文名称） */
+    char name[256] = {0};
+    if (route_param_copy(name, sizeof(name), 1) == 0) {
         HTTP_ERROR(c, 400, "插件名称不能为空");
         return;
     }
 
-    /* URL解码支持中文名称 */
-    char name[256] = {0};
-    mg_url_decode(encoded_name, strlen(encoded_name), name, sizeof(name), 0);
-
     if (delete_plugin(name) == 0) {
         HTTP_OK(c, "{\"Code\":0,\"Error\":\"\",\"Data\":\"插件删除成功\"}");
     } else {
@@ -1409,79 +1572,98 @@ void handle_plugin_delete_all(struct mg_connection *c, struct mg_http_message *h
 
 #define SCRIPTS_DIR "/home/root/6677/Plugins/scripts"
 
-/* GET /api/scripts - 获取脚本列表 */
-void handle_script_list(struct mg_connection *c, struct mg_http_message *hm) {
-    HTTP_CHECK_GET(c, hm);
+/* 脚本列表流式输出状态 */
+typedef struct {
+    DIR *dir;
+    int count;
+    int started;
+} ScriptListStream;
 
-    char *json = malloc(256 * 1024);
-    if (!json) {
-        HTTP_ERROR(c, 500, "内存分配失败");
-        return;
+/* 写入下一个脚本（内容逐块读取并转义输出） */
+static int script_list_next(ScriptListStream *st, JsonWriter *w) {
+    struct dirent *entry;
+
+    while (st->dir && (entry = readdir(st->dir)) != NULL) {
+        if (entry->d_type != DT_REG || !strstr(entry->d_name, ".sh")) {
+            continue;
+        }
+        char filepath[512];
+        snprintf(filepath, sizeof(filepath), "%s/%s", SCRIPTS_DIR, entry->d_name);
+
+        struct stat st_file;
+        if (stat(filepath, &st_file) != 0) {
+            continue;
+        }
+        json_begin_object(w);
+        json_kv_string(w, "name", entry->d_name);
+        json_kv_int(w, "size", (long long)st_file.st_size);
+        json_kv_int(w, "mtime", (long long)st_file.st_mtime);
+
+        json_key(w, "content");
+        json_string_begin(w);
+        FILE *f = fopen(filepath, "r");
+        if (f) {
+            char block[4096];
+            size_t n;
+            while ((n = fread(block, 1, sizeof(block), f)) > 0) {
+                json_string_append(w, block, n);
+            }
+            fclose(f);
+        }
+        json_string_end(w);
+
+        json_end_object(w);
+        st->count++;
+        return 1;
     }
+    return 0;
+}
 
-    strcpy(json, "[");
-    int first = 1;
-    int count = 0;
+/* 流式输出脚本列表：每次一个脚本 */
+static int script_list_fill(JsonWriter *w, void *arg) {
+    ScriptListStream *st = (ScriptListStream *)arg;
+
+    if (!st->started) {
+        st->started = 1;
+        json_begin_object(w);
+        json_kv_int(w, "Code", 0);
+        json_kv_string(w, "Error", "");
+        json_key(w, "Data");
+        json_begin_array(w);
+    }
+    if (script_list_next(st, w)) {
+        return 0;
+    }
+    json_end_array(w);
+    json_kv_int(w, "Count", st->count);
+    json_end_object(w);
+    return 1;
+}
+
+static void script_list_stream_free(void *arg) {
+    ScriptListStream *st = (ScriptListStream *)arg;
+    if (st->dir) {
+        closedir(st->dir);
+    }
+    free(st);
+}
+
+/* GET /api/scripts - 获取脚本列表 */
+void handle_script_list(struct mg_connection *c, struct mg_http_message *hm) {
+    HTTP_CHECK_GET(c, hm);
 
     /* 确保目录存在 */
     char mkdir_cmd[512];
     snprintf(mkdir_cmd, sizeof(mkdir_cmd), "mkdir -p %s", SCRIPTS_DIR);
     system(mkdir_cmd);
 
-    DIR *dir = opendir(SCRIPTS_DIR);
-    if (dir) {
-        struct dirent *entry;
-        while ((entry = readdir(dir)) != NULL) {
-            if (entry->d_type == DT_REG && strstr(entry->d_name, ".sh")) {
-                char filepath[512];
-                snprintf(filepath, sizeof(filepath), "%s/%s", SCRIPTS_DIR, entry->d_name);
-                
-                struct stat st;
-                if (stat(filepath, &st) == 0) {
-                    /* 读取脚本内容 */
-                    FILE *f = fopen(filepath, "r");
-                    char content[32768] = {0};
-                    if (f) {
-                        fread(content, 1, sizeof(content) - 1, f);
-                        fclose(f);
-                    }
-
-                    /* 转义内容 */
-                    char escaped[65536];
-                    size_t j = 0;
-                    for (size_t i = 0; content[i] && j < sizeof(escaped) - 2; i++) {
-                        char ch = content[i];
-                        if (ch == '"' || ch == '\\') { escaped[j++] = '\\'; }
-                        else if (ch == '\n') { escaped[j++] = '\\'; ch = 'n'; }
-                        else if (ch == '\r') { escaped[j++] = '\\'; ch = 'r'; }
-                        else if (ch == '\t') { escaped[j++] = '\\'; ch = 't'; }
-                        if ((unsigned char)ch >= 0x20 || ch == 'n' || ch == 'r' || ch == 't') {
-                            escaped[j++] = ch;
-                        }
-                    }
-                    escaped[j] = '\0';
-
-                    char item[70000];
-                    snprintf(item, sizeof(item),
-                        "%s{\"name\":\"%s\",\"size\":%ld,\"mtime\":%ld,\"content\":\"%s\"}",
-                        first ? "" : ",", entry->d_name, st.st_size, st.st_mtime, escaped);
-                    strcat(json, item);
-                    first = 0;
-                    count++;
-                }
-            }
-        }
-        closedir(dir);
+    ScriptListStream *st = (ScriptListStream *)calloc(1, sizeof(ScriptListStream));
+    if (!st) {
+        HTTP_ERROR(c, 500, "内存不足");
+        return;
     }
-
-    strcat(json, "]");
-
-    char response[256 * 1024 + 128];
-    snprintf(response, sizeof(response),
-        "{\"Code\":0,\"Error\":\"\",\"Data\":%s,\"Count\":%d}", json, count);
-    
-    HTTP_OK(c, response);
-    free(json);
+    st->dir = opendir(SCRIPTS_DIR);
+    json_writer_stream(c, HTTP_CORS_HEADERS, script_list_fill, script_list_stream_free, st);
 }
 
 /* POST /api/scripts - 上传脚本 */
@@ -1537,23 +1719,8 @@ void handle_script_update(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_PUT(c, hm);
 
     /* 从URI中提取脚本名 */
-    const char *uri = hm->uri.buf;
-    const char *name_start = strstr(uri, "/api/scripts/");
-    if (!name_start) {
-        HTTP_ERROR(c, 400, "无效的请求路径");
-        return;
-    }
-    name_start += 13;
-
     char name[256] = {0};
-    int i = 0;
-    while (name_start[i] && name_start[i] != '?' && name_start[i] != ' ' && i < 255) {
-        name[i] = name_start[i];
-        i++;
-    }
-    name[i] = '\0';
-
-    if (strlen(name) == 0) {
+    if (route_param_copy(name, sizeof(name), 0) == 0) {
         HTTP_ERROR(c, 400, "脚本名称不能为空");
         return;
     }
@@ -1583,31 +1750,13 @@ void handle_script_update(struct mg_connection *c, struct mg_http_message *hm) {
 void handle_script_delete(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_DELETE(c, hm);
 
-    const char *uri = hm->uri.buf;
-    const char *name_start = strstr(uri, "/api/scripts/");
-    if (!name_start) {
-        HTTP_ERROR(c, 400, "无效的请求路径");
-        return;
-    }
-    name_start += 13;
-
-    char encoded_name[256] = {0};
-    int i = 0;
-    while (name_start[i] && name_start[i] != '?' && name_start[i] != ' ' && i < 255) {
-        encoded_name[i] = name_start[i];
-        i++;
-    }
-    encoded_name[i] = '\0';
-
-    if (strlen(encoded_name) == 0) {
+    /* URL解码支持中文名称 */
+    char name[256] = {0};
+    if (route_param_copy(name, sizeof(name), 1) == 0) {
         HTTP_ERROR(c, 400, "脚本名称不能为空");
         return;
     }
 
-    /* URL解码支持中文名称 */
-    char name[256] = {0};
-    mg_url_decode(encoded_name, strlen(encoded_name), name, sizeof(name), 0);
-
     char filepath[512];
     snprintf(filepath, sizeof(filepath), "%s/%s", SCRIPTS_DIR, name);
     
@@ -1622,25 +1771,9 @@ void handle_script_delete(struct mg_connection *c, struct mg_http_message *hm) {
 #include "plugin_storage.h"
 
 /* 从URL提取插件名 /api/plugins/storage/:name */
-static int extract_plugin_name_from_url(const char *uri, char *name, size_t size) {
-    const char *prefix = "/api/plugins/storage/";
-    const char *start = strstr(uri, prefix);
-    if (!start) return -1;
-    
-    start += strlen(prefix);
-    char encoded[256] = {0};
-    size_t i = 0;
-    while (start[i] && start[i] != '?' && start[i] != ' ' && i < sizeof(encoded) - 1) {
-        encoded[i] = start[i];
-        i++;
-    }
-    encoded[i] = '\0';
-    
-    if (i == 0) return -1;
-    
+static int extract_plugin_name_from_url(char *name, size_t size) {
     /* URL解码支持中文名称 */
-    mg_url_decode(encoded, strlen(encoded), name, size, 0);
-    return (strlen(name) > 0) ? 0 : -1;
+    return route_param_copy(name, size, 1) > 0 ? 0 : -1;
 }
 
 /* GET /api/plugins/storage/:name - 读取插件存储 */
@@ -1648,7 +1781,7 @@ void handle_plugin_storage_get(struct mg_connection *c, struct mg_http_message *
     HTTP_CHECK_GET(c, hm);
 
     char plugin_name[256] = {0};
-    if (extract_plugin_name_from_url(hm->uri.buf, plugin_name, sizeof(plugin_name)) != 0) {
+    if (extract_plugin_name_from_url(plugin_name, sizeof(plugin_name)) != 0) {
         HTTP_ERROR(c, 400, "无效的插件名称");
         return;
     }
@@ -1670,7 +1803,7 @@ void handle_plugin_storage_set(struct mg_connection *c, struct mg_http_message *
     HTTP_CHECK_POST(c, hm);
 
     char plugin_name[256] = {0};
-    if (extract_plugin_name_from_url(hm->uri.buf, plugin_name, sizeof(plugin_name)) != 0) {
+    if (extract_plugin_name_from_url(plugin_name, sizeof(plugin_name)) != 0) {
         HTTP_ERROR(c, 400, "无效的插件名称");
         return;
     }
@@ -1693,7 +1826,7 @@ void handle_plugin_storage_delete(struct mg_connection *c, struct mg_http_messag
     HTTP_CHECK_DELETE(c, hm);
 
     char plugin_name[256] = {0};
-    if (extract_plugin_name_from_url(hm->uri.buf, plugin_name, sizeof(plugin_name)) != 0) {
+    if (extract_plugin_name_from_url(plugin_name, sizeof(plugin_name)) != 0) {
         HTTP_ERROR(c, 400, "无效的插件名称");
         return;
     }
@@ -1937,37 +2070,30 @@ void handle_apn_templates_list(struct mg_connection *c, struct mg_http_message *
     }
     
     /* 构建JSON响应 */
-    char *response = (char *)malloc(64 * 1024);
-    if (!response) {
-        HTTP_ERROR(c, 500, "内存分配失败");
-        return;
-    }
-    
-    char *p = response;
-    p += sprintf(p, "{\"status\":\"ok\",\"message\":\"\",\"data\":[");
-    
+    JsonWriter w;
+    json_writer_init(&w);
+    json_begin_object(&w);
+    json_kv_string(&w, "status", "ok");
+    json_kv_string(&w, "message", "");
+    json_key(&w, "data");
+    json_begin_array(&w);
+
     for (int i = 0; i < count; i++) {
-        char escaped_name[512];
-        char escaped_apn[512];
-        char escaped_username[512];
-        char escaped_password[512];
-        
-        json_escape_string(templates[i].name, escaped_name, sizeof(escaped_name));
-        json_escape_string(templates[i].apn, escaped_apn, sizeof(escaped_apn));
-        json_escape_string(templates[i].username, escaped_username, sizeof(escaped_username));
-        json_escape_string(templates[i].password, escaped_password, sizeof(escaped_password));
-        
-        p += sprintf(p, "%s{\"id\":%d,\"name\":\"%s\",\"apn\":\"%s\",\"protocol\":\"%s\","
-                     "\"username\":\"%s\",\"password\":\"%s\",\"auth_method\":\"%s\",\"created_at\":%ld}",
-                     i > 0 ? "," : "",
-                     templates[i].id, escaped_name, escaped_apn, templates[i].protocol,
-                     escaped_username, escaped_password, templates[i].auth_method,
-                     (long)templates[i].created_at);
-    }
-    
-    sprintf(p, "]}");
-    HTTP_OK(c, response);
-    free(response);
+        json_begin_object(&w);
+        json_kv_int(&w, "id", templates[i].id);
+        json_kv_string(&w, "name", templates[i].name);
+        json_kv_string(&w, "apn", templates[i].apn);
+        json_kv_string(&w, "protocol", templates[i].protocol);
+        json_kv_string(&w, "username", templates[i].username);
+        json_kv_string(&w, "password", templates[i].password);
+        json_kv_string(&w, "auth_method", templates[i].auth_method);
+        json_kv_int(&w, "created_at", (long long)templates[i].created_at);
+        json_end_object(&w);
+    }
+
+    json_end_array(&w);
+    json_end_object(&w);
+    json_writer_reply(&w, c, 200, HTTP_CORS_HEADERS);
 }
 
 /* POST /api/apn/templates - 创建模板 */
@@ -2012,7 +2138,7 @@ void handle_apn_templates_update(struct mg_connection *c, struct mg_http_message
     
     /* 从URL提取ID */
     char id_str[16] = {0};
-    if (sscanf(hm->uri.buf, "/api/apn/templates/%15s", id_str) != 1) {
+    if (route_param_copy(id_str, sizeof(id_str), 0) == 0) {
         HTTP_ERROR(c, 400, "无效的模板ID");
         return;
     }
@@ -2050,7 +2176,7 @@ void handle_apn_templates_delete(struct mg_connection *c, struct mg_http_message
     
     /* 从URL提取ID */
     char id_str[16] = {0};
-    if (sscanf(hm->uri.buf, "/api/apn/templates/%15s", id_str) != 1) {
+    if (route_param_copy(id_str, sizeof(id_str), 0) == 0) {
         HTTP_ERROR(c, 400, "无效的模板ID");
         return;
     }
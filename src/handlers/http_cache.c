@@ -0,0 +1,282 @@
+/**
+ * @file http_cache.c
+ * @brief GET 响应缓存实现
+ *
+ * 缓存项保存处理函数写出的完整响应报文（状态行+头+正文），
+ * 发送时在状态行之后插入 Cache-Control/Age 头。
+ * 条目很少（HTTP_CACHE_MAX_ENTRIES），淘汰和前缀失效直接遍历哈希表。
+ * ETag 版本号按路由保存在小数组中，首次用到时登记。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include "http_cache.h"
+
+/* 缓存项 */
+typedef struct {
+    char *response;         /* 完整响应报文 */
+    size_t len;
+    size_t status_len;      /* 状态行长度（含 \r\n） */
+    gint64 stored_at;       /* 写入时间（单调时钟，秒） */
+    unsigned int ttl;
+} HttpCacheEntry;
+
+static GHashTable *g_cache = NULL;   /* "路径?查询串" -> HttpCacheEntry */
+
+/* ETag 版本号 */
+typedef struct {
+    const Route *route;
+    guint32 generation;
+} HttpEtagEntry;
+
+static HttpEtagEntry g_etags[HTTP_CACHE_MAX_ETAG_ROUTES];
+static int g_etag_count = 0;
+static guint32 g_etag_epoch = 0;    /* 启动标识，避免重启后版本号重复 */
+static unsigned long g_invalidations = 0;
+
+/*============================================================================
+ * 内部函数
+ *============================================================================*/
+
+static gint64 cache_now(void) {
+    return g_get_monotonic_time() / G_USEC_PER_SEC;
+}
+
+static void cache_entry_free(gpointer data) {
+    HttpCacheEntry *entry = data;
+    if (!entry) return;
+    g_free(entry->response);
+    g_free(entry);
+}
+
+static int cache_is_get(struct mg_http_message *hm) {
+    return hm->method.len == 3 && memcmp(hm->method.buf, "GET", 3) == 0;
+}
+
+static int cache_cacheable(struct mg_http_message *hm, const Route *route) {
+    return g_cache && route && route->cache_ttl > 0 && cache_is_get(hm);
+}
+
+/* ETag路由的版本号项，首次使用时登记，满时返回NULL */
+static HttpEtagEntry *etag_entry(struct mg_http_message *hm, const Route *route) {
+    if (!route || !(route->flags & ROUTE_F_ETAG) || !cache_is_get(hm)) {
+        return NULL;
+    }
+    for (int i = 0; i < g_etag_count; i++) {
+        if (g_etags[i].route == route) {
+            return &g_etags[i];
+        }
+    }
+    if (g_etag_count >= HTTP_CACHE_MAX_ETAG_ROUTES) {
+        return NULL;
+    }
+    g_etags[g_etag_count].route = route;
+    g_etags[g_etag_count].generation = 0;
+    return &g_etags[g_etag_count++];
+}
+
+static void etag_format(const HttpEtagEntry *entry, char *buf, size_t size) {
+    snprintf(buf, size, "W/\"%08x-%u\"", g_etag_epoch, entry->generation);
+}
+
+/* 响应是 200 时返回状态行长度（含 \r\n），否则返回0 */
+static size_t cache_status_len(const char *resp, size_t len) {
+    const char *eol = memchr(resp, '\n', len);
+
+    if (!eol || len < 13 || memcmp(resp, "HTTP/1.1 200 ", 13) != 0) {
+        return 0;
+    }
+    return (size_t)(eol - resp) + 1;
+}
+
+static char *cache_key(struct mg_http_message *hm) {
+    if (hm->query.len > 0) {
+        return g_strdup_printf("%.*s?%.*s", (int)hm->uri.len, hm->uri.buf,
+                               (int)hm->query.len, hm->query.buf);
+    }
+    return g_strndup(hm->uri.buf, hm->uri.len);
+}
+
+/**
+ * 在响应的状态行之后插入缓存相关响应头
+ * @param io 发送缓冲
+ * @param offset 响应起始位置
+ * @param status_len 状态行长度
+ */
+static void cache_insert_headers(struct mg_iobuf *io, size_t offset, size_t status_len,
+                                 unsigned int max_age, unsigned int age) {
+    char headers[96];
+    int n = snprintf(headers, sizeof(headers),
+                     "Cache-Control: private, max-age=%u\r\nAge: %u\r\n", max_age, age);
+    mg_iobuf_add(io, offset + status_len, headers, (size_t)n);
+}
+
+/* 淘汰过期项，仍然满时淘汰最旧的一项 */
+static void cache_make_room(void) {
+    GHashTableIter iter;
+    gpointer key, value;
+    gint64 now = cache_now();
+    const char *oldest_key = NULL;
+    gint64 oldest_at = G_MAXINT64;
+
+    g_hash_table_iter_init(&iter, g_cache);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        HttpCacheEntry *entry = value;
+        if (now - entry->stored_at >= entry->ttl) {
+            g_hash_table_iter_remove(&iter);
+        } else if (entry->stored_at < oldest_at) {
+            oldest_at = entry->stored_at;
+            oldest_key = key;
+        }
+    }
+
+    if (g_hash_table_size(g_cache) >= HTTP_CACHE_MAX_ENTRIES && oldest_key) {
+        g_hash_table_remove(g_cache, oldest_key);
+    }
+}
+
+/*============================================================================
+ * 公共接口
+ *============================================================================*/
+
+void http_cache_init(void) {
+    if (g_cache) return;
+    g_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, cache_entry_free);
+    g_etag_epoch = g_random_int();
+}
+
+void http_cache_deinit(void) {
+    if (g_cache) {
+        g_hash_table_destroy(g_cache);
+        g_cache = NULL;
+    }
+}
+
+int http_cache_serve(struct mg_connection *c, struct mg_http_message *hm, const Route *route) {
+    if (!cache_cacheable(hm, route)) {
+        return 0;
+    }
+
+    char *key = cache_key(hm);
+    HttpCacheEntry *entry = g_hash_table_lookup(g_cache, key);
+    if (!entry) {
+        g_free(key);
+        return 0;
+    }
+
+    gint64 age = cache_now() - entry->stored_at;
+    if (age < 0 || age >= entry->ttl) {
+        g_hash_table_remove(g_cache, key);
+        g_free(key);
+        return 0;
+    }
+    g_free(key);
+
+    size_t offset = c->send.len;
+    if (!mg_send(c, entry->response, entry->len)) {
+        return 0;
+    }
+    cache_insert_headers(&c->send, offset, entry->status_len,
+                         entry->ttl - (unsigned int)age, (unsigned int)age);
+    c->is_resp = 0;     /* 与 mg_http_reply 一致：标记响应结束 */
+    return 1;
+}
+
+int http_cache_not_modified(struct mg_connection *c, struct mg_http_message *hm, const Route *route) {
+    struct mg_str *inm = mg_http_get_header(hm, "If-None-Match");
+    HttpEtagEntry *entry = inm ? etag_entry(hm, route) : NULL;
+    char etag[32], headers[128];
+
+    if (!entry) {
+        return 0;
+    }
+    etag_format(entry, etag, sizeof(etag));
+
+    /* 弱比较：忽略 W/ 前缀；If-None-Match 可以是逗号分隔的多个ETag */
+    if (mg_strcmp(*inm, mg_str("*")) != 0 && !g_strstr_len(inm->buf, (gssize)inm->len, etag + 2)) {
+        return 0;
+    }
+    snprintf(headers, sizeof(headers),
+             "ETag: %s\r\nCache-Control: no-cache\r\nAccess-Control-Allow-Origin: *\r\n", etag);
+    mg_http_reply(c, 304, headers, "");
+    return 1;
+}
+
+void http_cache_store(struct mg_connection *c, struct mg_http_message *hm,
+                      const Route *route, size_t offset) {
+    if (c->is_resp || c->send.len <= offset) {
+        return;
+    }
+
+    const char *resp = (const char *)c->send.buf + offset;
+    size_t len = c->send.len - offset;
+    size_t status_len = cache_status_len(resp, len);
+
+    /* 只缓存 200 响应 */
+    if (status_len == 0) {
+        return;
+    }
+
+    if (cache_cacheable(hm, route) && len <= HTTP_CACHE_MAX_RESPONSE) {
+        HttpCacheEntry *entry = g_new0(HttpCacheEntry, 1);
+        entry->response = g_malloc(len);
+        memcpy(entry->response, resp, len);
+        entry->len = len;
+        entry->status_len = status_len;
+        entry->stored_at = cache_now();
+        entry->ttl = route->cache_ttl;
+
+        if (g_hash_table_size(g_cache) >= HTTP_CACHE_MAX_ENTRIES) {
+            cache_make_room();
+        }
+        g_hash_table_replace(g_cache, cache_key(hm), entry);
+
+        cache_insert_headers(&c->send, offset, status_len, entry->ttl, 0);
+    }
+
+    /* ETag路由要求每次重新验证 */
+    HttpEtagEntry *tag = etag_entry(hm, route);
+    if (tag) {
+        char etag[32], headers[96];
+        etag_format(tag, etag, sizeof(etag));
+        int n = snprintf(headers, sizeof(headers), "ETag: %s\r\nCache-Control: no-cache\r\n", etag);
+        mg_iobuf_add(&c->send, offset + status_len, headers, (size_t)n);
+    }
+}
+
+void http_cache_invalidate(const char *prefixes) {
+    if (!g_cache || !prefixes) {
+        return;
+    }
+    g_invalidations++;
+
+    const char *p = prefixes;
+    while (*p) {
+        while (*p == ' ') p++;
+        const char *start = p;
+        while (*p && *p != ' ') p++;
+        size_t len = (size_t)(p - start);
+        if (len == 0) continue;
+
+        for (int i = 0; i < g_etag_count; i++) {
+            if (strncmp(g_etags[i].route->pattern, start, len) == 0) {
+                g_etags[i].generation++;
+            }
+        }
+
+        GHashTableIter iter;
+        gpointer key;
+        g_hash_table_iter_init(&iter, g_cache);
+        while (g_hash_table_iter_next(&iter, &key, NULL)) {
+            if (strncmp((const char *)key, start, len) == 0) {
+                g_hash_table_iter_remove(&iter);
+            }
+        }
+    }
+}
+
+unsigned long http_cache_generation(void) {
+    return g_invalidations;
+}
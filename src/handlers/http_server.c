@@ -9,6 +9,7 @@
 #include <signal.h>
 #include <stdint.h>
 #include <glib.h>
+#include <glib-unix.h>
 #include "mongoose.h"
 #include "http_server.h"
 #include "dbus_core.h"
@@ -22,37 +23,90 @@
 #include "http_utils.h"
 #include "auth.h"
 #include "apn.h"
+#include "database.h"
+#include "router.h"
+#include "http_worker.h"
+#include "http_cache.h"
+#include "events.h"
+#include "update_upload.h"
+#include "batch.h"
+#include "metrics.h"
+#include "access_log.h"
+#include "json_writer.h"
 
 /* 嵌入式文件系统声明 (packed_fs.c) */
+extern void packed_fs_init(const char *web_root);
 extern int serve_packed_file(struct mg_connection *c, struct mg_http_message *hm);
 
+/* 空闲时的mongoose维护周期（毫秒），驱动 MG_EV_POLL */
+#define HTTP_POLL_IDLE_MS 1000
+
+/* 有未处理完的已接收数据时的轮询周期（毫秒） */
+#define HTTP_POLL_BUSY_MS 10
+
+/* 超时检查周期（秒） */
+#define HTTP_TIMEOUT_CHECK_SEC 2
+
 /* 全局变量 */
 static struct mg_mgr g_mgr;
-static volatile int g_running = 0;
+static GMainLoop *g_main_loop = NULL;
 
-/* 信号处理 */
-static void signal_handler(int sig) {
-    (void)sig;
-    g_running = 0;
-}
+/* 连接限制（启动时从配置读取） */
+static int g_max_connections = HTTP_MAX_CONNECTIONS_DEFAULT;
+static int g_idle_timeout = HTTP_IDLE_TIMEOUT_DEFAULT;
+static int g_header_timeout = HTTP_HEADER_TIMEOUT_DEFAULT;
+static int g_conn_count = 0;            /* 已接纳的客户端连接数 */
+static guint g_timeout_timer = 0;
 
-/**
- * 检查API是否在白名单中（无需认证）
+/*
+ * 客户端连接状态，存放在 c->data 第8字节起
+ * （前8字节是事件订阅标记，末尾由 mongoose 发送静态文件时使用）
  */
-static int is_auth_whitelist(const char *uri) {
-    /* 认证相关API无需认证 */
-    if (strncmp(uri, "/api/auth/login", 15) == 0) return 1;
-    if (strncmp(uri, "/api/auth/status", 16) == 0) return 1;
-    return 0;
+#define HTTP_CONN_STATE_OFFSET 8
+
+typedef struct {
+    gint32 last_active;         /* 最近一次收发数据的时间（秒，见 http_now） */
+    gint32 header_since;        /* 当前请求头开始接收的时间，0表示不在读请求头 */
+    guint8 admitted;            /* 计入连接数；未计入的连接读到请求头后回复503 */
+    guint8 body_checked;        /* 当前请求的请求体长度已检查 */
+} HttpConnState;
+
+G_STATIC_ASSERT(HTTP_CONN_STATE_OFFSET + sizeof(HttpConnState) <= MG_DATA_SIZE - sizeof(size_t));
+
+static HttpConnState *http_conn_state(struct mg_connection *c) {
+    return (HttpConnState *)(c->data + HTTP_CONN_STATE_OFFSET);
+}
+
+/* 单调时钟秒数，从1开始（0表示未设置） */
+static gint32 http_now(void) {
+    return (gint32)(g_get_monotonic_time() / G_USEC_PER_SEC) + 1;
+}
+
+/* 信号处理：退出主循环 */
+static gboolean on_quit_signal(gpointer user_data) {
+    (void)user_data;
+    if (g_main_loop) {
+        g_main_loop_quit(g_main_loop);
+    }
+    return G_SOURCE_CONTINUE;
 }
 
 /**
  * 验证请求的Token
+ * @param allow_query 是否也接受查询参数 token
  * @return 0验证通过，-1验证失败
  */
-static int verify_request_token(struct mg_http_message *hm) {
+static int verify_request_token(struct mg_http_message *hm, int allow_query) {
     struct mg_str *auth_header = mg_http_get_header(hm, "Authorization");
     
+    if (!auth_header && allow_query) {
+        char token[65];
+        if (mg_http_get_var(&hm->query, "token", token, sizeof(token)) <= 0) {
+            return -1;
+        }
+        return auth_verify_token(token);
+    }
+    
     if (!auth_header || auth_header->len <= 7) {
         return -1;
     }
@@ -75,296 +129,607 @@ static int verify_request_token(struct mg_http_message *hm) {
 }
 
 
-/* HTTP 事件处理函数 */
-static void http_handler(struct mg_connection *c, int ev, void *ev_data) {
-    if (ev == MG_EV_HTTP_MSG) {
-        struct mg_http_message *hm = (struct mg_http_message *)ev_data;
-        char uri[256] = {0};
-        size_t uri_len = hm->uri.len < sizeof(uri) - 1 ? hm->uri.len : sizeof(uri) - 1;
-        memcpy(uri, hm->uri.buf, uri_len);
-
-        /* 静态文件处理 */
-        if (hm->uri.len < 5 || memcmp(hm->uri.buf, "/api/", 5) != 0) {
-            if (serve_packed_file(c, hm)) {
-                return;  /* 静态文件已处理 */
-            }
-        }
+/*============================================================================
+ * 路由表
+ *
+ * 同一路径的多条路由按声明顺序匹配方法；ROUTE_ANY 表示由处理函数自行检查方法。
+ * 第5列为GET响应缓存秒数，第6列为请求完成后失效的缓存路径前缀（同时触发相关事件主题重新采样、
+ * 递增 ROUTE_F_ETAG 路由的版本号），
+ * 第7列为请求体上限（缺省 HTTP_MAX_BODY_DEFAULT）
+ *============================================================================*/
 
-        /* 认证 API - 优先处理，无需Token验证 */
-        if (mg_match(hm->uri, mg_str("/api/auth/login"), NULL)) {
-            handle_auth_login(c, hm);
-            return;
-        }
-        else if (mg_match(hm->uri, mg_str("/api/auth/status"), NULL)) {
-            handle_auth_status(c, hm);
-            return;
-        }
-        else if (mg_match(hm->uri, mg_str("/api/auth/logout"), NULL)) {
-            handle_auth_logout(c, hm);
-            return;
-        }
-        else if (mg_match(hm->uri, mg_str("/api/auth/password"), NULL)) {
-            handle_auth_password(c, hm);
-            return;
-        }
+/* 影响无线状态的写操作需要失效的查询 */
+#define INVALIDATE_RADIO    "/api/info /api/current_band /api/bands /api/cells"
+#define INVALIDATE_BANDS    "/api/current_band /api/bands /api/cells"
+#define INVALIDATE_CELLS    "/api/current_band /api/cells"
 
-        /* 认证中间件 - 检查Token */
-        if (!is_auth_whitelist(uri)) {
-            if (verify_request_token(hm) != 0) {
-                HTTP_JSON(c, 401, "{\"status\":\"error\",\"message\":\"未授权，请先登录\"}");
-                return;
-            }
-        }
+/* 上传插件、脚本和插件存储数据的请求体上限 */
+#define BODY_LIMIT_FILE     (256 * 1024)
 
-        /* API 路由 */
-        if (mg_match(hm->uri, mg_str("/api/info"), NULL)) {
-            handle_info(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/at"), NULL)) {
-            handle_execute_at(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/set_network"), NULL)) {
-            handle_set_network(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/switch"), NULL)) {
-            handle_switch(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/airplane_mode"), NULL)) {
-            handle_airplane_mode(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/device_control"), NULL)) {
-            handle_device_control(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/clear_cache"), NULL)) {
-            handle_clear_cache(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/current_band"), NULL)) {
-            handle_get_current_band(c, hm);
-        }
-        /* 高级网络 API */
-        else if (mg_match(hm->uri, mg_str("/api/bands"), NULL)) {
-            handle_get_bands(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/lock_bands"), NULL)) {
-            handle_lock_bands(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/unlock_bands"), NULL)) {
-            handle_unlock_bands(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/cells"), NULL)) {
-            handle_get_cells(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/lock_cell"), NULL)) {
-            handle_lock_cell(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/unlock_cell"), NULL)) {
-            handle_unlock_cell(c, hm);
-        }
-        /* 流量统计 API */
-        else if (mg_match(hm->uri, mg_str("/api/get/Total"), NULL)) {
-            handle_get_traffic_total(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/get/set"), NULL)) {
-            handle_get_traffic_config(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/set/total"), NULL)) {
-            handle_set_traffic_limit(c, hm);
-        }
-        /* 系统时间 API */
-        else if (mg_match(hm->uri, mg_str("/api/get/time"), NULL)) {
-            handle_get_system_time(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/set/time"), NULL)) {
-            handle_set_system_time(c, hm);
-        }
-        /* 定时重启 API */
-        else if (mg_match(hm->uri, mg_str("/api/get/first-reboot"), NULL)) {
-            handle_get_first_reboot(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/set/reboot"), NULL)) {
-            handle_set_reboot(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/claen/cron"), NULL)) {
-            handle_clear_cron(c, hm);
-        }
-        /* 充电控制 API */
-        else if (mg_match(hm->uri, mg_str("/api/charge/config"), NULL)) {
-            handle_charge_config(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/charge/on"), NULL)) {
-            handle_charge_on(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/charge/off"), NULL)) {
-            handle_charge_off(c, hm);
-        }
-        /* 短信 API */
-        else if (mg_match(hm->uri, mg_str("/api/sms"), NULL)) {
-            handle_sms_list(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/sms/send"), NULL)) {
-            handle_sms_send(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/sms/sent"), NULL)) {
-            handle_sms_sent_list(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/sms/sent/*"), NULL)) {
-            handle_sms_sent_delete(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/sms/config"), NULL)) {
-            if (hm->method.len == 3 && memcmp(hm->method.buf, "GET", 3) == 0) {
-                handle_sms_config_get(c, hm);
-            } else {
-                handle_sms_config_save(c, hm);
-            }
-        }
-        else if (mg_match(hm->uri, mg_str("/api/sms/webhook"), NULL)) {
-            if (hm->method.len == 3 && memcmp(hm->method.buf, "GET", 3) == 0) {
-                handle_sms_webhook_get(c, hm);
-            } else {
-                handle_sms_webhook_save(c, hm);
-            }
-        }
-        else if (mg_match(hm->uri, mg_str("/api/sms/webhook/test"), NULL)) {
-            handle_sms_webhook_test(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/sms/fix"), NULL)) {
-            if (hm->method.len == 3 && memcmp(hm->method.buf, "GET", 3) == 0) {
-                handle_sms_fix_get(c, hm);
-            } else {
-                handle_sms_fix_set(c, hm);
-            }
-        }
-        else if (mg_match(hm->uri, mg_str("/api/sms/*"), NULL)) {
-            handle_sms_delete(c, hm);
-        }
-        /* OTA更新 API */
-        else if (mg_match(hm->uri, mg_str("/api/update/version"), NULL)) {
-            handle_update_version(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/update/upload"), NULL)) {
-            handle_update_upload(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/update/download"), NULL)) {
-            handle_update_download(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/update/extract"), NULL)) {
-            handle_update_extract(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/update/install"), NULL)) {
-            handle_update_install(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/update/check"), NULL)) {
-            handle_update_check(c, hm);
-        }
-        /* USB模式切换 API */
-        else if (mg_match(hm->uri, mg_str("/api/usb/mode"), NULL)) {
-            if (hm->method.len == 3 && memcmp(hm->method.buf, "GET", 3) == 0) {
-                handle_usb_mode_get(c, hm);
-            } else {
-                handle_usb_mode_set(c, hm);
-            }
-        }
-        else if (mg_match(hm->uri, mg_str("/api/usb-advance"), NULL)) {
-            handle_usb_advance(c, hm);
-        }
-        /* 数据连接和漫游 API */
-        else if (mg_match(hm->uri, mg_str("/api/data"), NULL)) {
-            handle_data_status(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/roaming"), NULL)) {
-            handle_roaming_status(c, hm);
-        }
-        // /* APN 管理 API */
-        // else if (mg_match(hm->uri, mg_str("/api/apn"), NULL)) {
-        //     if (hm->method.len == 3 && memcmp(hm->method.buf, "GET", 3) == 0) {
-        //         handle_apn_list(c, hm);
-        //     } else {
-        //         handle_apn_set(c, hm);
-        //     }
-        // }
-        /* APN 配置管理 API */
-        else if (mg_match(hm->uri, mg_str("/api/apn/config"), NULL)) {
-            if (hm->method.len == 3 && memcmp(hm->method.buf, "GET", 3) == 0) {
-                handle_apn_config_get(c, hm);
-            } else {
-                handle_apn_config_set(c, hm);
-            }
-        }
-        else if (mg_match(hm->uri, mg_str("/api/apn/templates"), NULL)) {
-            if (hm->method.len == 3 && memcmp(hm->method.buf, "GET", 3) == 0) {
-                handle_apn_templates_list(c, hm);
-            } else {
-                handle_apn_templates_create(c, hm);
-            }
-        }
-        else if (mg_match(hm->uri, mg_str("/api/apn/templates/*"), NULL)) {
-            if (hm->method.len == 3 && memcmp(hm->method.buf, "PUT", 3) == 0) {
-                handle_apn_templates_update(c, hm);
-            } else {
-                handle_apn_templates_delete(c, hm);
-            }
-        }
-        else if (mg_match(hm->uri, mg_str("/api/apn/apply"), NULL)) {
-            handle_apn_apply(c, hm);
-        }
-        else if (mg_match(hm->uri, mg_str("/api/apn/clear"), NULL)) {
-            handle_apn_clear(c, hm);
-        }
-        /* 插件管理 API */
-        else if (mg_match(hm->uri, mg_str("/api/shell"), NULL)) {
-            handle_shell_execute(c, hm);
+static const Route g_routes[] = {
+    /* 认证 API - 无需Token（登出/改密由处理函数自行校验） */
+    { "/api/auth/login",            ROUTE_ANY,      handle_auth_login,              ROUTE_F_PUBLIC },
+    { "/api/auth/status",           ROUTE_ANY,      handle_auth_status,             ROUTE_F_PUBLIC },
+    { "/api/auth/logout",           ROUTE_ANY,      handle_auth_logout,             ROUTE_F_PUBLIC },
+    { "/api/auth/password",         ROUTE_ANY,      handle_auth_password,           ROUTE_F_PUBLIC },
+
+    /* 基础 API */
+    { "/api/info",                  ROUTE_ANY,      handle_info,                    ROUTE_F_BLOCKING | ROUTE_F_BATCH,   2 },
+    { "/api/at",                    ROUTE_ANY,      handle_execute_at,              ROUTE_F_BLOCKING,   0,  INVALIDATE_RADIO },
+    { "/api/set_network",           ROUTE_ANY,      handle_set_network,             0,                  0,  INVALIDATE_RADIO },
+    { "/api/switch",                ROUTE_ANY,      handle_switch,                  0,                  0,  INVALIDATE_RADIO },
+    { "/api/airplane_mode",         ROUTE_ANY,      handle_airplane_mode,           0,                  0,  INVALIDATE_RADIO },
+    { "/api/device_control",        ROUTE_ANY,      handle_device_control,          0 },
+    { "/api/clear_cache",           ROUTE_ANY,      handle_clear_cache,             0 },
+    { "/api/current_band",          ROUTE_ANY,      handle_get_current_band,        ROUTE_F_BLOCKING | ROUTE_F_BATCH,   5 },
+    { "/api/events",                ROUTE_GET,      handle_events,                  ROUTE_F_QUERY_TOKEN | ROUTE_F_ASYNC },
+    { "/api/batch",                 ROUTE_POST,     handle_batch,                   0 },
+    { "/metrics",                   ROUTE_GET,      handle_metrics,                 0 },
+    { "/api/debug/access-log",      ROUTE_GET,      handle_access_log,              0 },
+
+    /* 高级网络 API */
+    { "/api/bands",                 ROUTE_ANY,      handle_get_bands,               ROUTE_F_BLOCKING | ROUTE_F_BATCH,   10 },
+    { "/api/lock_bands",            ROUTE_ANY,      handle_lock_bands,              ROUTE_F_BLOCKING,   0,  INVALIDATE_BANDS },
+    { "/api/unlock_bands",          ROUTE_ANY,      handle_unlock_bands,            ROUTE_F_BLOCKING,   0,  INVALIDATE_BANDS },
+    { "/api/cells",                 ROUTE_ANY,      handle_get_cells,               ROUTE_F_BLOCKING | ROUTE_F_BATCH,   5 },
+    { "/api/lock_cell",             ROUTE_ANY,      handle_lock_cell,               ROUTE_F_BLOCKING,   0,  INVALIDATE_CELLS },
+    { "/api/unlock_cell",           ROUTE_ANY,      handle_unlock_cell,             ROUTE_F_BLOCKING,   0,  INVALIDATE_CELLS },
+
+    /* 流量统计 API */
+    { "/api/get/Total",             ROUTE_ANY,      handle_get_traffic_total,       ROUTE_F_BATCH,      5 },
+    { "/api/get/set",               ROUTE_ANY,      handle_get_traffic_config,      ROUTE_F_BATCH },
+    { "/api/set/total",             ROUTE_ANY,      handle_set_traffic_limit,       0,                  0,  "/api/get/Total" },
+
+    /* 系统时间 API */
+    { "/api/get/time",              ROUTE_ANY,      handle_get_system_time,         0 },
+    { "/api/set/time",              ROUTE_ANY,      handle_set_system_time,         ROUTE_F_BLOCKING },
+
+    /* 定时重启 API */
+    { "/api/get/first-reboot",      ROUTE_ANY,      handle_get_first_reboot,        0 },
+    { "/api/set/reboot",            ROUTE_ANY,      handle_set_reboot,              0 },
+    { "/api/claen/cron",            ROUTE_ANY,      handle_clear_cron,              0 },
+
+    /* 充电控制 API */
+    { "/api/charge/config",         ROUTE_ANY,      handle_charge_config,           ROUTE_F_BATCH },
+    { "/api/charge/on",             ROUTE_ANY,      handle_charge_on,               0,                  0,  "/api/charge/config" },
+    { "/api/charge/off",            ROUTE_ANY,      handle_charge_off,              0,                  0,  "/api/charge/config" },
+
+    /* 短信 API */
+    { "/api/sms",                   ROUTE_ANY,      handle_sms_list,                ROUTE_F_ASYNC },
+    { "/api/sms/send",              ROUTE_ANY,      handle_sms_send,                0 },
+    { "/api/sms/sent",              ROUTE_ANY,      handle_sms_sent_list,           ROUTE_F_ASYNC },
+    { "/api/sms/sent/*",            ROUTE_ANY,      handle_sms_sent_delete,         0,                  0,  "/api/sms/state" },
+    { "/api/sms/state",             ROUTE_GET,      handle_sms_state,               0 },
+    { "/api/sms/config",            ROUTE_GET,      handle_sms_config_get,          ROUTE_F_ETAG },
+    { "/api/sms/config",            ROUTE_ANY,      handle_sms_config_save,         0,                  0,  "/api/sms/config" },
+    { "/api/sms/webhook",           ROUTE_GET,      handle_sms_webhook_get,         ROUTE_F_ETAG },
+    { "/api/sms/webhook",           ROUTE_ANY,      handle_sms_webhook_save,        0,                  0,  "/api/sms/webhook" },
+    { "/api/sms/webhook/test",      ROUTE_ANY,      handle_sms_webhook_test,        0 },
+    { "/api/sms/fix",               ROUTE_GET,      handle_sms_fix_get,             0 },
+    { "/api/sms/fix",               ROUTE_ANY,      handle_sms_fix_set,             0 },
+    { "/api/sms/*",                 ROUTE_ANY,      handle_sms_delete,              0,                  0,  "/api/sms/state" },
+
+    /* OTA更新 API */
+    { "/api/update/version",        ROUTE_ANY,      handle_update_version,          0 },
+    { "/api/update/upload",         ROUTE_ANY,      handle_update_upload,           ROUTE_F_STREAM,     0,  NULL,   UPDATE_UPLOAD_MAX_SIZE },
+    { "/api/update/download",       ROUTE_ANY,      handle_update_download,         ROUTE_F_BLOCKING },
+    { "/api/update/extract",        ROUTE_ANY,      handle_update_extract,          ROUTE_F_BLOCKING },
+    { "/api/update/install",        ROUTE_ANY,      handle_update_install,          ROUTE_F_BLOCKING },
+    { "/api/update/check",          ROUTE_ANY,      handle_update_check,            ROUTE_F_BLOCKING },
+
+    /* USB模式切换 API */
+    { "/api/usb/mode",              ROUTE_GET,      handle_usb_mode_get,            ROUTE_F_BATCH },
+    { "/api/usb/mode",              ROUTE_ANY,      handle_usb_mode_set,            0 },
+    { "/api/usb-advance",           ROUTE_ANY,      handle_usb_advance,             0 },
+
+    /* 数据连接和漫游 API */
+    { "/api/data",                  ROUTE_ANY,      handle_data_status,             ROUTE_F_BATCH },
+    { "/api/roaming",               ROUTE_ANY,      handle_roaming_status,          ROUTE_F_BATCH },
+
+    /* APN 配置管理 API */
+    { "/api/apn/config",            ROUTE_GET,      handle_apn_config_get,          0 },
+    { "/api/apn/config",            ROUTE_ANY,      handle_apn_config_set,          0 },
+    { "/api/apn/templates",         ROUTE_GET,      handle_apn_templates_list,      ROUTE_F_ETAG },
+    { "/api/apn/templates",         ROUTE_ANY,      handle_apn_templates_create,    0,                  0,  "/api/apn/templates" },
+    { "/api/apn/templates/*",       ROUTE_PUT,      handle_apn_templates_update,    0,                  0,  "/api/apn/templates" },
+    { "/api/apn/templates/*",       ROUTE_ANY,      handle_apn_templates_delete,    0,                  0,  "/api/apn/templates" },
+    { "/api/apn/apply",             ROUTE_ANY,      handle_apn_apply,               0 },
+    { "/api/apn/clear",             ROUTE_ANY,      handle_apn_clear,               0 },
+
+    /* 插件管理 API */
+    { "/api/shell",                 ROUTE_ANY,      handle_shell_execute,           ROUTE_F_BLOCKING },
+    { "/api/plugins/all",           ROUTE_ANY,      handle_plugin_delete_all,       0,                  0,  "/api/plugins" },
+    { "/api/plugins",               ROUTE_GET,      handle_plugin_list,             ROUTE_F_ETAG },
+    { "/api/plugins",               ROUTE_ANY,      handle_plugin_upload,           0,                  0,  "/api/plugins",     BODY_LIMIT_FILE },
+    { "/api/plugins/*",             ROUTE_ANY,      handle_plugin_delete,           0,                  0,  "/api/plugins" },
+
+    /* 脚本管理 API */
+    { "/api/scripts",               ROUTE_GET,      handle_script_list,             ROUTE_F_ETAG },
+    { "/api/scripts",               ROUTE_ANY,      handle_script_upload,           0,                  0,  "/api/scripts",     BODY_LIMIT_FILE },
+    { "/api/scripts/*",             ROUTE_PUT,      handle_script_update,           0,                  0,  "/api/scripts",     BODY_LIMIT_FILE },
+    { "/api/scripts/*",             ROUTE_ANY,      handle_script_delete,           0,                  0,  "/api/scripts" },
+
+    /* 插件存储 API */
+    { "/api/plugins/storage/*",     ROUTE_GET,      handle_plugin_storage_get,      0 },
+    { "/api/plugins/storage/*",     ROUTE_POST,     handle_plugin_storage_set,      0,                  0,  NULL,   BODY_LIMIT_FILE },
+    { "/api/plugins/storage/*",     ROUTE_DELETE,   handle_plugin_storage_delete,   0 },
+};
+
+/* 当前请求的路由匹配结果（分发期间有效；阻塞路由在工作线程执行，不使用通配参数） */
+static __thread RouteMatch g_current_route;
+
+struct mg_str http_route_param(void) {
+    return g_current_route.param;
+}
+
+/**
+ * 分发一个请求
+ * @return 指标中的路由标签：路由模式、"static" 或 "unmatched"
+ */
+static const char *http_dispatch(struct mg_connection *c, struct mg_http_message *hm) {
+    /* 静态文件处理（/metrics 除外） */
+    if ((hm->uri.len < 5 || memcmp(hm->uri.buf, "/api/", 5) != 0) &&
+        mg_strcmp(hm->uri, mg_str("/metrics")) != 0) {
+        if (serve_packed_file(c, hm)) {
+            return "static";  /* 静态文件已处理 */
         }
-        else if (mg_match(hm->uri, mg_str("/api/plugins/all"), NULL)) {
-            handle_plugin_delete_all(c, hm);
+    }
+
+    RouteMatch match;
+    int status = router_match(hm->uri, hm->method, &match);
+    const char *label = status == 0 ? match.route->pattern : "unmatched";
+
+    /* 认证中间件 - 未知路由同样要求Token，避免暴露路由是否存在 */
+    if (status != 0 || !(match.route->flags & ROUTE_F_PUBLIC)) {
+        int allow_query = status == 0 && (match.route->flags & ROUTE_F_QUERY_TOKEN);
+        gint64 auth_start = g_get_monotonic_time();
+        int auth_ret = verify_request_token(hm, allow_query);
+        metrics_span("auth", NULL, auth_start);
+        if (auth_ret != 0) {
+            HTTP_JSON(c, 401, "{\"status\":\"error\",\"message\":\"未授权，请先登录\"}");
+            return label;
         }
-        else if (mg_match(hm->uri, mg_str("/api/plugins"), NULL)) {
-            if (hm->method.len == 3 && memcmp(hm->method.buf, "GET", 3) == 0) {
-                handle_plugin_list(c, hm);
-            } else {
-                handle_plugin_upload(c, hm);
-            }
+    }
+
+    if (status == 405) {
+        HTTP_ERROR(c, 405, "Method not allowed");
+        return label;
+    }
+    if (status != 0) {
+        /* 未知 API 路由 */
+        HTTP_ERROR(c, 404, "Endpoint not found");
+        return label;
+    }
+
+    /* 资源未变化（If-None-Match 匹配当前ETag）回复304，不执行处理函数 */
+    if (http_cache_not_modified(c, hm, match.route)) {
+        return label;
+    }
+
+    /* 缓存命中直接返回 */
+    if (http_cache_serve(c, hm, match.route)) {
+        metrics_inc(METRIC_HTTP_CACHE_HITS, label, NULL);
+        return label;
+    }
+
+    /* 阻塞型路由交给工作线程，队列满时拒绝而不是阻塞事件循环 */
+    if (match.route->flags & ROUTE_F_BLOCKING) {
+        int ret = http_worker_submit(c, hm, match.route);
+        if (ret == 0) {
+            return label;
+        }
+        if (ret == -2) {
+            metrics_inc(METRIC_HTTP_WORKER_REJECTED, NULL, NULL);
+            mg_http_reply(c, 503, HTTP_CORS_HEADERS "Retry-After: 1\r\n",
+                          "{\"Code\":1,\"Error\":\"服务器繁忙，请稍后重试\",\"Data\":null}");
+            return label;
         }
-        else if (mg_match(hm->uri, mg_str("/api/plugins/*"), NULL)) {
-            handle_plugin_delete(c, hm);
+    }
+
+    http_server_call_route(c, hm, &match);
+    return label;
+}
+
+/*============================================================================
+ * 流式请求体
+ *
+ * 流式路由在请求头收全时执行，之后收到的请求体由 http_handler 直接交给回调并从
+ * 接收缓冲删除；删除请求头时 mongoose 会卸下该连接的 HTTP 解析，
+ * 所以响应写出后连接不再复用。状态挂在 c->fn_data 上（监听连接未使用）
+ *============================================================================*/
+
+typedef struct {
+    http_stream_cb_t cb;
+    void *arg;
+    size_t remaining;           /* 尚未收到的请求体字节数 */
+    const char *label;          /* 路由标签 */
+    char *method;
+    char *uri;
+    gint64 start_us;
+} HttpStream;
+
+void http_server_stream(struct mg_connection *c, struct mg_http_message *hm,
+                        http_stream_cb_t cb, void *arg) {
+    HttpStream *s = g_new0(HttpStream, 1);
+
+    s->cb = cb;
+    s->arg = arg;
+    s->method = g_strndup(hm->method.buf, hm->method.len);
+    s->uri = g_strndup(hm->uri.buf, hm->uri.len);
+    c->fn_data = s;
+}
+
+/* 结束流式接收：响应已写出或连接已关闭 */
+static void http_stream_free(struct mg_connection *c) {
+    HttpStream *s = (HttpStream *)c->fn_data;
+
+    c->fn_data = NULL;
+    c->recv.len = 0;
+    c->is_draining = 1;
+    g_free(s->method);
+    g_free(s->uri);
+    g_free(s);
+}
+
+/* 调用回调，写出了响应时记录请求 */
+static int http_stream_call(struct mg_connection *c, HttpStreamEvent ev, struct mg_str data) {
+    HttpStream *s = (HttpStream *)c->fn_data;
+    size_t send_offset = c->send.len;
+    int ret = s->cb(c, ev, data, s->arg);
+
+    if (c->send.len > send_offset) {
+        struct mg_http_message hm;
+        memset(&hm, 0, sizeof(hm));
+        hm.method = mg_str(s->method);
+        hm.uri = mg_str(s->uri);
+        http_server_observe(s->label, &c->rem, &hm, (const char *)c->send.buf + send_offset,
+                            c->send.len - send_offset, s->start_us);
+    }
+    return ret;
+}
+
+/**
+ * 交给回调一段请求体，收全时结束
+ * @return 0继续接收, -1已结束（流式状态已释放）
+ */
+static int http_stream_feed(struct mg_connection *c, struct mg_str data) {
+    HttpStream *s = (HttpStream *)c->fn_data;
+    int ret = 0;
+
+    if (data.len > 0) {
+        s->remaining -= data.len;
+        ret = http_stream_call(c, HTTP_STREAM_DATA, data);
+    }
+    if (ret == 0 && s->remaining == 0) {
+        http_stream_call(c, HTTP_STREAM_END, mg_str_n(NULL, 0));
+        ret = -1;
+    }
+    if (ret != 0) {
+        http_stream_free(c);
+        return -1;
+    }
+    return 0;
+}
+
+/* 流式连接收到数据 */
+static void http_stream_read(struct mg_connection *c) {
+    HttpStream *s = (HttpStream *)c->fn_data;
+    size_t n = MIN(c->recv.len, s->remaining);
+
+    if (n > 0 && http_stream_feed(c, mg_str_n((const char *)c->recv.buf, n)) == 0) {
+        mg_iobuf_del(&c->recv, 0, n);
+    }
+}
+
+/**
+ * 请求头收全时执行流式路由：验证Token，调用处理函数，
+ * 处理函数接管请求体时把已缓冲的部分交给回调并删除已处理的数据
+ */
+static void http_stream_start(struct mg_connection *c, struct mg_http_message *hm,
+                              const RouteMatch *match) {
+    gint64 start = g_get_monotonic_time();
+    size_t send_offset = c->send.len;
+    const char *label = match->route->pattern;
+    size_t head_ofs = (size_t)(hm->head.buf - (const char *)c->recv.buf);
+    struct mg_http_message head = *hm;
+
+    head.body.len = 0;      /* 请求体尚未收全，处理函数不可访问 */
+    if (!(match->route->flags & ROUTE_F_PUBLIC) && verify_request_token(hm, 0) != 0) {
+        HTTP_JSON(c, 401, "{\"status\":\"error\",\"message\":\"未授权，请先登录\"}");
+    } else {
+        http_server_call_route(c, &head, match);
+    }
+
+    HttpStream *s = (HttpStream *)c->fn_data;
+    if (s == NULL) {
+        /* 处理函数直接回复（参数错误等），未读的请求体丢弃 */
+        http_server_observe(label, &c->rem, hm, (const char *)c->send.buf + send_offset,
+                            c->send.len - send_offset, start);
+        c->recv.len = 0;
+        c->is_draining = 1;
+        return;
+    }
+
+    s->label = label;
+    s->start_us = start;
+    s->remaining = hm->body.len;
+
+    size_t buffered = MIN(c->recv.len - head_ofs - hm->head.len, hm->body.len);
+    if (http_stream_feed(c, mg_str_n(hm->head.buf + hm->head.len, buffered)) == 0) {
+        mg_iobuf_del(&c->recv, head_ofs, hm->head.len + buffered);
+    }
+}
+
+/*============================================================================
+ * 连接准入与超时
+ *============================================================================*/
+
+/**
+ * 拒绝当前请求：回复后丢弃已接收的数据并在发送完后关闭连接
+ * 丢弃接收数据会使 mongoose 不再解析该连接上的请求
+ */
+static void http_reject(struct mg_connection *c, struct mg_http_message *hm,
+                        int status, const char *headers, const char *message) {
+    gint64 start = g_get_monotonic_time();
+    size_t send_offset = c->send.len;
+
+    mg_http_reply(c, status, headers, "{\"Code\":1,\"Error\":\"%s\",\"Data\":null}", message);
+    http_server_observe("rejected", &c->rem, hm, (const char *)c->send.buf + send_offset,
+                        c->send.len - send_offset, start);
+    c->recv.len = 0;
+    c->is_draining = 1;
+}
+
+static void http_conn_accept(struct mg_connection *c) {
+    HttpConnState *st = http_conn_state(c);
+
+    st->last_active = http_now();
+    if (g_conn_count < g_max_connections) {
+        st->admitted = 1;
+        g_conn_count++;
+    } else {
+        printf("[HTTP] 连接数已达上限 %d，拒绝连接 %lu\n", g_max_connections, c->id);
+    }
+}
+
+/* 收发数据：刷新空闲计时，并记录请求头是否仍未收全 */
+static void http_conn_activity(struct mg_connection *c, int ev) {
+    HttpConnState *st = http_conn_state(c);
+    gint32 now = http_now();
+
+    st->last_active = now;
+    if (ev != MG_EV_READ) {
+        return;
+    }
+
+    /* 事件处理函数在 mongoose 解析之后调用，剩余数据中没有完整请求头即为正在读请求头 */
+    if (!c->is_resp && c->recv.len > 0 &&
+        mg_http_get_request_len(c->recv.buf, c->recv.len) == 0) {
+        if (st->header_since == 0) {
+            st->header_since = now;
+        }
+    } else {
+        st->header_since = 0;
+    }
+}
+
+/**
+ * 请求头收全（请求体可能尚未收全，每次收到数据都会调用）：
+ * 超出连接上限的连接回复503，请求体超出路由上限回复413，不等请求体缓冲完
+ */
+static void http_check_request(struct mg_connection *c, struct mg_http_message *hm) {
+    HttpConnState *st = http_conn_state(c);
+    RouteMatch match;
+    size_t limit = HTTP_MAX_BODY_DEFAULT;
+
+    st->header_since = 0;
+    if (!st->admitted) {
+        http_reject(c, hm, 503, HTTP_CORS_HEADERS "Retry-After: 5\r\n", "连接数过多，请稍后重试");
+        return;
+    }
+    if (st->body_checked) {
+        return;
+    }
+
+    int matched = router_match(hm->uri, hm->method, &match) == 0;
+    if (matched && match.route->max_body > 0) {
+        limit = match.route->max_body;
+    }
+
+    /* 分块传输没有总长度，按已缓冲的数据检查；流式路由要求 Content-Length */
+    if (mg_http_get_header(hm, "Transfer-Encoding") != NULL) {
+        if (matched && (match.route->flags & ROUTE_F_STREAM)) {
+            http_reject(c, hm, 411, HTTP_CORS_HEADERS, "缺少 Content-Length");
+        } else if (c->recv.len > hm->head.len && c->recv.len - hm->head.len > limit) {
+            http_reject(c, hm, 413, HTTP_CORS_HEADERS, "请求体过大");
+        }
+        return;
+    }
+
+    /* 没有 Content-Length 的 POST/PUT，mongoose 按读到连接关闭处理（body.len 为 ~0） */
+    if (hm->body.len == (size_t)~0) {
+        http_reject(c, hm, 411, HTTP_CORS_HEADERS, "缺少 Content-Length");
+        return;
+    }
+    if (hm->body.len > limit) {
+        http_reject(c, hm, 413, HTTP_CORS_HEADERS, "请求体过大");
+        return;
+    }
+    st->body_checked = 1;
+
+    if (matched && (match.route->flags & ROUTE_F_STREAM)) {
+        http_stream_start(c, hm, &match);
+    }
+}
+
+/* 定时关闭空闲连接和请求头读取超时的连接 */
+static gboolean http_timeout_cb(gpointer user_data) {
+    gint32 now = http_now();
+    (void)user_data;
+
+    for (struct mg_connection *c = g_mgr.conns; c != NULL; c = c->next) {
+        if (!c->is_accepted || c->is_closing || c->is_draining) {
+            continue;
         }
-        /* 脚本管理 API */
-        else if (mg_match(hm->uri, mg_str("/api/scripts"), NULL)) {
-            if (hm->method.len == 3 && memcmp(hm->method.buf, "GET", 3) == 0) {
-                handle_script_list(c, hm);
-            } else {
-                handle_script_upload(c, hm);
-            }
+        HttpConnState *st = http_conn_state(c);
+
+        if (st->header_since && now - st->header_since > g_header_timeout) {
+            printf("[HTTP] 连接 %lu 请求头读取超时\n", c->id);
+            mg_http_reply(c, 408, HTTP_CORS_HEADERS "Connection: close\r\n",
+                          "{\"Code\":1,\"Error\":\"请求超时\",\"Data\":null}");
+            c->recv.len = 0;
+            c->is_draining = 1;
+        } else if (!c->is_resp && c->send.len == 0 && now - st->last_active > g_idle_timeout) {
+            /* 正在生成响应的连接（工作线程、异步任务、事件流）不算空闲 */
+            c->is_closing = 1;
         }
-        else if (mg_match(hm->uri, mg_str("/api/scripts/*"), NULL)) {
-            if (hm->method.len == 3 && memcmp(hm->method.buf, "PUT", 3) == 0) {
-                handle_script_update(c, hm);
-            } else {
-                handle_script_delete(c, hm);
-            }
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+/* HTTP 事件处理函数 */
+static void http_handler(struct mg_connection *c, int ev, void *ev_data) {
+    /* 工作线程完成的响应：唤醒事件投递到监听连接，轮询兜底 */
+    if (ev == MG_EV_WAKEUP || (ev == MG_EV_POLL && c->is_listening)) {
+        http_worker_deliver();
+        return;
+    }
+
+    if (ev == MG_EV_ACCEPT) {
+        metrics_gauge_add(METRIC_HTTP_CONNECTIONS, 1);
+        http_conn_accept(c);
+    } else if (ev == MG_EV_CLOSE && c->is_accepted) {
+        metrics_gauge_add(METRIC_HTTP_CONNECTIONS, -1);
+        if (http_conn_state(c)->admitted) {
+            g_conn_count--;
+        }
+        if (c->fn_data != NULL) {
+            http_stream_call(c, HTTP_STREAM_ABORT, mg_str_n(NULL, 0));
+            http_stream_free(c);
+        }
+        json_writer_abort(c);
+    } else if (ev == MG_EV_READ && c->fn_data != NULL) {
+        http_conn_state(c)->last_active = http_now();
+        http_stream_read(c);
+    } else if ((ev == MG_EV_READ || ev == MG_EV_WRITE) && c->is_accepted) {
+        http_conn_activity(c, ev);
+        if (ev == MG_EV_WRITE) {
+            json_writer_pump(c);    /* 流式响应随发送进度继续生成 */
+        }
+    } else if (ev == MG_EV_POLL && c->is_accepted) {
+        json_writer_pump(c);
+    } else if (ev == MG_EV_HTTP_HDRS) {
+        http_check_request(c, (struct mg_http_message *)ev_data);
+    }
+
+    if (ev == MG_EV_HTTP_MSG) {
+        struct mg_http_message *hm = (struct mg_http_message *)ev_data;
+        gint64 start = g_get_monotonic_time();
+        size_t send_offset = c->send.len;
+        int timing = mg_http_get_header(hm, HTTP_TIMING_REQUEST_HEADER) != NULL;
+
+        http_conn_state(c)->body_checked = 0;     /* 下一个请求重新检查 */
+
+        if (timing) {
+            metrics_trace_begin();
         }
-        /* 插件存储 API */
-        else if (mg_match(hm->uri, mg_str("/api/plugins/storage/*"), NULL)) {
-            if (hm->method.len == 3 && memcmp(hm->method.buf, "GET", 3) == 0) {
-                handle_plugin_storage_get(c, hm);
-            } else if (hm->method.len == 4 && memcmp(hm->method.buf, "POST", 4) == 0) {
-                handle_plugin_storage_set(c, hm);
-            } else if (hm->method.len == 6 && memcmp(hm->method.buf, "DELETE", 6) == 0) {
-                handle_plugin_storage_delete(c, hm);
-            } else {
-                HTTP_ERROR(c, 405, "Method not allowed");
+
+        const char *label = http_dispatch(c, hm);
+
+        /* 转交工作线程或异步完成的请求此时还没有响应，由写出响应处统计 */
+        if (c->send.len > send_offset) {
+            if (timing) {
+                http_server_timing_insert(&c->send, send_offset, start);
             }
+            http_server_observe(label, &c->rem, hm, (const char *)c->send.buf + send_offset,
+                                c->send.len - send_offset, start);
         }
-        /* 未知 API 路由 */
-        else {
-            HTTP_ERROR(c, 404, "Endpoint not found");
+        metrics_trace_end(NULL);
+    }
+}
+
+void http_server_call_route(struct mg_connection *c, struct mg_http_message *hm,
+                            const RouteMatch *match) {
+    RouteMatch saved = g_current_route;     /* 批量请求中嵌套调用 */
+    size_t send_offset = c->send.len;
+
+    g_current_route = *match;
+    match->route->handler(c, hm);
+    g_current_route = saved;
+
+    http_cache_store(c, hm, match->route, send_offset);
+    http_cache_invalidate(match->route->invalidates);
+    events_invalidate(match->route->invalidates);
+}
+
+/* 响应总字节数：有 Content-Length 时按头部+响应体计（静态文件的响应体稍后才写出） */
+static size_t http_response_bytes(const char *response, size_t len) {
+    const char *end = g_strstr_len(response, (gssize)len, "\r\n\r\n");
+    if (!end) {
+        return len;
+    }
+    size_t head_len = (size_t)(end - response) + 4;
+    const char *cl = g_strstr_len(response, (gssize)head_len, "\r\nContent-Length:");
+    if (!cl) {
+        return len;
+    }
+    return head_len + strtoul(cl + 17, NULL, 10);
+}
+
+void http_server_observe(const char *route, const struct mg_addr *rem, struct mg_http_message *hm,
+                         const char *response, size_t len, gint64 start_us) {
+    char status[8] = "0";
+
+    /* 状态行 "HTTP/1.1 200 OK" */
+    if (len >= 12 && memcmp(response, "HTTP/1.", 7) == 0) {
+        memcpy(status, response + 9, 3);
+        status[3] = '\0';
+    }
+    metrics_observe(METRIC_HTTP_REQUEST_DURATION, route, status, start_us);
+    access_log_record(rem, hm->method, hm->uri, atoi(status),
+                      http_response_bytes(response, len), start_us);
+}
+
+void http_server_timing_insert(struct mg_iobuf *send, size_t offset, gint64 start_us) {
+    GString *value = g_string_new(NULL);
+
+    metrics_trace_end(value);
+    g_string_append_printf(value, "%stotal;dur=%.2f", value->len ? ", " : "",
+                           (double)(g_get_monotonic_time() - start_us) / 1000.0);
+
+    /* 插在响应头的空行之前 */
+    const char *head = (const char *)send->buf + offset;
+    size_t len = send->len - offset;
+    for (size_t i = 0; i + 4 <= len; i++) {
+        if (memcmp(head + i, "\r\n\r\n", 4) == 0) {
+            char *line = g_strdup_printf("Server-Timing: %s\r\nTiming-Allow-Origin: *\r\n", value->str);
+            mg_iobuf_add(send, offset + i + 2, line, strlen(line));
+            g_free(line);
+            break;
         }
     }
+    g_string_free(value, TRUE);
 }
 
+struct mg_connection *http_server_find_conn(unsigned long id) {
+    for (struct mg_connection *c = g_mgr.conns; c != NULL; c = c->next) {
+        if (c->id == id) {
+            return c->is_closing ? NULL : c;
+        }
+    }
+    return NULL;
+}
 
-int http_server_start(const char *port) {
+int http_server_start(const char *port, const char *web_root) {
     char listen_addr[64];
 
+    /* 编译路由表 */
+    if (router_init(g_routes, sizeof(g_routes) / sizeof(g_routes[0])) != 0) {
+        return -1;
+    }
+    http_cache_init();
+    packed_fs_init(web_root);
+
     /* 初始化 D-Bus */
     if (init_dbus() != 0) {
         printf("警告: D-Bus 初始化失败 (高级网络功能将不可用)\n");
@@ -391,6 +756,11 @@ int http_server_start(const char *port) {
         printf("警告: APN模块初始化失败\n");
     }
 
+    /* 连接限制 */
+    g_max_connections = config_get_int("http_max_connections", HTTP_MAX_CONNECTIONS_DEFAULT);
+    g_idle_timeout = config_get_int("http_idle_timeout", HTTP_IDLE_TIMEOUT_DEFAULT);
+    g_header_timeout = config_get_int("http_header_timeout", HTTP_HEADER_TIMEOUT_DEFAULT);
+
     /* 初始化 mongoose */
     mg_mgr_init(&g_mgr);
 
@@ -398,47 +768,147 @@ int http_server_start(const char *port) {
     snprintf(listen_addr, sizeof(listen_addr), "http://0.0.0.0:%s", port);
 
     /* 创建 HTTP 监听器 */
-    if (mg_http_listen(&g_mgr, listen_addr, http_handler, NULL) == NULL) {
+    struct mg_connection *listener = mg_http_listen(&g_mgr, listen_addr, http_handler, NULL);
+    if (listener == NULL) {
         printf("无法监听端口 %s\n", port);
         mg_mgr_free(&g_mgr);
         return -1;
     }
 
-    printf("Server starting on :%s\n", port);
-    g_running = 1;
+    events_init(&g_mgr);
+    g_timeout_timer = g_timeout_add_seconds(HTTP_TIMEOUT_CHECK_SEC, http_timeout_cb, NULL);
+
+    /* 启动阻塞请求工作线程池（失败时阻塞路由在事件循环中直接执行） */
+    if (http_worker_start(&g_mgr, listener->id,
+                          config_get_int("http_worker_max_jobs", HTTP_WORKER_MAX_JOBS_DEFAULT)) != 0) {
+        printf("警告: 工作线程池启动失败\n");
+    }
 
-    /* 设置信号处理 */
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
+    printf("Server starting on :%s (最大连接数 %d, 空闲超时 %ds, 请求头超时 %ds)\n",
+           port, g_max_connections, g_idle_timeout, g_header_timeout);
+
+    /* 设置信号处理（在主循环中处理，无需异步信号安全） */
+    g_unix_signal_add(SIGINT, on_quit_signal, NULL);
+    g_unix_signal_add(SIGTERM, on_quit_signal, NULL);
 
     return 0;
 }
 
 void http_server_stop(void) {
-    g_running = 0;
+    if (g_timeout_timer) {
+        g_source_remove(g_timeout_timer);
+        g_timeout_timer = 0;
+    }
+    http_worker_stop();
+    events_deinit();
     mg_mgr_free(&g_mgr);
+    router_deinit();
+    http_cache_deinit();
     sms_deinit();
+    db_deinit();
     close_dbus();
     printf("服务器已停止\n");
 }
 
-void http_server_run(void) {
-    GMainContext *context = g_main_context_default();
-    static int maintenance_counter = 0;
-    
-    while (g_running) {
-        /* 处理GLib/D-Bus事件 - 优先处理，确保信号不丢失 */
-        while (g_main_context_pending(context)) {
-            g_main_context_iteration(context, FALSE);
-        }
-        
-        /* 处理mongoose事件 - 减少超时时间以更快响应D-Bus信号 */
-        mg_mgr_poll(&g_mgr, 10);  /* 10ms超时 */
-        
-        /* 每30秒执行一次短信模块维护（检查D-Bus连接） */
-        if (++maintenance_counter >= 3000) {  /* 3000 * 10ms = 30秒 */
-            maintenance_counter = 0;
-            sms_maintenance();
+/*============================================================================
+ * mongoose 事件源
+ *
+ * 把 mongoose 挂到 GLib 主循环：Linux 下 mongoose 使用 epoll，
+ * 只需监听 mgr->epoll_fd，任一连接就绪时该描述符可读，再调用
+ * mg_mgr_poll(mgr, 0) 处理。进程在无I/O时完全休眠，D-Bus信号和
+ * HTTP请求都由同一个 poll 唤醒。
+ *============================================================================*/
+
+typedef struct {
+    GSource source;
+    struct mg_mgr *mgr;
+    gpointer fd_tag;
+    gint64 deadline;
+} MgSource;
+
+static gboolean mg_source_prepare(GSource *source, gint *timeout) {
+    MgSource *ms = (MgSource *)source;
+    int ms_wait = HTTP_POLL_IDLE_MS;
+
+    for (struct mg_connection *c = ms->mgr->conns; c != NULL; c = c->next) {
+        /* 待关闭连接立即处理 */
+        if (c->is_closing || (c->is_draining && c->send.len == 0)) {
+            ms_wait = 0;
+            break;
+        }
+#if MG_ENABLE_EPOLL
+        /* 在 mg_mgr_poll 之外写入的响应（DB/工作线程回调）需要关注可写事件 */
+        if (c->send.len > 0 && !c->is_listening && !c->is_udp) {
+            MG_EPOLL_MOD(c, 1);
+        }
+#endif
+        /* 已接收但尚未处理完的数据（流水线请求、异步回复后的下一个请求） */
+        if ((c->recv.len > 0 && c->is_accepted && !c->is_resp && !c->is_draining) ||
+            c->rtls.len > 0) {
+            ms_wait = MIN(ms_wait, HTTP_POLL_BUSY_MS);
         }
     }
+
+#if !MG_ENABLE_EPOLL
+    /* 无epoll时无法等待mongoose的套接字，退化为定时轮询 */
+    ms_wait = MIN(ms_wait, HTTP_POLL_BUSY_MS);
+#endif
+
+    ms->deadline = g_source_get_time(source) + (gint64)ms_wait * 1000;
+    *timeout = ms_wait;
+    return ms_wait == 0;
+}
+
+static gboolean mg_source_check(GSource *source) {
+    MgSource *ms = (MgSource *)source;
+
+    if (ms->fd_tag && g_source_query_unix_fd(source, ms->fd_tag) != 0) {
+        return TRUE;
+    }
+    return g_source_get_time(source) >= ms->deadline;
+}
+
+static gboolean mg_source_dispatch(GSource *source, GSourceFunc callback, gpointer user_data) {
+    MgSource *ms = (MgSource *)source;
+    (void)callback;
+    (void)user_data;
+
+    mg_mgr_poll(ms->mgr, 0);
+    return G_SOURCE_CONTINUE;
+}
+
+static GSourceFuncs g_mg_source_funcs = {
+    mg_source_prepare,
+    mg_source_check,
+    mg_source_dispatch,
+    NULL, NULL, NULL
+};
+
+static GSource *mg_source_new(struct mg_mgr *mgr) {
+    GSource *source = g_source_new(&g_mg_source_funcs, sizeof(MgSource));
+    MgSource *ms = (MgSource *)source;
+
+    ms->mgr = mgr;
+#if MG_ENABLE_EPOLL
+    if (mgr->epoll_fd >= 0) {
+        ms->fd_tag = g_source_add_unix_fd(source, mgr->epoll_fd, G_IO_IN | G_IO_ERR | G_IO_HUP);
+    }
+#endif
+    g_source_set_name(source, "mongoose");
+    return source;
+}
+
+void http_server_run(void) {
+    GSource *source = mg_source_new(&g_mgr);
+
+    g_source_attach(source, NULL);
+    g_main_loop = g_main_loop_new(NULL, FALSE);
+
+    /* 阻塞直到收到 SIGINT/SIGTERM */
+    g_main_loop_run(g_main_loop);
+
+    g_source_destroy(source);
+    g_source_unref(source);
+    g_main_loop_unref(g_main_loop);
+    g_main_loop = NULL;
 }
@@ -0,0 +1,325 @@
+/**
+ * @file http_worker.c
+ * @brief 阻塞型请求工作线程池实现
+ *
+ * 事件循环线程复制请求后入队，工作线程用一个只含发送缓冲的影子连接
+ * 执行原处理函数（处理函数只通过 mg_http_reply 写 c->send），
+ * 完成后把响应放入完成队列并 mg_wakeup 唤醒事件循环，
+ * 由事件循环线程按连接ID找回连接并发送；连接已关闭则丢弃响应。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <glib.h>
+#include "http_worker.h"
+#include "http_server.h"
+#include "http_utils.h"
+#include "http_cache.h"
+#include "events.h"
+#include "metrics.h"
+
+/* 请求任务 */
+typedef struct {
+    unsigned long conn_id;
+    char *request;                  /* 请求报文副本 */
+    struct mg_http_message hm;      /* 指向 request 的解析结果 */
+    const Route *route;
+    struct mg_iobuf response;       /* 处理函数写出的完整响应 */
+    int draining;                   /* 发送后关闭连接 */
+    gint64 start_us;                /* 入队时间，耗时统计含排队 */
+    struct mg_addr rem;             /* 客户端地址（访问日志） */
+    int timing;                     /* 响应附带 Server-Timing */
+    unsigned long cache_generation; /* 提交时的缓存失效计数 */
+    http_worker_fn_t fn;            /* 非NULL时代替 route->handler */
+    http_worker_done_t done;
+    void *arg;
+} HttpWorkerJob;
+
+static struct mg_mgr *g_worker_mgr = NULL;
+static unsigned long g_notify_id = 0;
+static pthread_t g_worker_threads[HTTP_WORKER_THREADS];
+static int g_worker_running = 0;
+
+/* 已提交但响应尚未交回事件循环的请求数（仅事件循环线程访问） */
+static int g_jobs_outstanding = 0;
+static int g_max_jobs = HTTP_WORKER_MAX_JOBS_DEFAULT;
+
+/* 待执行队列（环形缓冲），g_job_mutex 保护 */
+static pthread_mutex_t g_job_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_job_cond = PTHREAD_COND_INITIALIZER;
+static HttpWorkerJob *g_job_queue[HTTP_WORKER_QUEUE_SIZE];
+static int g_job_head = 0;
+static int g_job_count = 0;
+
+/* 完成队列，g_done_mutex 保护 */
+static pthread_mutex_t g_done_mutex = PTHREAD_MUTEX_INITIALIZER;
+static GQueue g_done_queue = G_QUEUE_INIT;
+
+/*============================================================================
+ * 内部函数
+ *============================================================================*/
+
+/**
+ * 将 mg_str 从原报文重定位到副本
+ */
+static void rebase_str(struct mg_str *s, const char *from, size_t len, char *to) {
+    if (s->buf && s->buf >= from && s->buf <= from + len) {
+        s->buf = to + (s->buf - from);
+    } else if (s->len == 0) {
+        s->buf = NULL;
+    }
+}
+
+static void http_worker_job_free(HttpWorkerJob *job) {
+    if (!job) return;
+    if (job->done) {
+        job->done(&job->hm, job->arg, 0);      /* 未交回即丢弃 */
+    }
+    mg_iobuf_free(&job->response);
+    free(job->request);
+    free(job);
+}
+
+/**
+ * 在工作线程中执行处理函数
+ */
+static void http_worker_execute(HttpWorkerJob *job) {
+    struct mg_connection shadow;
+
+    memset(&shadow, 0, sizeof(shadow));
+    shadow.id = job->conn_id;
+    shadow.is_accepted = 1;
+    shadow.send.align = MG_IO_SIZE;
+
+    if (job->timing) {
+        metrics_trace_begin();
+        metrics_span("queue", NULL, job->start_us);
+    }
+
+    if (job->fn) {
+        job->fn(&shadow, &job->hm, job->arg);
+    } else {
+        job->route->handler(&shadow, &job->hm);
+    }
+
+    if (shadow.send.len == 0 || shadow.is_closing) {
+        mg_iobuf_free(&shadow.send);
+        mg_http_reply(&shadow, 500, HTTP_CORS_HEADERS,
+                      "{\"Code\":1,\"Error\":\"请求处理失败\",\"Data\":null}");
+    }
+    if (job->timing) {
+        http_server_timing_insert(&shadow.send, 0, job->start_us);
+    }
+
+    job->response = shadow.send;
+    job->draining = shadow.is_draining;
+}
+
+static void *http_worker_thread_func(void *arg) {
+    (void)arg;
+
+    for (;;) {
+        pthread_mutex_lock(&g_job_mutex);
+        while (g_worker_running && g_job_count == 0) {
+            pthread_cond_wait(&g_job_cond, &g_job_mutex);
+        }
+        if (!g_worker_running) {
+            pthread_mutex_unlock(&g_job_mutex);
+            break;
+        }
+        HttpWorkerJob *job = g_job_queue[g_job_head];
+        g_job_head = (g_job_head + 1) % HTTP_WORKER_QUEUE_SIZE;
+        g_job_count--;
+        metrics_gauge_set(METRIC_HTTP_WORKER_QUEUE, g_job_count);
+        pthread_mutex_unlock(&g_job_mutex);
+
+        http_worker_execute(job);
+
+        pthread_mutex_lock(&g_done_mutex);
+        g_queue_push_tail(&g_done_queue, job);
+        pthread_mutex_unlock(&g_done_mutex);
+
+        /* 唤醒事件循环；唤醒失败时由监听连接的 MG_EV_POLL 兜底 */
+        mg_wakeup(g_worker_mgr, g_notify_id, "", 0);
+    }
+
+    return NULL;
+}
+
+/*============================================================================
+ * 公共接口
+ *============================================================================*/
+
+int http_worker_start(struct mg_mgr *mgr, unsigned long notify_id, int max_jobs) {
+    if (g_worker_running) {
+        return 0;
+    }
+
+    if (!mg_wakeup_init(mgr)) {
+        printf("[WORKER] 初始化唤醒管道失败\n");
+        return -1;
+    }
+
+    g_worker_mgr = mgr;
+    g_notify_id = notify_id;
+    g_max_jobs = max_jobs > 0 ? max_jobs : HTTP_WORKER_MAX_JOBS_DEFAULT;
+    g_worker_running = 1;
+
+    for (int i = 0; i < HTTP_WORKER_THREADS; i++) {
+        if (pthread_create(&g_worker_threads[i], NULL, http_worker_thread_func, NULL) != 0) {
+            printf("[WORKER] 创建工作线程失败\n");
+            http_worker_stop();
+            return -1;
+        }
+    }
+
+    printf("[WORKER] 工作线程池已启动: %d 线程, 未完成请求上限 %d\n", HTTP_WORKER_THREADS, g_max_jobs);
+    return 0;
+}
+
+void http_worker_stop(void) {
+    pthread_mutex_lock(&g_job_mutex);
+    if (!g_worker_running) {
+        pthread_mutex_unlock(&g_job_mutex);
+        return;
+    }
+    g_worker_running = 0;
+    pthread_cond_broadcast(&g_job_cond);
+    pthread_mutex_unlock(&g_job_mutex);
+
+    for (int i = 0; i < HTTP_WORKER_THREADS; i++) {
+        if (g_worker_threads[i]) {
+            pthread_join(g_worker_threads[i], NULL);
+            g_worker_threads[i] = 0;
+        }
+    }
+
+    /* 丢弃未执行和未发送的请求 */
+    while (g_job_count > 0) {
+        http_worker_job_free(g_job_queue[g_job_head]);
+        g_job_head = (g_job_head + 1) % HTTP_WORKER_QUEUE_SIZE;
+        g_job_count--;
+    }
+    pthread_mutex_lock(&g_done_mutex);
+    HttpWorkerJob *job;
+    while ((job = g_queue_pop_head(&g_done_queue)) != NULL) {
+        http_worker_job_free(job);
+    }
+    pthread_mutex_unlock(&g_done_mutex);
+    g_jobs_outstanding = 0;
+
+    printf("[WORKER] 工作线程池已停止\n");
+}
+
+int http_worker_submit(struct mg_connection *c, struct mg_http_message *hm,
+                       const Route *route) {
+    return http_worker_submit_call(c, hm, route, NULL, NULL, NULL);
+}
+
+int http_worker_submit_call(struct mg_connection *c, struct mg_http_message *hm, const Route *route,
+                            http_worker_fn_t fn, http_worker_done_t done, void *arg) {
+    if (!g_worker_running) {
+        return -1;
+    }
+    if (g_jobs_outstanding >= g_max_jobs) {
+        return -2;
+    }
+
+    HttpWorkerJob *job = calloc(1, sizeof(HttpWorkerJob));
+    if (!job) {
+        return -2;
+    }
+    job->request = malloc(hm->message.len + 1);
+    if (!job->request) {
+        free(job);
+        return -2;
+    }
+
+    /* 复制请求报文并重定位各字段 */
+    const char *base = hm->message.buf;
+    size_t len = hm->message.len;
+    memcpy(job->request, base, len);
+    job->request[len] = '\0';
+    job->hm = *hm;
+    rebase_str(&job->hm.method, base, len, job->request);
+    rebase_str(&job->hm.uri, base, len, job->request);
+    rebase_str(&job->hm.query, base, len, job->request);
+    rebase_str(&job->hm.proto, base, len, job->request);
+    for (int i = 0; i < MG_MAX_HTTP_HEADERS && job->hm.headers[i].name.len > 0; i++) {
+        rebase_str(&job->hm.headers[i].name, base, len, job->request);
+        rebase_str(&job->hm.headers[i].value, base, len, job->request);
+    }
+    rebase_str(&job->hm.body, base, len, job->request);
+    rebase_str(&job->hm.head, base, len, job->request);
+    rebase_str(&job->hm.message, base, len, job->request);
+
+    job->conn_id = c->id;
+    job->route = route;
+    job->start_us = g_get_monotonic_time();
+    job->rem = c->rem;
+    job->timing = mg_http_get_header(hm, HTTP_TIMING_REQUEST_HEADER) != NULL;
+    job->cache_generation = http_cache_generation();
+    job->fn = fn;
+    job->arg = arg;
+
+    pthread_mutex_lock(&g_job_mutex);
+    if (g_job_count >= HTTP_WORKER_QUEUE_SIZE) {
+        pthread_mutex_unlock(&g_job_mutex);
+        http_worker_job_free(job);
+        return -2;
+    }
+    job->done = done;      /* 入队后才负责调用 done，之前失败的由调用方自行清理 */
+    g_job_queue[(g_job_head + g_job_count) % HTTP_WORKER_QUEUE_SIZE] = job;
+    g_job_count++;
+    metrics_gauge_set(METRIC_HTTP_WORKER_QUEUE, g_job_count);
+    pthread_cond_signal(&g_job_cond);
+    pthread_mutex_unlock(&g_job_mutex);
+
+    g_jobs_outstanding++;
+
+    return 0;
+}
+
+void http_worker_deliver(void) {
+    for (;;) {
+        pthread_mutex_lock(&g_done_mutex);
+        HttpWorkerJob *job = g_queue_pop_head(&g_done_queue);
+        pthread_mutex_unlock(&g_done_mutex);
+        if (!job) {
+            break;
+        }
+        g_jobs_outstanding--;
+
+        /* 写操作完成后失效相关缓存（连接是否还在都要执行） */
+        http_cache_invalidate(job->route->invalidates);
+        events_invalidate(job->route->invalidates);
+
+        /* 可缓存的查询在这里写入响应缓存；执行期间有过失效则结果可能已过时，不缓存 */
+        int fresh = job->cache_generation == http_cache_generation();
+        if (job->done) {
+            job->done(&job->hm, job->arg, fresh);
+            job->done = NULL;
+        }
+        if (!job->timing && fresh) {
+            struct mg_connection tmp;
+            memset(&tmp, 0, sizeof(tmp));
+            tmp.send = job->response;
+            http_cache_store(&tmp, &job->hm, job->route, 0);
+            job->response = tmp.send;
+        }
+        http_server_observe(job->route->pattern, &job->rem, &job->hm,
+                            (const char *)job->response.buf, job->response.len, job->start_us);
+
+        struct mg_connection *c = http_server_find_conn(job->conn_id);
+        if (c) {
+            mg_send(c, job->response.buf, job->response.len);
+            c->is_resp = 0;     /* 响应结束，允许处理该连接的下一个请求 */
+            if (job->draining) {
+                c->is_draining = 1;
+            }
+        }
+        http_worker_job_free(job);
+    }
+}
@@ -0,0 +1,338 @@
+/**
+ * @file json_writer.c
+ * @brief JSON 流式写入器实现
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "json_writer.h"
+
+/*============================================================================
+ * 内部函数
+ *============================================================================*/
+
+/* 流式模式下缓冲达到分块大小时写入连接 */
+static void json_flush(JsonWriter *w, int force) {
+    if (!w->c || w->buf.len == 0) {
+        return;
+    }
+    if (force || w->buf.len >= JSON_WRITER_CHUNK_SIZE) {
+        mg_http_write_chunk(w->c, (const char *)w->buf.buf, w->buf.len);
+        w->buf.len = 0;
+    }
+}
+
+static void json_put(JsonWriter *w, const char *s, size_t len) {
+    if (w->error || len == 0) {
+        return;
+    }
+    if (mg_iobuf_add(&w->buf, w->buf.len, s, len) == 0) {
+        w->error = 1;
+        return;
+    }
+    json_flush(w, 0);
+}
+
+/* 写值之前：同层已有元素则加逗号 */
+static void json_before_value(JsonWriter *w) {
+    if (w->after_key) {
+        w->after_key = 0;
+        return;
+    }
+    if (w->depth > 0) {
+        if (w->has_items[w->depth - 1]) {
+            json_put(w, ",", 1);
+        }
+        w->has_items[w->depth - 1] = 1;
+    }
+}
+
+static void json_open(JsonWriter *w, char ch) {
+    json_before_value(w);
+    if (w->depth >= JSON_WRITER_MAX_DEPTH) {
+        w->error = 1;
+        return;
+    }
+    w->has_items[w->depth++] = 0;
+    json_put(w, &ch, 1);
+}
+
+static void json_close(JsonWriter *w, char ch) {
+    if (w->depth > 0) {
+        w->depth--;
+    }
+    json_put(w, &ch, 1);
+}
+
+/* 转义并写入字符串内容（不含引号），连续的普通字符整段写入 */
+static void json_put_escaped(JsonWriter *w, const char *s, size_t len) {
+    size_t start = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        unsigned char ch = (unsigned char)s[i];
+        const char *esc = NULL;
+        char hex[8];
+
+        switch (ch) {
+            case '"':  esc = "\\\""; break;
+            case '\\': esc = "\\\\"; break;
+            case '\n': esc = "\\n"; break;
+            case '\r': esc = "\\r"; break;
+            case '\t': esc = "\\t"; break;
+            default:
+                if (ch < 0x20) {
+                    snprintf(hex, sizeof(hex), "\\u%04x", ch);
+                    esc = hex;
+                }
+                break;
+        }
+
+        if (esc) {
+            json_put(w, s + start, i - start);
+            json_put(w, esc, strlen(esc));
+            start = i + 1;
+        }
+    }
+    json_put(w, s + start, len - start);
+}
+
+/*============================================================================
+ * 生命周期
+ *============================================================================*/
+
+void json_writer_init(JsonWriter *w) {
+    memset(w, 0, sizeof(*w));
+    w->buf.align = 1024;
+}
+
+void json_writer_reply(JsonWriter *w, struct mg_connection *c, int status, const char *headers) {
+    if (w->c && w->error) {
+        /* 状态行已发出：不写结束分块直接关闭，客户端能看出传输不完整 */
+        w->c->is_draining = 1;
+    } else if (w->c) {
+        json_flush(w, 1);
+        mg_http_write_chunk(w->c, "", 0);
+    } else if (w->error) {
+        mg_http_reply(c, 500, headers, "{\"error\":\"内存不足\"}");
+    } else {
+        mg_http_reply(c, status, headers, "%.*s", (int)w->buf.len, (const char *)w->buf.buf);
+    }
+    json_writer_free(w);
+}
+
+void json_writer_free(JsonWriter *w) {
+    mg_iobuf_free(&w->buf);
+}
+
+/*============================================================================
+ * 流式响应
+ *
+ * 进行中的流式响应挂在链表上（只在主循环访问），按连接ID查找。
+ * 同一时刻一般只有一两个，线性查找即可
+ *============================================================================*/
+
+typedef struct JsonStream {
+    unsigned long conn_id;
+    JsonWriter w;
+    json_writer_fill_t fill;
+    void (*free_arg)(void *);
+    void *arg;
+    struct JsonStream *next;
+} JsonStream;
+
+static JsonStream *g_streams = NULL;
+
+static JsonStream **stream_find(unsigned long conn_id) {
+    JsonStream **pp = &g_streams;
+    while (*pp && (*pp)->conn_id != conn_id) {
+        pp = &(*pp)->next;
+    }
+    return pp;
+}
+
+static void stream_free(JsonStream *s) {
+    json_writer_free(&s->w);
+    if (s->free_arg) {
+        s->free_arg(s->arg);
+    }
+    free(s);
+}
+
+/**
+ * 生成到发送缓冲达到水位或写完
+ * @param limit 发送缓冲水位，0表示一直生成到写完
+ * @return 1已结束（已发结束分块或因出错关闭连接）, 0还有后续
+ */
+static int stream_fill(JsonStream *s, size_t limit) {
+    int done = 0;
+
+    while (!done && !s->w.error && (limit == 0 || s->w.c->send.len < limit)) {
+        done = s->fill(&s->w, s->arg);
+    }
+    if (done || s->w.error) {
+        json_writer_reply(&s->w, s->w.c, 200, NULL);
+        return 1;
+    }
+    json_flush(&s->w, 1);
+    return 0;
+}
+
+void json_writer_stream(struct mg_connection *c, const char *headers,
+                        json_writer_fill_t fill, void (*free_arg)(void *), void *arg) {
+    JsonStream *s = (JsonStream *)calloc(1, sizeof(JsonStream));
+
+    if (!s) {
+        mg_http_reply(c, 500, headers, "{\"error\":\"内存不足\"}");
+        if (free_arg) {
+            free_arg(arg);
+        }
+        return;
+    }
+    json_writer_init(&s->w);
+    s->w.c = c;
+    s->conn_id = c->id;
+    s->fill = fill;
+    s->free_arg = free_arg;
+    s->arg = arg;
+    mg_printf(c, "HTTP/1.1 200 OK\r\n%sTransfer-Encoding: chunked\r\n\r\n",
+              headers ? headers : "");
+
+    /* 影子连接不会收到后续事件 */
+    if (stream_fill(s, c->is_accepted ? JSON_WRITER_CHUNK_SIZE : 0)) {
+        stream_free(s);
+        return;
+    }
+    s->next = g_streams;
+    g_streams = s;
+}
+
+void json_writer_pump(struct mg_connection *c) {
+    if (!g_streams || c->send.len >= JSON_WRITER_CHUNK_SIZE) {
+        return;
+    }
+    JsonStream **pp = stream_find(c->id);
+    JsonStream *s = *pp;
+    if (s && stream_fill(s, JSON_WRITER_CHUNK_SIZE)) {
+        *pp = s->next;
+        stream_free(s);
+    }
+}
+
+void json_writer_abort(struct mg_connection *c) {
+    if (!g_streams) {
+        return;
+    }
+    JsonStream **pp = stream_find(c->id);
+    JsonStream *s = *pp;
+    if (s) {
+        *pp = s->next;
+        stream_free(s);
+    }
+}
+
+/*============================================================================
+ * 结构
+ *============================================================================*/
+
+void json_begin_object(JsonWriter *w) { json_open(w, '{'); }
+void json_end_object(JsonWriter *w)   { json_close(w, '}'); }
+void json_begin_array(JsonWriter *w)  { json_open(w, '['); }
+void json_end_array(JsonWriter *w)    { json_close(w, ']'); }
+
+void json_key(JsonWriter *w, const char *key) {
+    json_before_value(w);
+    json_put(w, "\"", 1);
+    json_put_escaped(w, key, strlen(key));
+    json_put(w, "\":", 2);
+    w->after_key = 1;
+}
+
+/*============================================================================
+ * 值
+ *============================================================================*/
+
+void json_string(JsonWriter *w, const char *s) {
+    if (!s) {
+        json_null(w);
+        return;
+    }
+    json_string_n(w, s, strlen(s));
+}
+
+void json_string_n(JsonWriter *w, const char *s, size_t len) {
+    json_string_begin(w);
+    json_string_append(w, s, len);
+    json_string_end(w);
+}
+
+void json_string_begin(JsonWriter *w) {
+    json_before_value(w);
+    json_put(w, "\"", 1);
+}
+
+void json_string_append(JsonWriter *w, const char *s, size_t len) {
+    json_put_escaped(w, s, len);
+}
+
+void json_string_end(JsonWriter *w) {
+    json_put(w, "\"", 1);
+}
+
+void json_int(JsonWriter *w, long long v) {
+    char num[32];
+    int n = snprintf(num, sizeof(num), "%lld", v);
+    json_before_value(w);
+    json_put(w, num, (size_t)n);
+}
+
+void json_double(JsonWriter *w, double v, int decimals) {
+    char num[64];
+    int n = snprintf(num, sizeof(num), "%.*f", decimals, v);
+    json_before_value(w);
+    if (n <= 0 || n >= (int)sizeof(num) || !isfinite(v)) {
+        json_put(w, "null", 4);     /* NaN/Infinity/溢出不是合法JSON数字 */
+        return;
+    }
+    json_put(w, num, (size_t)n);
+}
+
+void json_bool(JsonWriter *w, int v) {
+    json_before_value(w);
+    json_put(w, v ? "true" : "false", v ? 4 : 5);
+}
+
+void json_null(JsonWriter *w) {
+    json_before_value(w);
+    json_put(w, "null", 4);
+}
+
+void json_raw(JsonWriter *w, const char *json) {
+    json_before_value(w);
+    json_put(w, json, strlen(json));
+}
+
+/*============================================================================
+ * 键值便捷写法
+ *============================================================================*/
+
+void json_kv_string(JsonWriter *w, const char *key, const char *s) {
+    json_key(w, key);
+    json_string(w, s);
+}
+
+void json_kv_int(JsonWriter *w, const char *key, long long v) {
+    json_key(w, key);
+    json_int(w, v);
+}
+
+void json_kv_double(JsonWriter *w, const char *key, double v, int decimals) {
+    json_key(w, key);
+    json_double(w, v, decimals);
+}
+
+void json_kv_bool(JsonWriter *w, const char *key, int v) {
+    json_key(w, key);
+    json_bool(w, v);
+}
@@ -0,0 +1,194 @@
+/**
+ * @file router.c
+ * @brief HTTP 路由表实现
+ *
+ * 路由按 '/' 分段插入前缀树，每个节点以哈希表索引字面量子段，
+ * 另有一个 "*" 通配子节点。匹配时逐段查表，耗时与路径长度成正比，
+ * 与路由数量无关。字面量优先于通配，失败时回溯到通配分支。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include "router.h"
+
+/* 路由节点 */
+typedef struct RouteNode {
+    GHashTable *children;           /* 段名 -> RouteNode */
+    struct RouteNode *wildcard;     /* "*" 段 */
+    GPtrArray *routes;              /* 终止于本节点的路由（声明顺序） */
+} RouteNode;
+
+static RouteNode *g_root = NULL;
+
+/*============================================================================
+ * 前缀树构建
+ *============================================================================*/
+
+static RouteNode *route_node_new(void) {
+    RouteNode *node = g_new0(RouteNode, 1);
+    node->children = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    node->routes = g_ptr_array_new();
+    return node;
+}
+
+static void route_node_free(RouteNode *node) {
+    if (!node) return;
+
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, node->children);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        route_node_free((RouteNode *)value);
+    }
+    g_hash_table_destroy(node->children);
+    route_node_free(node->wildcard);
+    g_ptr_array_free(node->routes, TRUE);
+    g_free(node);
+}
+
+static int route_insert(const Route *route) {
+    const char *p = route->pattern;
+    RouteNode *node = g_root;
+
+    if (!p || p[0] != '/' || !route->handler) {
+        printf("[ROUTER] 无效路由: %s\n", p ? p : "(null)");
+        return -1;
+    }
+
+    while (*p == '/') {
+        const char *seg = ++p;
+        while (*p && *p != '/') p++;
+        size_t len = (size_t)(p - seg);
+
+        if (len == 1 && seg[0] == '*') {
+            if (!node->wildcard) {
+                node->wildcard = route_node_new();
+            }
+            node = node->wildcard;
+        } else {
+            char *key = g_strndup(seg, len);
+            RouteNode *child = g_hash_table_lookup(node->children, key);
+            if (!child) {
+                child = route_node_new();
+                g_hash_table_insert(node->children, key, child);
+            } else {
+                g_free(key);
+            }
+            node = child;
+        }
+    }
+
+    g_ptr_array_add(node->routes, (gpointer)route);
+    return 0;
+}
+
+int router_init(const Route *routes, size_t count) {
+    router_deinit();
+    g_root = route_node_new();
+
+    for (size_t i = 0; i < count; i++) {
+        if (route_insert(&routes[i]) != 0) {
+            router_deinit();
+            return -1;
+        }
+    }
+
+    printf("[ROUTER] 已编译 %zu 条路由\n", count);
+    return 0;
+}
+
+void router_deinit(void) {
+    route_node_free(g_root);
+    g_root = NULL;
+}
+
+/*============================================================================
+ * 匹配
+ *============================================================================*/
+
+unsigned int router_method_bit(struct mg_str method) {
+    switch (method.len) {
+        case 3:
+            if (memcmp(method.buf, "GET", 3) == 0) return ROUTE_GET;
+            if (memcmp(method.buf, "PUT", 3) == 0) return ROUTE_PUT;
+            break;
+        case 4:
+            if (memcmp(method.buf, "POST", 4) == 0) return ROUTE_POST;
+            break;
+        case 6:
+            if (memcmp(method.buf, "DELETE", 6) == 0) return ROUTE_DELETE;
+            break;
+        case 7:
+            if (memcmp(method.buf, "OPTIONS", 7) == 0) return ROUTE_OPTIONS;
+            break;
+    }
+    return ROUTE_OTHER;
+}
+
+/**
+ * 从 path（指向某段起始）开始匹配剩余路径
+ * @return 终止节点（含路由），NULL未匹配
+ */
+static RouteNode *route_node_match(RouteNode *node, const char *path, const char *end,
+                                   struct mg_str *param) {
+    const char *seg_end = path;
+    char key[256];
+
+    while (seg_end < end && *seg_end != '/') seg_end++;
+    size_t len = (size_t)(seg_end - path);
+    int last = seg_end >= end;
+
+    /* 字面量子段 */
+    if (len < sizeof(key)) {
+        memcpy(key, path, len);
+        key[len] = '\0';
+        RouteNode *child = g_hash_table_lookup(node->children, key);
+        if (child) {
+            RouteNode *found = last ? (child->routes->len > 0 ? child : NULL)
+                                    : route_node_match(child, seg_end + 1, end, param);
+            if (found) return found;
+        }
+    }
+
+    /* 通配子段 */
+    if (node->wildcard) {
+        RouteNode *found = last ? (node->wildcard->routes->len > 0 ? node->wildcard : NULL)
+                                : route_node_match(node->wildcard, seg_end + 1, end, param);
+        if (found) {
+            if (param->len == 0) {
+                *param = mg_str_n(path, len);
+            }
+            return found;
+        }
+    }
+
+    return NULL;
+}
+
+int router_match(struct mg_str uri, struct mg_str method, RouteMatch *match) {
+    match->route = NULL;
+    match->param = mg_str_n(NULL, 0);
+
+    if (!g_root || uri.len == 0 || uri.buf[0] != '/') {
+        return 404;
+    }
+
+    RouteNode *node = route_node_match(g_root, uri.buf + 1, uri.buf + uri.len, &match->param);
+    if (!node) {
+        match->param = mg_str_n(NULL, 0);
+        return 404;
+    }
+
+    unsigned int bit = router_method_bit(method);
+    for (guint i = 0; i < node->routes->len; i++) {
+        const Route *route = g_ptr_array_index(node->routes, i);
+        if (route->methods & bit) {
+            match->route = route;
+            return 0;
+        }
+    }
+
+    return 405;
+}
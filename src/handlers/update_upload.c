@@ -0,0 +1,285 @@
+/**
+ * @file update_upload.c
+ * @brief 更新包流式上传实现
+ *
+ * multipart 解析只保留一个固定大小的缓冲：收到的数据追加进缓冲后解析，
+ * 文件内容写出，只把可能是分隔符前半部分的末尾字节留到下一次。
+ * 请求体前补 "\r\n"，使第一个分隔符和之后的分隔符都是 "\r\n--boundary"。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/statvfs.h>
+#include <glib.h>
+#include "update_upload.h"
+#include "update.h"
+#include "sha256.h"
+#include "http_server.h"
+#include "http_utils.h"
+
+typedef enum {
+    UPLOAD_BODY,        /* 部分内容（含第一个分隔符之前的前导内容），查找分隔符 */
+    UPLOAD_DELIM,       /* 分隔符之后："\r\n" 开始下一部分，"--" 结束 */
+    UPLOAD_HEADERS,     /* 部分头，查找空行 */
+    UPLOAD_DONE,        /* 更新包已写完，忽略剩余内容 */
+} UploadState;
+
+typedef struct {
+    UploadState state;
+    int in_file;                /* 当前部分是更新包 */
+    int has_file;               /* 更新包已完整收到 */
+    FILE *fp;
+    SHA256_CTX sha;
+    size_t size;
+    char delim[80];             /* "\r\n--" + boundary */
+    size_t delim_len;
+    char buf[UPDATE_UPLOAD_BUF_SIZE];
+    size_t len;
+} UpdateUpload;
+
+/* 同一时间只有一个上传（都写入 UPDATE_ZIP_PATH） */
+static UpdateUpload *g_upload = NULL;
+
+/*============================================================================
+ * 内部函数
+ *============================================================================*/
+
+static const char *upload_find(const char *buf, size_t len, const char *pat, size_t pat_len) {
+    while (len >= pat_len) {
+        const char *p = memchr(buf, pat[0], len - pat_len + 1);
+        if (p == NULL) {
+            return NULL;
+        }
+        if (memcmp(p, pat, pat_len) == 0) {
+            return p;
+        }
+        len -= (size_t)(p - buf) + 1;
+        buf = p + 1;
+    }
+    return NULL;
+}
+
+/* 部分头中带非空文件名即为文件 */
+static int upload_is_file(const char *headers, size_t len) {
+    char *lower = g_ascii_strdown(headers, (gssize)len);
+    const char *name = strstr(lower, "filename=");
+    int is_file = name != NULL && name[9] != '\0' && name[9] != ';' &&
+                  strncmp(name + 9, "\"\"", 2) != 0;
+
+    g_free(lower);
+    return is_file;
+}
+
+static void upload_free(UpdateUpload *u, int remove_file) {
+    if (u->fp) {
+        fclose(u->fp);
+    }
+    if (remove_file && (u->fp || u->has_file)) {
+        unlink(UPDATE_ZIP_PATH);
+    }
+    if (g_upload == u) {
+        g_upload = NULL;
+    }
+    g_free(u);
+}
+
+static int upload_write(UpdateUpload *u, const char *data, size_t len) {
+    if (!u->in_file || len == 0) {
+        return 0;
+    }
+    if (fwrite(data, 1, len, u->fp) != len) {
+        return -1;
+    }
+    sha256_update(&u->sha, (const uint8_t *)data, len);
+    u->size += len;
+    return 0;
+}
+
+/**
+ * 解析缓冲中的数据，处理完的从缓冲删除
+ * @return 0成功（数据不足时等待更多）, -1写文件失败, -2格式错误
+ */
+static int upload_parse(UpdateUpload *u) {
+    size_t pos = 0;
+
+    while (pos < u->len && u->state != UPLOAD_DONE) {
+        const char *p = u->buf + pos;
+        size_t n = u->len - pos;
+
+        if (u->state == UPLOAD_BODY) {
+            const char *d = upload_find(p, n, u->delim, u->delim_len);
+            if (d == NULL) {
+                /* 末尾可能是分隔符的前半部分，留到下次 */
+                size_t keep = MIN(n, u->delim_len - 1);
+                if (upload_write(u, p, n - keep) != 0) {
+                    return -1;
+                }
+                pos += n - keep;
+                break;
+            }
+            if (upload_write(u, p, (size_t)(d - p)) != 0) {
+                return -1;
+            }
+            pos += (size_t)(d - p) + u->delim_len;
+            if (u->in_file) {
+                u->in_file = 0;
+                u->has_file = 1;
+                u->state = UPLOAD_DONE;
+            } else {
+                u->state = UPLOAD_DELIM;
+            }
+        } else if (u->state == UPLOAD_DELIM) {
+            if (n < 2) {
+                break;
+            }
+            if (memcmp(p, "--", 2) == 0) {
+                u->state = UPLOAD_DONE;         /* 结束分隔符，没有更新包 */
+            } else if (memcmp(p, "\r\n", 2) == 0) {
+                u->state = UPLOAD_HEADERS;      /* 保留 "\r\n"，没有头的部分也能匹配到空行 */
+            } else {
+                return -2;
+            }
+        } else {
+            const char *e = upload_find(p, n, "\r\n\r\n", 4);
+            if (e == NULL) {
+                break;
+            }
+            if (upload_is_file(p, (size_t)(e - p))) {
+                update_cleanup();
+                u->fp = fopen(UPDATE_ZIP_PATH, "wb");
+                if (u->fp == NULL) {
+                    return -1;
+                }
+                u->in_file = 1;
+            }
+            pos += (size_t)(e - p) + 4;
+            u->state = UPLOAD_BODY;
+        }
+    }
+
+    if (u->state == UPLOAD_DONE) {
+        pos = u->len;
+    }
+    memmove(u->buf, u->buf + pos, u->len - pos);
+    u->len -= pos;
+    return 0;
+}
+
+static int upload_fail(struct mg_connection *c, UpdateUpload *u, int code, const char *message) {
+    printf("更新包上传失败: %s\n", message);
+    HTTP_ERROR(c, code, message);
+    upload_free(u, 1);
+    return -1;
+}
+
+static int upload_data(struct mg_connection *c, UpdateUpload *u, struct mg_str data) {
+    while (data.len > 0) {
+        size_t n = MIN(data.len, sizeof(u->buf) - u->len);
+
+        memcpy(u->buf + u->len, data.buf, n);
+        u->len += n;
+        data.buf += n;
+        data.len -= n;
+
+        int ret = upload_parse(u);
+        if (ret == 0 && u->len == sizeof(u->buf)) {
+            ret = -2;                           /* 部分头超出缓冲 */
+        }
+        if (ret == -1) {
+            return upload_fail(c, u, 500, "写入文件失败");
+        }
+        if (ret != 0) {
+            return upload_fail(c, u, 400, "上传数据格式错误");
+        }
+    }
+    return 0;
+}
+
+static void upload_end(struct mg_connection *c, UpdateUpload *u) {
+    char hex[SHA256_HEX_SIZE];
+    char json[192];
+
+    if (!u->has_file) {
+        upload_fail(c, u, 400, u->in_file ? "上传数据不完整" : "未找到上传文件");
+        return;
+    }
+
+    int ret = fclose(u->fp);
+    u->fp = NULL;
+    if (ret != 0) {
+        upload_fail(c, u, 500, "写入文件失败");
+        return;
+    }
+
+    sha256_final_hex(&u->sha, hex);
+    printf("更新包上传成功: %lu bytes, sha256 %s\n", (unsigned long)u->size, hex);
+    snprintf(json, sizeof(json),
+             "{\"status\":\"success\",\"message\":\"上传成功\",\"size\":%lu,\"sha256\":\"%s\"}",
+             (unsigned long)u->size, hex);
+    HTTP_OK(c, json);
+    upload_free(u, 0);
+}
+
+static int upload_stream_cb(struct mg_connection *c, HttpStreamEvent ev, struct mg_str data, void *arg) {
+    UpdateUpload *u = (UpdateUpload *)arg;
+
+    switch (ev) {
+    case HTTP_STREAM_DATA:
+        return upload_data(c, u, data);
+    case HTTP_STREAM_END:
+        upload_end(c, u);
+        return 1;
+    case HTTP_STREAM_ABORT:
+    default:
+        printf("更新包上传中断: 已收到 %lu bytes\n", (unsigned long)u->size);
+        upload_free(u, 1);
+        return 1;
+    }
+}
+
+/*============================================================================
+ * 公共接口
+ *============================================================================*/
+
+/* POST /api/update/upload - 上传更新包（请求头收全时调用，见 ROUTE_F_STREAM） */
+void handle_update_upload(struct mg_connection *c, struct mg_http_message *hm) {
+    HTTP_CHECK_POST(c, hm);
+
+    struct mg_str *ct = mg_http_get_header(hm, "Content-Type");
+    struct mg_str *cl = mg_http_get_header(hm, "Content-Length");
+    struct mg_str boundary = ct ? mg_http_get_header_var(*ct, mg_str("boundary")) : mg_str_n(NULL, 0);
+    size_t total = 0;
+    struct statvfs vfs;
+
+    if (boundary.len == 0 || boundary.len > 70) {
+        HTTP_ERROR(c, 400, "请使用 multipart/form-data 上传");
+        return;
+    }
+    if (cl == NULL || !mg_str_to_num(*cl, 10, &total, sizeof(total))) {
+        HTTP_ERROR(c, 411, "缺少 Content-Length");
+        return;
+    }
+    if (g_upload != NULL) {
+        HTTP_ERROR(c, 409, "已有更新包正在上传");
+        return;
+    }
+    /* 剩余空间放不下整个请求体时不开始接收 */
+    if (statvfs(UPDATE_TMP_DIR, &vfs) == 0 && (guint64)vfs.f_bavail * vfs.f_frsize < total) {
+        HTTP_ERROR(c, 507, "存储空间不足");
+        return;
+    }
+
+    UpdateUpload *u = g_new0(UpdateUpload, 1);
+    u->state = UPLOAD_BODY;
+    sha256_init(&u->sha);
+    u->delim_len = (size_t)snprintf(u->delim, sizeof(u->delim), "\r\n--%.*s",
+                                    (int)boundary.len, boundary.buf);
+    memcpy(u->buf, "\r\n", 2);
+    u->len = 2;
+    g_upload = u;
+
+    printf("开始接收更新包: %lu bytes\n", (unsigned long)total);
+    http_server_stream(c, hm, upload_stream_cb, u);
+}
@@ -0,0 +1,54 @@
+/**
+ * @file access_log.h
+ * @brief 内存访问日志 - 固定容量环形缓冲 + GET /api/debug/access-log
+ *
+ * 每个请求在写出响应处记录一条（时间、客户端地址、方法、路径、状态码、字节数、耗时），
+ * 只写内存不落盘，写满后覆盖最旧的记录。
+ * 写入无锁：先原子递增序号占位，再写字段，最后发布序号；
+ * 读取时记录前后序号不一致（正被覆盖）的条目跳过。
+ * 路径不含查询串（查询串中可能有 token）。
+ */
+
+#ifndef ACCESS_LOG_H
+#define ACCESS_LOG_H
+
+#include <stddef.h>
+#include <glib.h>
+#include "mongoose.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 环形缓冲容量（条，须为2的幂） */
+#define ACCESS_LOG_SIZE 512
+
+/* 记录的路径最大长度（超出截断） */
+#define ACCESS_LOG_PATH_MAX 64
+
+/* 查询默认/最大返回条数 */
+#define ACCESS_LOG_DEFAULT_LIMIT 100
+
+/**
+ * 记录一次请求
+ * @param rem 客户端地址
+ * @param method 请求方法
+ * @param uri 请求路径
+ * @param status 响应状态码
+ * @param bytes 响应字节数
+ * @param start_us 收到请求的时间（g_get_monotonic_time）
+ */
+void access_log_record(const struct mg_addr *rem, struct mg_str method, struct mg_str uri,
+                       int status, size_t bytes, gint64 start_us);
+
+/**
+ * GET /api/debug/access-log - 查询访问日志（新的在前）
+ * 参数：status=404 或 5xx，prefix=/api/sms，min_ms=100，limit=100
+ */
+void handle_access_log(struct mg_connection *c, struct mg_http_message *hm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ACCESS_LOG_H */
@@ -0,0 +1,35 @@
+/**
+ * @file batch.h
+ * @brief 批量只读请求 - POST /api/batch
+ *
+ * 请求体 {"requests":["/api/info","/api/data",...]}，每项是一个 GET 子请求路径（可带查询串）。
+ * 只有路由表中标记了 ROUTE_F_BATCH 的只读查询可以批量执行，其他路由该项返回 status 400。
+ * Token 只验证一次，有GET缓存的路由先查缓存；非阻塞的子请求在事件循环中执行，
+ * 阻塞型（ROUTE_F_BLOCKING，调制解调器查询）的子请求一起转交工作线程，
+ * 在同一个查询作用域内共享调制解调器状态（见 modem_query_scope_begin）。
+ * 响应是以子请求路径为键的对象：{"/api/info":{"status":200,"body":{...}},...}
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "mongoose.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 单次批量请求的子请求数量上限 */
+#define BATCH_MAX_REQUESTS 16
+
+/* 子请求路径最大长度（含查询串） */
+#define BATCH_MAX_PATH 256
+
+/* POST /api/batch - 批量执行只读请求 */
+void handle_batch(struct mg_connection *c, struct mg_http_message *hm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BATCH_H */
@@ -0,0 +1,55 @@
+/**
+ * @file events.h
+ * @brief 服务器推送事件 (SSE) - GET /api/events
+ *
+ * 客户端通过 ?topics=sysinfo,signal 订阅主题（缺省为全部），每个主题对应一个
+ * GET 路由；有订阅者时服务端按主题周期在事件循环中调用一次该路由的处理函数，
+ * 响应体与上次不同时才以 "event: <主题>" 推送给所有订阅者，
+ * 新订阅者立即收到最近一次的值。
+ * 写操作路由的 invalidates 与 events_invalidate 触发相关主题立即重新采样。
+ * 仅限事件循环线程调用，不加锁。
+ */
+
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include "mongoose.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 心跳间隔（秒），保持连接并及时发现断开的客户端 */
+#define EVENTS_HEARTBEAT_SEC 15
+
+/* 客户端断线重连等待时间（毫秒），随流首部的 retry: 下发 */
+#define EVENTS_RETRY_MS 3000
+
+/* 单个订阅连接未发出数据的上限（字节），超出视为客户端失效并断开 */
+#define EVENTS_MAX_BACKLOG (64 * 1024)
+
+/**
+ * 初始化事件推送
+ * @param mgr 订阅连接所在的 mongoose 管理器
+ */
+void events_init(struct mg_mgr *mgr);
+
+/**
+ * 停止所有采样和心跳定时器并释放缓存的值
+ */
+void events_deinit(void);
+
+/**
+ * 路径以任一前缀开头的主题立即重新采样（有订阅者时）
+ * @param prefixes 空格分隔的路径前缀，可为NULL
+ */
+void events_invalidate(const char *prefixes);
+
+/* GET /api/events - 建立事件流 */
+void handle_events(struct mg_connection *c, struct mg_http_message *hm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENTS_H */
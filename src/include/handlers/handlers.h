@@ -21,11 +21,13 @@ void handle_airplane_mode(struct mg_connection *c, struct mg_http_message *hm);
 void handle_device_control(struct mg_connection *c, struct mg_http_message *hm);
 void handle_clear_cache(struct mg_connection *c, struct mg_http_message *hm);
 void handle_get_current_band(struct mg_connection *c, struct mg_http_message *hm);
+void handle_metrics(struct mg_connection *c, struct mg_http_message *hm);
 
 /* 短信 API */
 void handle_sms_list(struct mg_connection *c, struct mg_http_message *hm);
 void handle_sms_send(struct mg_connection *c, struct mg_http_message *hm);
 void handle_sms_delete(struct mg_connection *c, struct mg_http_message *hm);
+void handle_sms_state(struct mg_connection *c, struct mg_http_message *hm);
 void handle_sms_webhook_get(struct mg_connection *c, struct mg_http_message *hm);
 void handle_sms_webhook_save(struct mg_connection *c, struct mg_http_message *hm);
 void handle_sms_webhook_test(struct mg_connection *c, struct mg_http_message *hm);
@@ -38,7 +40,6 @@ void handle_sms_fix_set(struct mg_connection *c, struct mg_http_message *hm);
 
 /* OTA更新 API */
 void handle_update_version(struct mg_connection *c, struct mg_http_message *hm);
-void handle_update_upload(struct mg_connection *c, struct mg_http_message *hm);
 void handle_update_download(struct mg_connection *c, struct mg_http_message *hm);
 void handle_update_extract(struct mg_connection *c, struct mg_http_message *hm);
 void handle_update_install(struct mg_connection *c, struct mg_http_message *hm);
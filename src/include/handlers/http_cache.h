@@ -0,0 +1,92 @@
+/**
+ * @file http_cache.h
+ * @brief GET 响应缓存 - 按路由TTL缓存幂等查询的完整响应
+ *
+ * 路由表中 cache_ttl > 0 的路由，其 GET 200 响应按“路径?查询串”缓存，
+ * 在TTL内直接返回，并附带 Cache-Control/Age 响应头；
+ * 写操作路由通过 invalidates 声明要失效的路径前缀。
+ *
+ * 带 ROUTE_F_ETAG 的路由按资源版本号生成弱ETag（W/"启动标识-版本号"），
+ * 版本号在 invalidates 前缀匹配到该路由模式时递增；
+ * 请求的 If-None-Match 与当前ETag一致时直接回复304，不调用处理函数。
+ * 这类路由的响应只能由声明了失效前缀的写操作改变，不能依赖查询串，也不设 cache_ttl。
+ *
+ * 仅限事件循环线程调用，不加锁。
+ */
+
+#ifndef HTTP_CACHE_H
+#define HTTP_CACHE_H
+
+#include <stddef.h>
+#include "mongoose.h"
+#include "router.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 最多缓存的响应数量，超出时淘汰最旧的 */
+#define HTTP_CACHE_MAX_ENTRIES 32
+
+/* 单个响应的大小上限（字节），超出不缓存 */
+#define HTTP_CACHE_MAX_RESPONSE (64 * 1024)
+
+/* 带ETag的路由数量上限 */
+#define HTTP_CACHE_MAX_ETAG_ROUTES 16
+
+/**
+ * 初始化响应缓存
+ */
+void http_cache_init(void);
+
+/**
+ * 释放全部缓存
+ */
+void http_cache_deinit(void);
+
+/**
+ * 命中时直接发送缓存的响应
+ * @param c 请求连接
+ * @param hm 请求消息
+ * @param route 匹配到的路由
+ * @return 1已发送, 0未命中（路由不可缓存、非GET或已过期）
+ */
+int http_cache_serve(struct mg_connection *c, struct mg_http_message *hm, const Route *route);
+
+/**
+ * 资源未变化时回复304
+ * @param c 请求连接
+ * @param hm 请求消息
+ * @param route 匹配到的路由
+ * @return 1已回复304, 0需要正常处理
+ */
+int http_cache_not_modified(struct mg_connection *c, struct mg_http_message *hm, const Route *route);
+
+/**
+ * 处理函数返回后缓存其响应，并为响应补充 Cache-Control/Age 头（ETag路由补充 ETag 头）
+ * 只缓存同步写出的 200 响应；异步回复的请求（DB回调等）不缓存
+ * @param c 请求连接
+ * @param hm 请求消息
+ * @param route 匹配到的路由
+ * @param offset 调用处理函数前 c->send 的长度
+ */
+void http_cache_store(struct mg_connection *c, struct mg_http_message *hm,
+                      const Route *route, size_t offset);
+
+/**
+ * 失效以指定前缀开头的缓存，并递增路由模式以这些前缀开头的ETag版本号
+ * @param prefixes 路径前缀，多个以空格分隔（如 "/api/bands /api/cells"），NULL忽略
+ */
+void http_cache_invalidate(const char *prefixes);
+
+/**
+ * 失效计数：每次 http_cache_invalidate 递增
+ * 工作线程执行的查询在提交时记下，交回时计数已变则不缓存（执行期间可能有写操作）
+ */
+unsigned long http_cache_generation(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HTTP_CACHE_H */
@@ -6,16 +6,40 @@
 #ifndef HTTP_SERVER_H
 #define HTTP_SERVER_H
 
+#include <glib.h>
+#include "router.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* 带此请求头（任意值）的请求在响应中附带 Server-Timing 耗时分解 */
+#define HTTP_TIMING_REQUEST_HEADER "X-Debug-Timing"
+
+/*
+ * 连接限制默认值，启动时可由配置覆盖：
+ * http_max_connections / http_idle_timeout / http_header_timeout / http_worker_max_jobs
+ */
+
+/* 并发连接上限，超出的连接读到请求头后回复503并关闭 */
+#define HTTP_MAX_CONNECTIONS_DEFAULT 32
+
+/* 空闲超时（秒）：无收发数据且没有未完成响应的连接被关闭 */
+#define HTTP_IDLE_TIMEOUT_DEFAULT 60
+
+/* 请求头读取超时（秒）：请求头未收全超过该时间回复408并关闭 */
+#define HTTP_HEADER_TIMEOUT_DEFAULT 10
+
+/* 默认请求体上限（字节），路由可用 max_body 单独指定 */
+#define HTTP_MAX_BODY_DEFAULT (64 * 1024)
+
 /**
  * @brief 启动 HTTP 服务器
  * @param port 监听端口 (如 "80" 或 "8080")
+ * @param web_root 前端页面目录（开发调试用，覆盖内置页面），NULL使用内置页面
  * @return 0 成功, -1 失败
  */
-int http_server_start(const char *port);
+int http_server_start(const char *port, const char *web_root);
 
 /**
  * @brief 停止 HTTP 服务器
@@ -27,6 +51,84 @@ void http_server_stop(void);
  */
 void http_server_run(void);
 
+struct mg_connection;
+struct mg_str;
+
+/**
+ * @brief 按连接ID查找连接（仅限主线程调用，用于异步任务完成后回复）
+ * @param id 连接ID (mg_connection.id)
+ * @return 连接指针，连接已关闭返回 NULL
+ */
+struct mg_connection *http_server_find_conn(unsigned long id);
+
+/**
+ * @brief 当前请求路由中 "*" 段捕获的参数（如 /api/sms/:id 中的ID）
+ * 仅在路由处理函数内有效，指向请求缓冲区，不以'\0'结尾
+ * @return 捕获的内容，无则 len 为 0
+ */
+struct mg_str http_route_param(void);
+
+/**
+ * @brief 在当前线程执行已匹配的路由（仅限主线程调用）
+ * 处理函数返回后写入GET缓存，并失效路由声明的缓存和事件主题；
+ * 不查GET缓存，不转交工作线程
+ * @param c 连接（可为影子连接）
+ * @param hm 请求
+ * @param match 路由匹配结果
+ */
+void http_server_call_route(struct mg_connection *c, struct mg_http_message *hm,
+                            const RouteMatch *match);
+
+/* 流式请求体事件 */
+typedef enum {
+    HTTP_STREAM_DATA,       /* 收到一段请求体 */
+    HTTP_STREAM_END,        /* 请求体已收全，回调须写出响应 */
+    HTTP_STREAM_ABORT,      /* 请求体收全前连接关闭，只需释放资源 */
+} HttpStreamEvent;
+
+/**
+ * 流式请求体回调
+ * @param data HTTP_STREAM_DATA 时为本段数据（指向接收缓冲，回调返回后失效）
+ * @param arg http_server_stream 传入的参数
+ * @return 0继续接收；非0表示回调已写出（错误）响应，停止接收且不再调用
+ */
+typedef int (*http_stream_cb_t)(struct mg_connection *c, HttpStreamEvent ev,
+                                struct mg_str data, void *arg);
+
+/**
+ * @brief 接管请求体（仅限 ROUTE_F_STREAM 路由的处理函数调用）
+ * 这类处理函数在请求头收全、Token 验证通过后即被调用，hm->body 为空；
+ * 调用本函数后请求体按到达顺序分段交给 cb，不在接收缓冲中累积。
+ * 处理函数不调用本函数时须自行写出响应。两种情况下响应写出后连接都不再复用
+ * @param c 连接
+ * @param hm 请求（须有 Content-Length）
+ * @param cb 回调
+ * @param arg 回调参数
+ */
+void http_server_stream(struct mg_connection *c, struct mg_http_message *hm,
+                        http_stream_cb_t cb, void *arg);
+
+/**
+ * @brief 记录一次请求：处理耗时和状态码（ofono_http_request_duration_seconds）及访问日志
+ * @param route 路由标签（路由模式）
+ * @param rem 客户端地址
+ * @param hm 请求
+ * @param response 响应开头（含状态行）
+ * @param len 响应长度
+ * @param start_us 收到请求的时间（g_get_monotonic_time）
+ */
+void http_server_observe(const char *route, const struct mg_addr *rem, struct mg_http_message *hm,
+                         const char *response, size_t len, gint64 start_us);
+
+/**
+ * @brief 结束当前线程的耗时分解，把 Server-Timing 头插入响应
+ * 区间见 metrics_trace_begin，另加 total（自收到请求起）
+ * @param send 响应所在缓冲
+ * @param offset 响应在缓冲中的起始位置
+ * @param start_us 收到请求的时间
+ */
+void http_server_timing_insert(struct mg_iobuf *send, size_t offset, gint64 start_us);
+
 #ifdef __cplusplus
 }
 #endif
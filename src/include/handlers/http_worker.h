@@ -0,0 +1,84 @@
+/**
+ * @file http_worker.h
+ * @brief 阻塞型请求工作线程池
+ *
+ * 标记为 ROUTE_F_BLOCKING 的路由在工作线程中执行，
+ * 响应写入影子连接的发送缓冲，完成后经 mg_wakeup 交回事件循环线程发送。
+ * 处理函数也可以用 http_worker_submit_call 把自己的一部分工作转交工作线程（如批量请求）
+ */
+
+#ifndef HTTP_WORKER_H
+#define HTTP_WORKER_H
+
+#include "mongoose.h"
+#include "router.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 工作线程数量 */
+#define HTTP_WORKER_THREADS 2
+
+/* 等待执行的请求上限，超出返回503 */
+#define HTTP_WORKER_QUEUE_SIZE 16
+
+/* 默认的未完成请求上限（排队、执行中和待发送的合计），超出返回503 */
+#define HTTP_WORKER_MAX_JOBS_DEFAULT (HTTP_WORKER_QUEUE_SIZE + HTTP_WORKER_THREADS)
+
+/* 工作线程中执行，代替路由处理函数写出响应：c 为影子连接，hm 为请求副本 */
+typedef void (*http_worker_fn_t)(struct mg_connection *c, struct mg_http_message *hm, void *arg);
+
+/**
+ * 事件循环线程中执行，在响应发出前（或线程池停止丢弃任务时）调用，负责释放 arg
+ * @param fresh 1已执行且期间没有缓存失效（结果可以写入GET缓存），0其他情况
+ */
+typedef void (*http_worker_done_t)(struct mg_http_message *hm, void *arg, int fresh);
+
+/**
+ * 启动工作线程池
+ * @param mgr 事件管理器（用于 mg_wakeup）
+ * @param notify_id 接收 MG_EV_WAKEUP 的连接ID（通常为监听连接）
+ * @param max_jobs 未完成请求上限，<=0 使用 HTTP_WORKER_MAX_JOBS_DEFAULT
+ * @return 0成功, -1失败
+ */
+int http_worker_start(struct mg_mgr *mgr, unsigned long notify_id, int max_jobs);
+
+/**
+ * 停止工作线程池（等待正在执行的请求完成，丢弃未执行的请求）
+ */
+void http_worker_stop(void);
+
+/**
+ * 提交请求到工作线程（仅限事件循环线程调用）
+ * 请求内容被复制，处理函数在工作线程中以影子连接执行
+ * @param c 请求连接
+ * @param hm 请求消息
+ * @param route 匹配到的路由（完成后按 route->invalidates 失效缓存）
+ * @return 0已提交, -1线程池未运行, -2队列已满或未完成请求达到上限
+ */
+int http_worker_submit(struct mg_connection *c, struct mg_http_message *hm,
+                       const Route *route);
+
+/**
+ * 提交请求到工作线程，以 fn 代替路由处理函数执行（仅限事件循环线程调用）
+ * 调用方处理函数返回时不写响应，响应由 fn 写出；失败时 done 不会被调用
+ * @param fn 工作线程中执行
+ * @param done 事件循环线程中执行，可为NULL
+ * @param arg 传给 fn 和 done
+ * @return 同 http_worker_submit
+ */
+int http_worker_submit_call(struct mg_connection *c, struct mg_http_message *hm, const Route *route,
+                            http_worker_fn_t fn, http_worker_done_t done, void *arg);
+
+/**
+ * 发送已完成请求的响应并失效相关缓存（仅限事件循环线程调用）
+ * 在 MG_EV_WAKEUP 及监听连接的 MG_EV_POLL 中调用
+ */
+void http_worker_deliver(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HTTP_WORKER_H */
@@ -0,0 +1,116 @@
+/**
+ * @file json_writer.h
+ * @brief JSON 流式写入器 - 在 mg_iobuf 上构建对象/数组，按需扩容
+ *
+ * 缓冲模式：整个响应体写入写入器自己的缓冲，json_writer_reply 一次发出（带Content-Length）；
+ * 流式模式（json_writer_stream）：先发送响应头，之后每当连接发送缓冲低于
+ * JSON_WRITER_CHUNK_SIZE 才调用生成回调写下一部分，以 Transfer-Encoding: chunked 发出，
+ * 发送缓冲中最多积压约两个分块，适合列表等大响应。
+ * 逗号和字符串转义由写入器处理，调用者只需按顺序写键和值。
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stddef.h>
+#include "mongoose.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 最大嵌套层数 */
+#define JSON_WRITER_MAX_DEPTH 16
+
+/* 流式模式下每个分块的目标大小，也是继续生成的发送缓冲水位（字节） */
+#define JSON_WRITER_CHUNK_SIZE 4096
+
+typedef struct {
+    struct mg_iobuf buf;
+    struct mg_connection *c;                    /* 流式模式的目标连接，缓冲模式为NULL */
+    int depth;
+    unsigned char has_items[JSON_WRITER_MAX_DEPTH]; /* 各层是否已有元素（决定逗号） */
+    int after_key;                              /* 刚写完键，下一个值不加逗号 */
+    int error;                                  /* 嵌套超限或内存不足 */
+} JsonWriter;
+
+/**
+ * 初始化缓冲模式写入器
+ */
+void json_writer_init(JsonWriter *w);
+
+/**
+ * 流式模式的生成回调：写入下一部分（如一条记录）
+ * @return 0还有后续, 1已全部写完
+ */
+typedef int (*json_writer_fill_t)(JsonWriter *w, void *arg);
+
+/**
+ * 以流式模式发送 200 响应：立即发送响应头并生成第一批数据，
+ * 之后由 json_writer_pump 在连接发送缓冲低于水位时继续调用 fill。
+ * 写完、出错或连接关闭后调用 free_arg(arg)（可为NULL）。
+ * 非客户端连接（批量请求、工作线程的影子连接）一次生成全部数据
+ * @param headers 额外响应头（如 HTTP_CORS_HEADERS），可为NULL
+ */
+void json_writer_stream(struct mg_connection *c, const char *headers,
+                        json_writer_fill_t fill, void (*free_arg)(void *), void *arg);
+
+/**
+ * 连接可写时继续生成流式响应（http_server 在 MG_EV_WRITE/MG_EV_POLL 时调用）
+ */
+void json_writer_pump(struct mg_connection *c);
+
+/**
+ * 连接关闭：放弃该连接未完成的流式响应
+ */
+void json_writer_abort(struct mg_connection *c);
+
+/**
+ * 以 status 和 headers 发送缓冲模式的完整响应并释放缓冲，内存不足时回复500
+ */
+void json_writer_reply(JsonWriter *w, struct mg_connection *c, int status, const char *headers);
+
+/**
+ * 释放缓冲（不发送），用于出错时放弃缓冲模式的响应
+ */
+void json_writer_free(JsonWriter *w);
+
+/* 结构 */
+void json_begin_object(JsonWriter *w);
+void json_end_object(JsonWriter *w);
+void json_begin_array(JsonWriter *w);
+void json_end_array(JsonWriter *w);
+void json_key(JsonWriter *w, const char *key);
+
+/* 值 */
+void json_string(JsonWriter *w, const char *s);
+void json_string_n(JsonWriter *w, const char *s, size_t len);
+void json_int(JsonWriter *w, long long v);
+void json_double(JsonWriter *w, double v, int decimals);
+void json_bool(JsonWriter *w, int v);
+void json_null(JsonWriter *w);
+
+/**
+ * 写入已经是合法JSON的片段（原样输出）
+ */
+void json_raw(JsonWriter *w, const char *json);
+
+/**
+ * 分段写入一个字符串值（如逐块读取的文件内容）
+ * json_string_begin 后可多次调用 json_string_append，最后调用 json_string_end
+ */
+void json_string_begin(JsonWriter *w);
+void json_string_append(JsonWriter *w, const char *s, size_t len);
+void json_string_end(JsonWriter *w);
+
+/* 键值便捷写法 */
+void json_kv_string(JsonWriter *w, const char *key, const char *s);
+void json_kv_int(JsonWriter *w, const char *key, long long v);
+void json_kv_double(JsonWriter *w, const char *key, double v, int decimals);
+void json_kv_bool(JsonWriter *w, const char *key, int v);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSON_WRITER_H */
@@ -0,0 +1,89 @@
+/**
+ * @file router.h
+ * @brief HTTP 路由表 - 启动时编译为按路径段索引的前缀树
+ */
+
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include <stddef.h>
+#include "mongoose.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 请求方法掩码 */
+#define ROUTE_GET       0x01
+#define ROUTE_POST      0x02
+#define ROUTE_PUT       0x04
+#define ROUTE_DELETE    0x08
+#define ROUTE_OPTIONS   0x10
+#define ROUTE_OTHER     0x80    /* 其他方法 (HEAD/PATCH等) */
+#define ROUTE_ANY       0xFF    /* 不限方法（由处理函数自行检查） */
+
+/* 路由标志 */
+#define ROUTE_F_PUBLIC      0x01    /* 无需Token认证 */
+#define ROUTE_F_BLOCKING    0x02    /* 处理函数可能长时间阻塞（AT/外部命令） */
+#define ROUTE_F_QUERY_TOKEN 0x04    /* 也接受 ?token= 传递Token（EventSource 无法设置请求头） */
+#define ROUTE_F_ASYNC       0x08    /* 响应在处理函数返回后才写出（DB任务完成回调、事件流） */
+#define ROUTE_F_STREAM      0x10    /* 请求头收全即调用处理函数，请求体不缓冲（见 http_server_stream） */
+#define ROUTE_F_ETAG        0x20    /* GET响应只随写操作变化，带弱ETag并支持304（见 http_cache.h） */
+#define ROUTE_F_BATCH       0x40    /* 只读查询，可作为 /api/batch 的子请求（见 batch.h） */
+
+typedef void (*route_handler_t)(struct mg_connection *c, struct mg_http_message *hm);
+
+/**
+ * 路由项
+ * pattern 按 '/' 分段，"*" 段匹配任意单个路径段并作为参数捕获；
+ * 同一路径可登记多项，按声明顺序取第一个方法匹配的；
+ * cache_ttl/invalidates 见 http_cache.h，不需要时可省略（零值）
+ */
+typedef struct {
+    const char *pattern;
+    unsigned int methods;
+    route_handler_t handler;
+    unsigned int flags;
+    unsigned int cache_ttl;     /* GET响应缓存秒数，0不缓存 */
+    const char *invalidates;    /* 请求完成后失效的缓存路径前缀，空格分隔 */
+    size_t max_body;            /* 请求体上限（字节），0使用 HTTP_MAX_BODY_DEFAULT */
+} Route;
+
+/* 匹配结果 */
+typedef struct {
+    const Route *route;
+    struct mg_str param;    /* "*" 段捕获的内容，无则为空 */
+} RouteMatch;
+
+/**
+ * 编译路由表（路由表须在整个运行期间有效）
+ * @param routes 路由数组
+ * @param count 路由数量
+ * @return 0成功, -1失败
+ */
+int router_init(const Route *routes, size_t count);
+
+/**
+ * 释放路由前缀树
+ */
+void router_deinit(void);
+
+/**
+ * 匹配请求
+ * @param uri 请求路径（不含查询串）
+ * @param method 请求方法
+ * @param match 输出匹配结果
+ * @return 0匹配成功, 404路径不存在, 405路径存在但方法不允许
+ */
+int router_match(struct mg_str uri, struct mg_str method, RouteMatch *match);
+
+/**
+ * 请求方法转掩码位
+ */
+unsigned int router_method_bit(struct mg_str method);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROUTER_H */
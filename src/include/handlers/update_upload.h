@@ -0,0 +1,35 @@
+/**
+ * @file update_upload.h
+ * @brief 更新包上传 - POST /api/update/upload
+ *
+ * 请求体为 multipart/form-data，第一个带文件名的部分即更新包。
+ * 路由以流式方式执行：请求体边收边解析，文件内容直接写入 UPDATE_ZIP_PATH
+ * 并同时计算 SHA-256，内存占用与更新包大小无关。
+ * Content-Length 超过上限或超过 /tmp 剩余空间时在读取请求体前拒绝。
+ * 同一时间只接受一个上传。
+ * 响应 {"status":"success","message":"上传成功","size":N,"sha256":"..."}
+ */
+
+#ifndef UPDATE_UPLOAD_H
+#define UPDATE_UPLOAD_H
+
+#include "mongoose.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 上传请求体上限（字节） */
+#define UPDATE_UPLOAD_MAX_SIZE (64 * 1024 * 1024)
+
+/* 解析缓冲大小：文件部分每次最多写出这么多字节，单个部分的头也不能超过它 */
+#define UPDATE_UPLOAD_BUF_SIZE 8192
+
+/* POST /api/update/upload - 上传更新包 */
+void handle_update_upload(struct mg_connection *c, struct mg_http_message *hm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPDATE_UPLOAD_H */
@@ -3,6 +3,7 @@
  * @brief 数据库操作模块 - SQLite3 统一接口
  * 
  * 提供数据库初始化、SQL执行、配置管理等功能
+ * 进程内单连接 + 预编译语句缓存，所有接口线程安全
  */
 
 #ifndef DATABASE_H
@@ -32,23 +33,31 @@ void db_deinit(void);
 
 /**
  * 获取数据库路径
- * @return 数据库文件路径
+ * @return 当前读写的数据库文件路径（热数据库模式下为tmpfs路径）
  */
 const char *db_get_path(void);
 
+/**
+ * 热数据库写回闪存（非热数据库模式或无新写入时直接返回）
+ * 配置项 db_hot_mode=1 启用热数据库，db_checkpoint_interval 为写回间隔（秒），
+ * 均在重启后生效
+ * @return 0成功, -1失败
+ */
+int db_checkpoint(void);
+
 /*============================================================================
  * SQL 执行接口
  *============================================================================*/
 
 /**
- * 执行SQL命令（无锁）
+ * 执行SQL命令（线程安全，支持多条语句）
  * @param sql SQL语句
  * @return 0成功, -1失败
  */
 int db_execute(const char *sql);
 
 /**
- * 执行SQL命令（带互斥锁，线程安全）
+ * 执行SQL命令（兼容接口，等同于 db_execute）
  * @param sql SQL语句
  * @return 0成功, -1失败
  */
@@ -81,6 +90,106 @@ int db_query_string(const char *sql, char *buf, size_t size);
  */
 int db_query_rows(const char *sql, const char *separator, char *buf, size_t size);
 
+/*============================================================================
+ * 类型化逐行查询接口
+ *============================================================================*/
+
+/* 列值/绑定参数类型 */
+typedef enum {
+    DB_TYPE_END = 0,    /* 绑定参数数组结束标记 */
+    DB_TYPE_NULL,
+    DB_TYPE_INT,
+    DB_TYPE_FLOAT,
+    DB_TYPE_TEXT,
+    DB_TYPE_BLOB
+} DbType;
+
+/**
+ * 类型化的值（列值或绑定参数）
+ * TEXT/BLOB 的 data 指针仅在回调期间有效，len 为字节数（TEXT绑定时-1表示自动计算）
+ */
+typedef struct {
+    DbType type;
+    long long i;
+    double f;
+    const void *data;
+    int len;
+} DbValue;
+
+/* 绑定参数构造宏 */
+#define DB_ARG_INT(v)      ((DbValue){ .type = DB_TYPE_INT, .i = (long long)(v) })
+#define DB_ARG_TEXT(s)     ((DbValue){ .type = DB_TYPE_TEXT, .data = (s), .len = -1 })
+#define DB_ARG_BLOB(p, n)  ((DbValue){ .type = DB_TYPE_BLOB, .data = (p), .len = (int)(n) })
+#define DB_ARG_NULL        ((DbValue){ .type = DB_TYPE_NULL })
+#define DB_ARG_END         ((DbValue){ .type = DB_TYPE_END })
+
+/**
+ * 行回调函数
+ * @param cols 本行列值数组
+ * @param ncols 列数
+ * @param ctx 用户上下文
+ * @return 0继续遍历, 非0停止
+ */
+typedef int (*db_row_callback_t)(const DbValue *cols, int ncols, void *ctx);
+
+/**
+ * 执行参数化查询并逐行回调（无中间文本缓冲）
+ * 回调在数据库锁内执行，回调中不可再调用数据库接口
+ * @param sql SQL语句（参数用 ?1, ?2... 占位）
+ * @param args 绑定参数数组，以 DB_ARG_END 结尾（无参数可传NULL）
+ * @param callback 行回调（可为NULL，仅执行语句）
+ * @param ctx 回调上下文
+ * @return 遍历的行数, -1失败
+ */
+int db_query_each(const char *sql, const DbValue *args, db_row_callback_t callback, void *ctx);
+
+/**
+ * 将列值复制为C字符串（TEXT/BLOB按长度复制并截断，INT/FLOAT格式化，NULL为空串）
+ * @param v 列值
+ * @param buf 输出缓冲区
+ * @param size 缓冲区大小
+ */
+void db_value_copy(const DbValue *v, char *buf, size_t size);
+
+/*============================================================================
+ * 异步执行接口
+ *
+ * 单个DB工作线程 + 有界队列，避免HTTP/GLib主循环阻塞在存储上。
+ * job 在工作线程执行；done 通过 g_idle_add 投递回 GLib 默认主上下文执行
+ *============================================================================*/
+
+/* 工作线程中执行的任务 */
+typedef void (*db_job_func_t)(void *arg);
+
+/* 主上下文中执行的完成回调 */
+typedef void (*db_done_func_t)(void *arg);
+
+/**
+ * 提交异步任务
+ * @param job 任务函数（工作线程执行，可为NULL）
+ * @param done 完成回调（主上下文执行，可为NULL）
+ * @param arg 传给两者的参数，由调用方在 done（或无done时在 job）中释放
+ * @return 0已入队, -1队列已满或工作线程未启动
+ */
+int db_async_submit(db_job_func_t job, db_done_func_t done, void *arg);
+
+/**
+ * 提交异步任务，入队失败时在当前线程同步执行 job（done 仍投递到主上下文）
+ * @param job 任务函数
+ * @param done 完成回调
+ * @param arg 参数
+ */
+void db_async_run_or_submit(db_job_func_t job, db_done_func_t done, void *arg);
+
+/**
+ * 按提交顺序执行异步任务：队列已满时等待空位，而不是抢在已排队任务之前执行；
+ * 工作线程未启动时等队列排空后在当前线程同步执行
+ * @param job 任务函数
+ * @param done 完成回调
+ * @param arg 参数
+ */
+void db_async_submit_ordered(db_job_func_t job, db_done_func_t done, void *arg);
+
 /*============================================================================
  * 字符串处理
  *============================================================================*/
@@ -101,6 +210,8 @@ void db_unescape_string(char *str);
 
 /*============================================================================
  * 配置管理接口
+ *
+ * config 表整体缓存在内存中：读取只查内存（读写锁），写入先落盘再更新缓存
  *============================================================================*/
 
 /**
@@ -120,6 +231,21 @@ int config_get(const char *key, char *value, size_t value_size);
  */
 int config_set(const char *key, const char *value);
 
+/* 配置键值对 */
+typedef struct {
+    const char *key;
+    const char *value;
+} ConfigKV;
+
+/**
+ * 批量设置配置值（单个事务，全部成功或全部失败）
+ * 数毫秒内并发到达的写入会合并为一次提交（组提交），减少闪存fsync
+ * @param kvs 键值对数组
+ * @param n 数量
+ * @return 0成功, -1失败
+ */
+int config_set_many(const ConfigKV *kvs, size_t n);
+
 /**
  * 获取配置值（整数）
  * @param key 配置键名
@@ -152,6 +278,30 @@ long long config_get_ll(const char *key, long long default_val);
  */
 int config_set_ll(const char *key, long long value);
 
+/*============================================================================
+ * 配置变更通知
+ *============================================================================*/
+
+/* 最大监听数量 */
+#define CONFIG_MAX_WATCHERS 16
+
+/**
+ * 配置变更回调（在调用 config_set 的线程中、锁外执行）
+ * @param key 变更的键名
+ * @param value 新值
+ * @param user_data 注册时传入的上下文
+ */
+typedef void (*config_change_callback_t)(const char *key, const char *value, void *user_data);
+
+/**
+ * 注册配置变更监听，仅在值实际变化时回调
+ * @param prefix 键名前缀（NULL或空串匹配所有键）
+ * @param callback 回调函数
+ * @param user_data 回调上下文
+ * @return 0成功, -1失败（监听数量已满）
+ */
+int config_watch(const char *prefix, config_change_callback_t callback, void *user_data);
+
 #ifdef __cplusplus
 }
 #endif
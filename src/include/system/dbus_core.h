@@ -35,6 +35,41 @@ int is_dbus_initialized(void);
  */
 int execute_at(const char *command, char **result);
 
+/* 只读查询（execute_at_query 的合并键） */
+#define AT_QUERY_LTE_SERVING    "AT+SPENGMD=0,6,0"      /* 4G 主小区 */
+#define AT_QUERY_LTE_NEIGHBOUR  "AT+SPENGMD=0,6,6"      /* 4G 邻小区 */
+#define AT_QUERY_NR_SERVING     "AT+SPENGMD=0,14,1"     /* 5G 主小区 */
+#define AT_QUERY_NR_NEIGHBOUR   "AT+SPENGMD=0,14,2"     /* 5G 邻小区 */
+#define AT_QUERY_LTE_BANDS      "AT+SPLBAND=0"          /* 4G 频段锁定状态 */
+#define AT_QUERY_NR_BANDS       "AT+SPLBAND=3"          /* 5G 频段锁定状态 */
+#define AT_QUERY_QOS            "AT+CGEQOSRDP"          /* QoS 签约速率 */
+
+/**
+ * @brief 执行只读 AT 查询，合并并发的相同查询
+ *
+ * 同一查询已在执行时，后来的调用者（事件循环或工作线程）等待其完成
+ * 并得到同一结果的副本，调制解调器只收到一次命令。
+ * 仅用于无副作用的查询，设置类命令仍使用 execute_at。
+ * @param command 查询命令（通常为 AT_QUERY_* 之一）
+ * @param result 返回结果指针 (调用者需用 g_free 释放)
+ * @return 0 成功, -1 失败
+ */
+int execute_at_query(const char *command, char **result);
+
+/**
+ * @brief 开始当前线程的查询作用域（可嵌套）
+ *
+ * 作用域内 execute_at_query 和 ofono_get_datacard（get_current_slot）的成功结果
+ * 按命令记住并直接复用，用于一次批量请求中的多个子请求共享调制解调器状态。
+ * 必须与 modem_query_scope_end 成对调用。
+ */
+void modem_query_scope_begin(void);
+
+/**
+ * @brief 结束查询作用域，最外层结束时丢弃记住的结果
+ */
+void modem_query_scope_end(void);
+
 /**
  * @brief 获取最后一次错误信息
  * @return 错误信息字符串
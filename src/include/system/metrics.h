@@ -0,0 +1,105 @@
+/**
+ * @file metrics.h
+ * @brief 运行指标 - 计数器、仪表和对数分桶直方图
+ *
+ * 指标族在 metrics.c 的族表中静态声明（名称、类型、最多两个标签名），
+ * 带标签值的序列在首次使用时登记，之后只增不删。
+ * 计数器和直方图写入调用线程独占的分片（线程首次记录时无锁领取，线程退出时归还），
+ * 采集时把所有分片相加；仪表是全局原子值。
+ * 记录路径不加锁，只有登记新序列时持有一次互斥锁。
+ * 序列数达到 METRICS_MAX_SERIES 后新序列的记录被丢弃。
+ *
+ * 请求耗时分解：线程调用 metrics_trace_begin 后，AT、D-Bus、外部命令和数据库
+ * 的耗时（带 span 名称的指标族）同时记入该线程的分解，直到 metrics_trace_end
+ * 输出为 Server-Timing 头的值。未开启时只多一次线程局部变量判断。
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 序列上限（所有指标族合计） */
+#define METRICS_MAX_SERIES 192
+
+/* 分片上限：每个记录过指标的存活线程占一个，超出的线程共用溢出分片 */
+#define METRICS_MAX_SHARDS 16
+
+/* 直方图桶数（不含 +Inf）：上界为 2^(i+7) 微秒，即 128us ~ 16.8s */
+#define METRICS_HISTOGRAM_BUCKETS 18
+
+/* 标签值最大长度（超出截断） */
+#define METRICS_LABEL_MAX 48
+
+/* 单个请求耗时分解的区间上限（同名同描述的合并计数） */
+#define METRICS_TRACE_MAX_SPANS 24
+
+/* 指标族 */
+typedef enum {
+    METRIC_HTTP_REQUEST_DURATION,   /* 直方图 {route,status} */
+    METRIC_HTTP_CACHE_HITS,         /* 计数器 {route} */
+    METRIC_HTTP_CONNECTIONS,        /* 仪表 */
+    METRIC_HTTP_WORKER_QUEUE,       /* 仪表 */
+    METRIC_HTTP_WORKER_REJECTED,    /* 计数器 */
+    METRIC_AT_COMMAND_DURATION,     /* 直方图 {command,result} */
+    METRIC_DBUS_CALL_DURATION,      /* 直方图 {method,result} */
+    METRIC_COMMAND_DURATION,        /* 直方图 {exe,result} */
+    METRIC_DB_QUERY_DURATION,       /* 直方图 {op} */
+    METRIC_FAMILY_COUNT
+} MetricFamily;
+
+/**
+ * 记录一次耗时
+ * @param family 直方图类指标族
+ * @param l1 第一个标签值（族无标签时忽略，可为NULL）
+ * @param l2 第二个标签值
+ * @param start_us 开始时间（g_get_monotonic_time）
+ */
+void metrics_observe(MetricFamily family, const char *l1, const char *l2, gint64 start_us);
+
+/**
+ * 计数器加一
+ */
+void metrics_inc(MetricFamily family, const char *l1, const char *l2);
+
+/**
+ * 仪表增减 / 设置（无标签）
+ */
+void metrics_gauge_add(MetricFamily family, gint64 delta);
+void metrics_gauge_set(MetricFamily family, gint64 value);
+
+/**
+ * 开始记录当前线程的请求耗时分解
+ */
+void metrics_trace_begin(void);
+
+/**
+ * 记录一个自定义区间（未开启分解时忽略）
+ * @param name 区间名称（须为字符串常量，不复制）
+ * @param desc 描述，可为NULL
+ * @param start_us 开始时间（g_get_monotonic_time）
+ */
+void metrics_span(const char *name, const char *desc, gint64 start_us);
+
+/**
+ * 结束当前线程的请求耗时分解
+ * @param out 追加 Server-Timing 值（"at;desc=\"AT+CSQ\";dur=12.30, ..."），NULL时只丢弃
+ */
+void metrics_trace_end(GString *out);
+
+/**
+ * 以文本暴露格式 (text/plain; version=0.0.4) 输出全部指标
+ * @param out 追加输出的字符串
+ */
+void metrics_render(GString *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* METRICS_H */
@@ -7,6 +7,7 @@
 #define PLUGIN_H
 
 #include <stddef.h>
+#include "json_writer.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -30,13 +31,31 @@ extern "C" {
  */
 int execute_shell(const char *cmd, char *output, size_t size);
 
+/* 插件列表遍历状态 */
+typedef struct {
+    void *dir;                  /* DIR*，目录不存在时为NULL */
+    int count;                  /* 已输出的插件数量 */
+} PluginList;
+
 /**
- * @brief 获取插件列表
- * @param json_output JSON输出缓冲区
- * @param size 缓冲区大小
- * @return 插件数量, -1 失败
+ * @brief 开始遍历插件目录
+ * @param list 遍历状态
+ */
+void plugin_list_open(PluginList *list);
+
+/**
+ * @brief 以JSON对象写入下一个插件
+ * @param list 遍历状态
+ * @param w JSON写入器
+ * @return 1 已写入一个, 0 没有更多插件
+ */
+int plugin_list_next(PluginList *list, JsonWriter *w);
+
+/**
+ * @brief 结束遍历
+ * @param list 遍历状态
  */
-int get_plugin_list(char *json_output, size_t size);
+void plugin_list_close(PluginList *list);
 
 /**
  * @brief 保存插件
@@ -47,6 +47,13 @@ void sha256_update(SHA256_CTX *ctx, const uint8_t *data, size_t len);
  */
 void sha256_final(SHA256_CTX *ctx, uint8_t *hash);
 
+/**
+ * 完成SHA256计算并输出hex字符串（用于分段计算）
+ * @param ctx SHA256上下文指针
+ * @param hex_out 输出缓冲区（至少65字节）
+ */
+void sha256_final_hex(SHA256_CTX *ctx, char *hex_out);
+
 /**
  * 便捷函数：计算字符串的SHA256哈希并输出hex字符串
  * @param str 输入字符串
@@ -60,6 +60,16 @@ int sms_send(const char *recipient, const char *content, char *result_path, size
  */
 int sms_get_list(SmsMessage *messages, int max_count);
 
+/**
+ * 按ID区间获取短信列表（新的在前）
+ * @param messages 输出数组
+ * @param max_count 最大数量
+ * @param before_id 只取 id < before_id 的（向前翻页），0不限
+ * @param since_id 只取 id > since_id 的（增量同步），0不限
+ * @return 实际获取的数量, -1失败
+ */
+int sms_get_list_range(SmsMessage *messages, int max_count, int before_id, int since_id);
+
 /**
  * 获取短信总数
  * @return 短信数量, -1失败
@@ -116,6 +126,11 @@ typedef struct {
  */
 int sms_get_sent_list(SentSmsMessage *messages, int max_count);
 
+/**
+ * 按ID区间获取发送记录列表（新的在前），参数同 sms_get_list_range
+ */
+int sms_get_sent_list_range(SentSmsMessage *messages, int max_count, int before_id, int since_id);
+
 /**
  * 获取最大存储数量配置
  * @return 最大数量
@@ -149,6 +164,21 @@ int sms_set_max_sent_count(int count);
  */
 int sms_delete_sent(int id);
 
+/* 收件箱/发件箱概况，用于判断列表是否变化 */
+typedef struct {
+    int total;              /* 收件箱短信数 */
+    int latest_id;          /* 最新短信ID，无则为0 */
+    int sent_total;         /* 发送记录数 */
+    int sent_latest_id;     /* 最新发送记录ID，无则为0 */
+} SmsState;
+
+/**
+ * 获取收件箱/发件箱概况
+ * @param state 输出概况
+ * @return 0成功, -1失败
+ */
+int sms_get_state(SmsState *state);
+
 /**
  * 检查短信模块状态
  * @return 1正常, 0异常
@@ -156,8 +186,8 @@ int sms_delete_sent(int id);
 int sms_check_status(void);
 
 /**
- * 定期维护短信模块（检查并恢复D-Bus连接）
- * 应在主循环中定期调用
+ * 维护短信模块（检查并恢复D-Bus连接）
+ * 初始化成功后由主循环定时器每30秒调用一次
  */
 void sms_maintenance(void);
 
@@ -11,11 +11,15 @@
 
 int main(int argc, char *argv[]) {
     const char *port = "6677";
+    const char *web_root = NULL;
 
-    /* 解析命令行参数 */
+    /* 解析命令行参数: ofono-server [端口] [前端目录] */
     if (argc > 1) {
         port = argv[1];
     }
+    if (argc > 2) {
+        web_root = argv[2];
+    }
 
     printf("=== ofono-server (C version) ===\n");
 
@@ -30,7 +34,7 @@ int main(int argc, char *argv[]) {
     /* 注意: 数据连接 Watchdog 由 APN 模块在用户配置 APN 后启动 */
 
     /* 启动 HTTP 服务器 */
-    if (http_server_start(port) != 0) {
+    if (http_server_start(port, web_root) != 0) {
         fprintf(stderr, "服务器启动失败\n");
         ofono_stop_data_watchdog();
         ofono_deinit();
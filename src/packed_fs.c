@@ -1,22 +1,229 @@
 /**
  * @file packed_fs.c
- * @brief Static file service - serve files from dist directory
+ * @brief Static file service - serve the web dashboard
+ *
+ * Files come from the packed filesystem generated at build time from
+ * web/dist (tools/pack_web.c), so serving an asset is a memory lookup.
+ * A directory given on the command line overrides it for development;
+ * a binary built without web/dist falls back to ./dist on disk.
+ *
+ * The web build emits .br/.gz siblings for compressible files; the best one
+ * accepted by the client is sent with Content-Encoding. The packed filesystem
+ * keeps only the .gz variant of such files, so a client that does not accept
+ * gzip gets it inflated on the fly (GIO's zlib decompressor). Content-hashed
+ * bundles under /assets/ are cached forever, everything else (index.html)
+ * is revalidated with its ETag on each load.
  */
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <gio/gio.h>
 #include "mongoose.h"
 
-/* Static file directory */
+/* Fallback static file directory when nothing is packed */
 #define STATIC_DIR "./dist"
 
-/* Static file service options */
-static struct mg_http_serve_opts s_opts = {
-    .root_dir = STATIC_DIR,
-    .ssi_pattern = NULL,
-    .extra_headers = "Cache-Control: max-age=3600\r\n"
-                     "Access-Control-Allow-Origin: *\r\n"
+/* Vite puts content-hashed bundles here; their URL changes with their content */
+#define ASSETS_PREFIX "/assets/"
+
+#define CACHE_IMMUTABLE  "Cache-Control: public, max-age=31536000, immutable\r\n"
+#define CACHE_REVALIDATE "Cache-Control: no-cache\r\n"
+#define COMMON_HEADERS   "Vary: Accept-Encoding\r\n" \
+                         "Access-Control-Allow-Origin: *\r\n"
+
+/* Filesystem and path prefix that request paths are resolved against */
+static struct mg_fs *s_fs = &mg_fs_posix;
+static char s_root[256] = STATIC_DIR;
+
+/* Precompressed variants, in order of preference */
+static const struct {
+    const char *token;      /* Accept-Encoding token */
+    const char *ext;        /* file suffix */
+} s_encodings[] = {
+    { "br",   "br" },
+    { "gzip", "gz" },
+};
+
+/* Content types of files that may have precompressed variants (see web/vite.config.js) */
+static const struct {
+    const char *ext;
+    const char *mime;
+} s_mime_types[] = {
+    { "js",   "text/javascript; charset=utf-8" },
+    { "css",  "text/css; charset=utf-8" },
+    { "html", "text/html; charset=utf-8" },
+    { "svg",  "image/svg+xml" },
+    { "json", "application/json" },
+    { "txt",  "text/plain; charset=utf-8" },
 };
 
+/**
+ * @brief Check whether Accept-Encoding allows a coding (present and q > 0)
+ */
+static int accepts_encoding(const struct mg_str *ae, const char *token) {
+    struct mg_str s = *ae, item, name, params;
+
+    while (mg_span(s, &item, &s, ',')) {
+        mg_span(item, &name, &params, ';');
+        while (name.len > 0 && name.buf[0] == ' ') name.buf++, name.len--;
+        while (name.len > 0 && name.buf[name.len - 1] == ' ') name.len--;
+        if (mg_strcasecmp(name, mg_str(token)) != 0) {
+            continue;
+        }
+
+        /* "q=0", "q=0.0" etc. explicitly refuse the coding */
+        struct mg_str param;
+        while (mg_span(params, &param, &params, ';')) {
+            while (param.len > 0 && param.buf[0] == ' ') param.buf++, param.len--;
+            if (param.len > 2 && (param.buf[0] == 'q' || param.buf[0] == 'Q') && param.buf[1] == '=') {
+                char num[8] = {0};
+                memcpy(num, param.buf + 2, param.len - 2 < sizeof(num) - 1 ? param.len - 2 : sizeof(num) - 1);
+                return atof(num) > 0;
+            }
+        }
+        return 1;
+    }
+    return 0;
+}
+
+static const char *mime_type_for(const char *path) {
+    const char *dot = strrchr(path, '.');
+    if (!dot) return NULL;
+    for (size_t i = 0; i < sizeof(s_mime_types) / sizeof(s_mime_types[0]); i++) {
+        if (strcmp(dot + 1, s_mime_types[i].ext) == 0) {
+            return s_mime_types[i].mime;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Inflate a gzip-encoded buffer
+ * @return Decompressed data (caller frees with g_byte_array_unref), NULL if corrupt
+ */
+static GByteArray *inflate_gzip(const char *data, size_t size) {
+    GConverter *conv = G_CONVERTER(g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_GZIP));
+    GByteArray *out = g_byte_array_sized_new((guint)size * 4);
+    char buf[16384];
+    size_t ofs = 0;
+
+    for (;;) {
+        gsize nread = 0, nwritten = 0;
+        GError *err = NULL;
+        GConverterResult r = g_converter_convert(conv, data + ofs, size - ofs, buf, sizeof(buf),
+                                                 G_CONVERTER_INPUT_AT_END, &nread, &nwritten, &err);
+        if (r == G_CONVERTER_ERROR) {
+            printf("[WEB] 解压失败: %s\n", err->message);
+            g_error_free(err);
+            g_byte_array_unref(out);
+            out = NULL;
+            break;
+        }
+        ofs += nread;
+        g_byte_array_append(out, (const guint8 *)buf, (guint)nwritten);
+        if (r == G_CONVERTER_FINISHED) {
+            break;
+        }
+    }
+    g_object_unref(conv);
+    return out;
+}
+
+/**
+ * @brief Serve a packed file that is only embedded as .gz to a client without gzip
+ * @return 1 served, 0 no such packed file
+ */
+static int serve_inflated(struct mg_connection *c, struct mg_http_message *hm,
+                          const char *file, const char *mime, const char *cache) {
+    char variant[MG_PATH_MAX];
+    size_t size = 0;
+
+    snprintf(variant, sizeof(variant), "%s.gz", file);
+    const char *data = mg_unpack(variant, &size, NULL);
+    if (data == NULL) {
+        return 0;
+    }
+
+    GByteArray *body = inflate_gzip(data, size);
+    if (body == NULL) {
+        mg_http_reply(c, 500, COMMON_HEADERS, "Corrupt packed file\n");
+        return 1;
+    }
+    mg_printf(c, "HTTP/1.1 200 OK\r\nContent-Type: %s\r\n%s%sContent-Length: %u\r\n\r\n",
+              mime, cache, COMMON_HEADERS, body->len);
+    if (mg_strcasecmp(hm->method, mg_str("HEAD")) != 0) {
+        mg_send(c, body->data, body->len);
+    }
+    g_byte_array_unref(body);
+    return 1;
+}
+
+/**
+ * @brief Serve one file, preferring a precompressed variant the client accepts
+ */
+static void serve_static(struct mg_connection *c, struct mg_http_message *hm,
+                         const char *uri_path, const char *file) {
+    const char *cache = strncmp(uri_path, ASSETS_PREFIX, strlen(ASSETS_PREFIX)) == 0
+                            ? CACHE_IMMUTABLE : CACHE_REVALIDATE;
+    struct mg_http_serve_opts opts;
+    char headers[256], mime_override[96], variant[MG_PATH_MAX];
+    struct mg_str *ae = mg_http_get_header(hm, "Accept-Encoding");
+    const char *mime = mime_type_for(file);
+
+    memset(&opts, 0, sizeof(opts));
+    opts.fs = s_fs;
+
+    if (ae && mime) {
+        for (size_t i = 0; i < sizeof(s_encodings) / sizeof(s_encodings[0]); i++) {
+            if (!accepts_encoding(ae, s_encodings[i].token)) continue;
+
+            snprintf(variant, sizeof(variant), "%s.%s", file, s_encodings[i].ext);
+            if (opts.fs->st(variant, NULL, NULL) == 0) continue;
+
+            /* Content type comes from the original name, not the .br/.gz suffix */
+            snprintf(mime_override, sizeof(mime_override), "%s=%s", s_encodings[i].ext, mime);
+            snprintf(headers, sizeof(headers), "Content-Encoding: %s\r\n%s%s",
+                     s_encodings[i].token, cache, COMMON_HEADERS);
+            opts.mime_types = mime_override;
+            opts.extra_headers = headers;
+            mg_http_serve_file(c, hm, variant, &opts);
+            return;
+        }
+    }
+
+    /* Packed files with a .gz variant have no uncompressed copy */
+    if (mime && s_fs == &mg_fs_packed && opts.fs->st(file, NULL, NULL) == 0 &&
+        serve_inflated(c, hm, file, mime, cache)) {
+        return;
+    }
+
+    snprintf(headers, sizeof(headers), "%s%s", cache, COMMON_HEADERS);
+    opts.extra_headers = headers;
+    mg_http_serve_file(c, hm, file, &opts);
+}
+
+/**
+ * @brief Select where static files are served from
+ * @param web_root Directory to serve instead of the packed files, NULL for default
+ */
+void packed_fs_init(const char *web_root) {
+    if (web_root && web_root[0]) {
+        s_fs = &mg_fs_posix;
+        snprintf(s_root, sizeof(s_root), "%s", web_root);
+        printf("[WEB] 使用磁盘目录: %s\n", s_root);
+    } else if (mg_unpack("/index.html", NULL, NULL) != NULL ||
+               mg_unpack("/index.html.gz", NULL, NULL) != NULL) {
+        s_fs = &mg_fs_packed;
+        s_root[0] = '\0';
+        printf("[WEB] 使用内置页面\n");
+    } else {
+        s_fs = &mg_fs_posix;
+        snprintf(s_root, sizeof(s_root), "%s", STATIC_DIR);
+        printf("[WEB] 未内置页面，使用磁盘目录: %s\n", s_root);
+    }
+}
+
 /**
  * @brief Serve static files
  * @param c Mongoose connection
@@ -24,18 +231,25 @@ static struct mg_http_serve_opts s_opts = {
  * @return 1 success, 0 not found
  */
 int serve_packed_file(struct mg_connection *c, struct mg_http_message *hm) {
-    char path[512] = {0};
-    size_t len = hm->uri.len < sizeof(path) - 1 ? hm->uri.len : sizeof(path) - 1;
-    memcpy(path, hm->uri.buf, len);
+    char path[512];
+    char file[MG_PATH_MAX];
+
+    int n = mg_url_decode(hm->uri.buf, hm->uri.len, path, sizeof(path), 0);
+    if (n <= 0 || path[0] != '/' || !mg_path_is_sane(mg_str_n(path, (size_t)n))) {
+        mg_http_reply(c, 400, COMMON_HEADERS, "Bad request\n");
+        return 1;
+    }
 
     /* Root path or SPA routes - serve index.html */
-    if (strcmp(path, "/") == 0 || 
-        (strstr(path, ".") == NULL && strncmp(path, "/api/", 5) != 0)) {
-        mg_http_serve_file(c, hm, STATIC_DIR "/index.html", &s_opts);
+    if (strcmp(path, "/") == 0 ||
+        (strchr(path, '.') == NULL && strncmp(path, "/api/", 5) != 0)) {
+        snprintf(file, sizeof(file), "%s/index.html", s_root);
+        serve_static(c, hm, "/index.html", file);
         return 1;
     }
 
-    /* Serve static files from dist directory */
-    mg_http_serve_dir(c, hm, &s_opts);
+    /* Serve static files */
+    snprintf(file, sizeof(file), "%s%s", s_root, path);
+    serve_static(c, hm, path, file);
     return 1;
 }
@@ -13,6 +13,7 @@
 #include "dbus_core.h"
 #include "exec_utils.h"
 #include "http_utils.h"
+#include "json_writer.h"
 #include "ofono.h"
 
 /* 频段映射结构 */
@@ -98,12 +99,12 @@ void handle_get_bands(struct mg_connection *c, struct mg_http_message *hm) {
     printf("开始获取频段锁定状态...\n");
 
     /* 查询4G频段 */
-    if (execute_at("AT+SPLBAND=0", &result4G) == 0) {
+    if (execute_at_query(AT_QUERY_LTE_BANDS, &result4G) == 0) {
         printf("4G频段查询结果: %s\n", result4G);
     }
 
     /* 查询5G频段 */
-    if (execute_at("AT+SPLBAND=3", &result5G) == 0) {
+    if (execute_at_query(AT_QUERY_NR_BANDS, &result5G) == 0) {
         printf("5G频段查询结果: %s\n", result5G);
     }
 
@@ -375,6 +376,24 @@ static int is_5g_network(void) {
     return 0; /* 4G 或其他 */
 }
 
+/* 输出一个小区对象，band 为频段号（不含 N/B 前缀） */
+static void write_cell(JsonWriter *w, const char *rat, char band_prefix, const char *band,
+                       int arfcn, int pci, double rsrp, double rsrq, double sinr, int serving) {
+    char band_str[40];
+    snprintf(band_str, sizeof(band_str), "%c%s", band_prefix, band);
+
+    json_begin_object(w);
+    json_kv_string(w, "rat", rat);
+    json_kv_string(w, "band", band_str);
+    json_kv_int(w, "arfcn", arfcn);
+    json_kv_int(w, "pci", pci);
+    json_kv_double(w, "rsrp", rsrp, 2);
+    json_kv_double(w, "rsrq", rsrq, 2);
+    json_kv_double(w, "sinr", sinr, 2);
+    json_kv_bool(w, "isServing", serving);
+    json_end_object(w);
+}
+
 /* GET /api/cells - 获取小区信息 */
 void handle_get_cells(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_GET(c, hm);
@@ -386,24 +405,24 @@ void handle_get_cells(struct mg_connection *c, struct mg_http_message *hm) {
     int is_5g = is_5g_network();
     printf("检测到%s网络\n", is_5g ? "5G" : "4G");
 
-    char json[8192] = "{\"Code\":0,\"Error\":\"\",\"Data\":[";
-    int json_len = strlen(json);
+    JsonWriter w;
+    json_writer_init(&w);
+    json_begin_object(&w);
+    json_kv_int(&w, "Code", 0);
+    json_kv_string(&w, "Error", "");
+    json_key(&w, "Data");
+    json_begin_array(&w);
     int cell_count = 0;
 
     if (is_5g) {
         /* 5G 主小区 */
-        if (execute_at("AT+SPENGMD=0,14,1", &result) == 0 && result) {
+        if (execute_at_query(AT_QUERY_NR_SERVING, &result) == 0 && result) {
             char data[64][16][32] = {{{0}}};
             int rows = parse_cell_to_vec(result, data);
             if (rows > 15) {
-                char cell_json[512];
-                snprintf(cell_json, sizeof(cell_json),
-                    "{\"rat\":\"5G\",\"band\":\"N%s\",\"arfcn\":%d,\"pci\":%d,"
-                    "\"rsrp\":%.2f,\"rsrq\":%.2f,\"sinr\":%.2f,\"isServing\":true}",
-                    data[0][0], atoi(data[1][0]), atoi(data[2][0]),
-                    atof(data[3][0]) / 100.0, atof(data[4][0]) / 100.0,
-                    atof(data[15][0]) / 100.0);
-                json_len += snprintf(json + json_len, sizeof(json) - json_len, "%s", cell_json);
+                write_cell(&w, "5G", 'N', data[0][0], atoi(data[1][0]), atoi(data[2][0]),
+                           atof(data[3][0]) / 100.0, atof(data[4][0]) / 100.0,
+                           atof(data[15][0]) / 100.0, 1);
                 cell_count++;
             }
             g_free(result);
@@ -411,7 +430,7 @@ void handle_get_cells(struct mg_connection *c, struct mg_http_message *hm) {
         }
 
         /* 5G 邻小区 */
-        if (execute_at("AT+SPENGMD=0,14,2", &result) == 0 && result) {
+        if (execute_at_query(AT_QUERY_NR_NEIGHBOUR, &result) == 0 && result) {
             char data[64][16][32] = {{{0}}};
             int rows = parse_cell_to_vec(result, data);
             if (rows > 5) {
@@ -428,15 +447,9 @@ void handle_get_cells(struct mg_connection *c, struct mg_http_message *hm) {
                         band_str = arfcn_to_nr_band(arfcn);
                     }
                     
-                    char cell_json[512];
-                    snprintf(cell_json, sizeof(cell_json),
-                        "%s{\"rat\":\"5G\",\"band\":\"N%s\",\"arfcn\":%d,\"pci\":%d,"
-                        "\"rsrp\":%.2f,\"rsrq\":%.2f,\"sinr\":%.2f,\"isServing\":false}",
-                        cell_count > 0 ? "," : "",
-                        band_str, arfcn, pci,
-                        atof(data[3][i]) / 100.0, atof(data[4][i]) / 100.0,
-                        atof(data[5][i]) / 100.0);
-                    json_len += snprintf(json + json_len, sizeof(json) - json_len, "%s", cell_json);
+                    write_cell(&w, "5G", 'N', band_str, arfcn, pci,
+                               atof(data[3][i]) / 100.0, atof(data[4][i]) / 100.0,
+                               atof(data[5][i]) / 100.0, 0);
                     cell_count++;
                 }
             }
@@ -444,18 +457,13 @@ void handle_get_cells(struct mg_connection *c, struct mg_http_message *hm) {
         }
     } else {
         /* 4G 主小区 */
-        if (execute_at("AT+SPENGMD=0,6,0", &result) == 0 && result) {
+        if (execute_at_query(AT_QUERY_LTE_SERVING, &result) == 0 && result) {
             char data[64][16][32] = {{{0}}};
             int rows = parse_cell_to_vec(result, data);
             if (rows > 33) {
-                char cell_json[512];
-                snprintf(cell_json, sizeof(cell_json),
-                    "{\"rat\":\"4G\",\"band\":\"B%s\",\"arfcn\":%d,\"pci\":%d,"
-                    "\"rsrp\":%.2f,\"rsrq\":%.2f,\"sinr\":%.2f,\"isServing\":true}",
-                    data[0][0], atoi(data[1][0]), atoi(data[2][0]),
-                    atof(data[3][0]) / 100.0, atof(data[4][0]) / 100.0,
-                    atof(data[33][0]) / 100.0);
-                json_len += snprintf(json + json_len, sizeof(json) - json_len, "%s", cell_json);
+                write_cell(&w, "4G", 'B', data[0][0], atoi(data[1][0]), atoi(data[2][0]),
+                           atof(data[3][0]) / 100.0, atof(data[4][0]) / 100.0,
+                           atof(data[33][0]) / 100.0, 1);
                 cell_count++;
             }
             g_free(result);
@@ -463,7 +471,7 @@ void handle_get_cells(struct mg_connection *c, struct mg_http_message *hm) {
         }
 
         /* 4G 邻小区 */
-        if (execute_at("AT+SPENGMD=0,6,6", &result) == 0 && result) {
+        if (execute_at_query(AT_QUERY_LTE_NEIGHBOUR, &result) == 0 && result) {
             char data[64][16][32] = {{{0}}};
             int rows = parse_cell_to_vec(result, data);
             for (int i = 0; i < rows; i++) {
@@ -478,25 +486,20 @@ void handle_get_cells(struct mg_connection *c, struct mg_http_message *hm) {
                     if (strlen(band) == 0) band = "0";  /* 未知频段默认显示0 */
                 }
                 
-                char cell_json[512];
-                snprintf(cell_json, sizeof(cell_json),
-                    "%s{\"rat\":\"4G\",\"band\":\"B%s\",\"arfcn\":%d,\"pci\":%d,"
-                    "\"rsrp\":%.2f,\"rsrq\":%.2f,\"sinr\":%.2f,\"isServing\":false}",
-                    cell_count > 0 ? "," : "",
-                    band, arfcn, pci,
-                    atof(data[i][2]) / 100.0, atof(data[i][3]) / 100.0,
-                    atof(data[i][6]) / 100.0);
-                json_len += snprintf(json + json_len, sizeof(json) - json_len, "%s", cell_json);
+                write_cell(&w, "4G", 'B', band, arfcn, pci,
+                           atof(data[i][2]) / 100.0, atof(data[i][3]) / 100.0,
+                           atof(data[i][6]) / 100.0, 0);
                 cell_count++;
             }
             g_free(result);
         }
     }
 
-    snprintf(json + json_len, sizeof(json) - json_len, "]}");
+    json_end_array(&w);
+    json_end_object(&w);
     printf("小区信息获取完成，共 %d 个小区\n", cell_count);
 
-    HTTP_OK(c, json);
+    json_writer_reply(&w, c, 200, HTTP_CORS_HEADERS);
 }
 
 
@@ -19,65 +19,63 @@ static int g_apn_initialized = 0;
 /* 当前配置缓存 */
 static ApnConfig g_current_config = {0};
 
+/* 模板查询列（与 apn_template_row 的解析顺序一致） */
+#define APN_TEMPLATE_COLUMNS \
+    "id, name, apn, protocol, COALESCE(username, ''), COALESCE(password, ''), auth_method, created_at"
+
 /* 前向声明 */
-static int create_apn_tables(void);
 static int load_apn_config(void);
 static int apply_apn_to_ofono(const ApnTemplate *tpl);
 
 /**
- * 创建APN数据库表
+ * APN配置行回调 - 列: mode, template_id, auto_start
+ */
+static int apn_config_row(const DbValue *cols, int ncols, void *ctx) {
+    ApnConfig *config = (ApnConfig *)ctx;
+    if (ncols < 3) return 1;
+    
+    config->mode = (int)cols[0].i;
+    config->template_id = (int)cols[1].i;
+    config->auto_start = (int)cols[2].i;
+    return 1;
+}
+
+/**
+ * APN模板行回调 - 列顺序见 APN_TEMPLATE_COLUMNS
  */
-static int create_apn_tables(void) {
-    const char *sql = 
-        "CREATE TABLE IF NOT EXISTS apn_templates ("
-        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "name TEXT NOT NULL,"
-        "apn TEXT NOT NULL,"
-        "protocol TEXT DEFAULT 'dual',"
-        "username TEXT,"
-        "password TEXT,"
-        "auth_method TEXT DEFAULT 'chap',"
-        "created_at INTEGER NOT NULL"
-        ");"
-        "CREATE TABLE IF NOT EXISTS apn_config ("
-        "id INTEGER PRIMARY KEY DEFAULT 1,"
-        "mode INTEGER DEFAULT 0,"
-        "template_id INTEGER,"
-        "auto_start INTEGER DEFAULT 0"
-        ");";
-    
-    return db_execute(sql);
+static int apn_template_row(const DbValue *cols, int ncols, void *ctx) {
+    ApnTemplate *tpl = (ApnTemplate *)ctx;
+    if (ncols < 8) return 1;
+    
+    tpl->id = (int)cols[0].i;
+    db_value_copy(&cols[1], tpl->name, sizeof(tpl->name));
+    db_value_copy(&cols[2], tpl->apn, sizeof(tpl->apn));
+    db_value_copy(&cols[3], tpl->protocol, sizeof(tpl->protocol));
+    db_value_copy(&cols[4], tpl->username, sizeof(tpl->username));
+    db_value_copy(&cols[5], tpl->password, sizeof(tpl->password));
+    db_value_copy(&cols[6], tpl->auth_method, sizeof(tpl->auth_method));
+    tpl->created_at = (time_t)cols[7].i;
+    return 1;
 }
 
 /**
  * 加载APN配置
  */
 static int load_apn_config(void) {
-    char output[256];
-    const char *sql = "SELECT mode || '|' || COALESCE(template_id, 0) || '|' || auto_start FROM apn_config WHERE id = 1;";
+    ApnConfig config = { APN_MODE_AUTO, 0, 0 };
     
     pthread_mutex_lock(&g_apn_mutex);
-    int ret = db_query_string(sql, output, sizeof(output));
-    pthread_mutex_unlock(&g_apn_mutex);
-    
-    if (ret == 0 && strlen(output) > 0) {
-        char *p1 = strchr(output, '|');
-        if (p1) {
-            *p1 = '\0';
-            char *p2 = strchr(p1 + 1, '|');
-            if (p2) {
-                *p2 = '\0';
-                g_current_config.mode = atoi(output);
-                g_current_config.template_id = atoi(p1 + 1);
-                g_current_config.auto_start = atoi(p2 + 1);
-            }
-        }
-    } else {
+    int ret = db_query_each(
+        "SELECT mode, COALESCE(template_id, 0), auto_start FROM apn_config WHERE id = 1;",
+        NULL, apn_config_row, &config);
+    if (ret <= 0) {
         /* 默认配置：自动模式 */
-        g_current_config.mode = APN_MODE_AUTO;
-        g_current_config.template_id = 0;
-        g_current_config.auto_start = 0;
+        config.mode = APN_MODE_AUTO;
+        config.template_id = 0;
+        config.auto_start = 0;
     }
+    g_current_config = config;
+    pthread_mutex_unlock(&g_apn_mutex);
     
     printf("[APN] 配置加载完成: 模式=%d, 模板ID=%d, 自启动=%d\n", 
            g_current_config.mode, g_current_config.template_id, g_current_config.auto_start);
@@ -164,14 +162,9 @@ int apn_init(const char *db_path) {
     
     printf("[APN] 初始化APN模块\n");
     
-    /* 初始化数据库模块（如果还未初始化） */
-    if (db_path && strlen(db_path) > 0) {
-        db_init(db_path);
-    }
-    
-    /* 创建数据库表 */
-    if (create_apn_tables() != 0) {
-        printf("[APN] 创建数据库表失败\n");
+    /* 初始化数据库模块（如果还未初始化），APN表由数据库迁移创建 */
+    if (db_init(db_path) != 0) {
+        printf("[APN] 数据库初始化失败\n");
         return -1;
     }
     
@@ -185,50 +178,10 @@ int apn_init(const char *db_path) {
         
         printf("[APN] 检测到自启动配置，应用模板ID: %d\n", g_current_config.template_id);
         
-        /* 获取模板 */
+        /* 获取模板并应用 */
         ApnTemplate tpl;
-        char sql[256];
-        snprintf(sql, sizeof(sql),
-            "SELECT id, name, apn, protocol, username, password, auth_method, created_at "
-            "FROM apn_templates WHERE id = %d;", g_current_config.template_id);
-        
-        char output[1024];
-        pthread_mutex_lock(&g_apn_mutex);
-        int ret = db_query_rows(sql, "|", output, sizeof(output));
-        pthread_mutex_unlock(&g_apn_mutex);
-        
-        if (ret == 0 && strlen(output) > 0) {
-            /* 解析模板数据 */
-            char *fields[8] = {NULL};
-            int field_count = 0;
-            char *p = output;
-            char *start = p;
-            
-            while (*p && field_count < 8) {
-                if (*p == '|') {
-                    *p = '\0';
-                    fields[field_count++] = start;
-                    start = p + 1;
-                }
-                p++;
-            }
-            if (field_count < 8 && start) {
-                fields[field_count++] = start;
-            }
-            
-            if (field_count >= 8) {
-                tpl.id = atoi(fields[0]);
-                strncpy(tpl.name, fields[1], sizeof(tpl.name) - 1);
-                strncpy(tpl.apn, fields[2], sizeof(tpl.apn) - 1);
-                strncpy(tpl.protocol, fields[3], sizeof(tpl.protocol) - 1);
-                strncpy(tpl.username, fields[4], sizeof(tpl.username) - 1);
-                strncpy(tpl.password, fields[5], sizeof(tpl.password) - 1);
-                strncpy(tpl.auth_method, fields[6], sizeof(tpl.auth_method) - 1);
-                tpl.created_at = (time_t)atol(fields[7]);
-                
-                /* 应用模板 */
-                apply_apn_to_ofono(&tpl);
-            }
+        if (apn_template_get(g_current_config.template_id, &tpl) == 0) {
+            apply_apn_to_ofono(&tpl);
         }
     }
     
@@ -295,95 +248,46 @@ int apn_set_mode(int mode, int template_id, int auto_start) {
     return 0;
 }
 
+/* 模板列表行回调上下文 */
+typedef struct {
+    ApnTemplate *templates;
+    int max_count;
+    int count;
+} ApnListCtx;
+
+static int apn_template_list_row(const DbValue *cols, int ncols, void *ctx) {
+    ApnListCtx *list = (ApnListCtx *)ctx;
+    if (list->count >= list->max_count) return 1;
+    
+    ApnTemplate *tpl = &list->templates[list->count];
+    memset(tpl, 0, sizeof(ApnTemplate));
+    apn_template_row(cols, ncols, tpl);
+    list->count++;
+    return 0;
+}
+
 /**
  * 获取模板列表
  */
 int apn_template_list(ApnTemplate *templates, int max_count) {
-    char *output = NULL;
+    ApnListCtx ctx = { templates, max_count, 0 };
     
     if (!templates || max_count <= 0) {
         return -1;
     }
     
-    /* 分配大缓冲区 */
-    output = (char *)malloc(64 * 1024);
-    if (!output) {
-        return -1;
-    }
-    
-    const char *sql = 
-        "SELECT id || '|' || name || '|' || apn || '|' || protocol || '|' || "
-        "COALESCE(username, '') || '|' || COALESCE(password, '') || '|' || "
-        "auth_method || '|' || created_at FROM apn_templates ORDER BY id DESC;";
-    
     pthread_mutex_lock(&g_apn_mutex);
-    int ret = db_query_string(sql, output, 64 * 1024);
+    int ret = db_query_each(
+        "SELECT " APN_TEMPLATE_COLUMNS " FROM apn_templates ORDER BY id DESC;",
+        NULL, apn_template_list_row, &ctx);
     pthread_mutex_unlock(&g_apn_mutex);
     
-    if (ret != 0 || strlen(output) == 0) {
-        free(output);
+    if (ret < 0) {
         return 0;
     }
     
-    /* 解析输出 */
-    int count = 0;
-    char *line = output;
-    char *next_line;
-    
-    while (line && *line && count < max_count) {
-        next_line = strchr(line, '\n');
-        if (next_line) {
-            *next_line = '\0';
-            next_line++;
-        }
-        
-        if (strlen(line) == 0) {
-            line = next_line;
-            continue;
-        }
-        
-        /* 解析字段 */
-        char *fields[8] = {NULL};
-        int field_count = 0;
-        char *p = line;
-        char *start = p;
-        
-        while (*p && field_count < 8) {
-            if (*p == '|') {
-                *p = '\0';
-                fields[field_count++] = start;
-                start = p + 1;
-            }
-            p++;
-        }
-        if (field_count < 8 && start) {
-            fields[field_count++] = start;
-        }
-        
-        if (field_count >= 8) {
-            templates[count].id = atoi(fields[0]);
-            strncpy(templates[count].name, fields[1], sizeof(templates[count].name) - 1);
-            templates[count].name[sizeof(templates[count].name) - 1] = '\0';
-            strncpy(templates[count].apn, fields[2], sizeof(templates[count].apn) - 1);
-            templates[count].apn[sizeof(templates[count].apn) - 1] = '\0';
-            strncpy(templates[count].protocol, fields[3], sizeof(templates[count].protocol) - 1);
-            templates[count].protocol[sizeof(templates[count].protocol) - 1] = '\0';
-            strncpy(templates[count].username, fields[4], sizeof(templates[count].username) - 1);
-            templates[count].username[sizeof(templates[count].username) - 1] = '\0';
-            strncpy(templates[count].password, fields[5], sizeof(templates[count].password) - 1);
-            templates[count].password[sizeof(templates[count].password) - 1] = '\0';
-            strncpy(templates[count].auth_method, fields[6], sizeof(templates[count].auth_method) - 1);
-            templates[count].auth_method[sizeof(templates[count].auth_method) - 1] = '\0';
-            templates[count].created_at = (time_t)atol(fields[7]);
-            count++;
-        }
-        
-        line = next_line;
-    }
-    
-    free(output);
-    printf("[APN] 获取到 %d 个模板\n", count);
-    return count;
+    printf("[APN] 获取到 %d 个模板\n", ctx.count);
+    return ctx.count;
 }
 
 /**
@@ -511,8 +415,6 @@ int apn_template_delete(int id) {
  * 应用模板
  */
 int apn_apply_template(int template_id) {
-    char sql[256];
-    char output[1024];
     ApnTemplate tpl;
     
     if (template_id <= 0) {
@@ -521,57 +423,11 @@ int apn_apply_template(int template_id) {
     }
     
     /* 查询模板 */
-    snprintf(sql, sizeof(sql),
-        "SELECT id, name, apn, protocol, username, password, auth_method, created_at "
-        "FROM apn_templates WHERE id = %d;", template_id);
-    
-    pthread_mutex_lock(&g_apn_mutex);
-    int ret = db_query_rows(sql, "|", output, sizeof(output));
-    pthread_mutex_unlock(&g_apn_mutex);
-    
-    if (ret != 0 || strlen(output) == 0) {
+    if (apn_template_get(template_id, &tpl) != 0) {
         printf("[APN] 模板不存在: %d\n", template_id);
         return -1;
     }
     
-    /* 解析模板数据 */
-    char *fields[8] = {NULL};
-    int field_count = 0;
-    char *p = output;
-    char *start = p;
-    
-    while (*p && field_count < 8) {
-        if (*p == '|') {
-            *p = '\0';
-            fields[field_count++] = start;
-            start = p + 1;
-        }
-        p++;
-    }
-    if (field_count < 8 && start) {
-        fields[field_count++] = start;
-    }
-    
-    if (field_count < 8) {
-        printf("[APN] 模板数据解析失败\n");
-        return -1;
-    }
-    
-    tpl.id = atoi(fields[0]);
-    strncpy(tpl.name, fields[1], sizeof(tpl.name) - 1);
-    tpl.name[sizeof(tpl.name) - 1] = '\0';
-    strncpy(tpl.apn, fields[2], sizeof(tpl.apn) - 1);
-    tpl.apn[sizeof(tpl.apn) - 1] = '\0';
-    strncpy(tpl.protocol, fields[3], sizeof(tpl.protocol) - 1);
-    tpl.protocol[sizeof(tpl.protocol) - 1] = '\0';
-    strncpy(tpl.username, fields[4], sizeof(tpl.username) - 1);
-    tpl.username[sizeof(tpl.username) - 1] = '\0';
-    strncpy(tpl.password, fields[5], sizeof(tpl.password) - 1);
-    tpl.password[sizeof(tpl.password) - 1] = '\0';
-    strncpy(tpl.auth_method, fields[6], sizeof(tpl.auth_method) - 1);
-    tpl.auth_method[sizeof(tpl.auth_method) - 1] = '\0';
-    tpl.created_at = (time_t)atol(fields[7]);
-    
     /* 应用到oFono */
     return apply_apn_to_ofono(&tpl);
 }
@@ -629,59 +485,21 @@ int apn_clear_all(void) {
  * 获取模板详情
  */
 int apn_template_get(int id, ApnTemplate *tpl) {
-    char sql[256];
-    char output[1024];
-    
     if (id <= 0 || !tpl) {
         return -1;
     }
     
     memset(tpl, 0, sizeof(ApnTemplate));
     
-    snprintf(sql, sizeof(sql),
-        "SELECT id, name, apn, protocol, username, password, auth_method, created_at "
-        "FROM apn_templates WHERE id = %d;", id);
+    DbValue args[] = { DB_ARG_INT(id), DB_ARG_END };
     
     pthread_mutex_lock(&g_apn_mutex);
-    int ret = db_query_rows(sql, "|", output, sizeof(output));
+    int ret = db_query_each(
+        "SELECT " APN_TEMPLATE_COLUMNS " FROM apn_templates WHERE id = ?1;",
+        args, apn_template_row, tpl);
     pthread_mutex_unlock(&g_apn_mutex);
     
-    if (ret != 0 || strlen(output) == 0) {
-        return -1;
-    }
-    
-    /* 解析模板数据 */
-    char *fields[8] = {NULL};
-    int field_count = 0;
-    char *p = output;
-    char *start = p;
-    
-    while (*p && field_count < 8) {
-        if (*p == '|') {
-            *p = '\0';
-            fields[field_count++] = start;
-            start = p + 1;
-        }
-        p++;
-    }
-    if (field_count < 8 && start) {
-        fields[field_count++] = start;
-    }
-    
-    if (field_count < 8) {
-        return -1;
-    }
-    
-    tpl->id = atoi(fields[0]);
-    strncpy(tpl->name, fields[1], sizeof(tpl->name) - 1);
-    strncpy(tpl->apn, fields[2], sizeof(tpl->apn) - 1);
-    strncpy(tpl->protocol, fields[3], sizeof(tpl->protocol) - 1);
-    strncpy(tpl->username, fields[4], sizeof(tpl->username) - 1);
-    strncpy(tpl->password, fields[5], sizeof(tpl->password) - 1);
-    strncpy(tpl->auth_method, fields[6], sizeof(tpl->auth_method) - 1);
-    tpl->created_at = (time_t)atol(fields[7]);
-    
-    return 0;
+    return ret > 0 ? 0 : -1;
 }
 
 /**
@@ -9,6 +9,7 @@
 #include <time.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <pthread.h>
 #include "auth.h"
 #include "sha256.h"
 #include "database.h"
@@ -71,36 +72,239 @@ static int verify_password(const char *password)
     return (strcmp(stored_hash, input_hash) == 0) ? 0 : -1;
 }
 
+/*============================================================================
+ * 内存Token表
+ *
+ * 有效Token常驻内存，按 expire_time 组织为最小堆（最多 AUTH_MAX_TOKENS 个）。
+ * 有效期固定，堆顶既是最先过期的也是最早创建的Token。
+ * 数据库仅作持久化，写入交给DB工作线程，请求路径不访问数据库。
+ *============================================================================*/
+
+typedef struct {
+    char token[AUTH_TOKEN_SIZE];
+    long long expire_time;
+    long long created_at;
+    long long seq;          /* 登录顺序，同一秒内登录时区分先后 */
+} AuthToken;
+
+static AuthToken g_tokens[AUTH_MAX_TOKENS];
+static int g_token_count = 0;
+static long long g_token_seq = 0;
+static pthread_mutex_t g_token_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* 持久化操作 */
+typedef enum {
+    AUTH_PERSIST_INSERT,
+    AUTH_PERSIST_DELETE,
+    AUTH_PERSIST_CLEAR,
+    AUTH_PERSIST_PURGE
+} AuthPersistOp;
+
+typedef struct {
+    AuthPersistOp op;
+    AuthToken tok;
+} AuthPersistJob;
+
 /**
- * 清理过期Token
+ * 常量时间比较两个Token（长度均为 AUTH_TOKEN_SIZE-1）
  */
-static int cleanup_expired_tokens(void)
+static int token_equal(const char *a, const char *b)
 {
-    char sql[256];
-    long long now = (long long)time(NULL);
+    unsigned char diff = 0;
+    for (int i = 0; i < AUTH_TOKEN_SIZE - 1; i++) {
+        diff |= (unsigned char)(a[i] ^ b[i]);
+    }
+    return diff == 0;
+}
+
+static void token_swap(int i, int j)
+{
+    AuthToken tmp = g_tokens[i];
+    g_tokens[i] = g_tokens[j];
+    g_tokens[j] = tmp;
+}
+
+/**
+ * 堆序：过期时间早者在前，相同则先登录者在前
+ */
+static int token_before(const AuthToken *a, const AuthToken *b)
+{
+    if (a->expire_time != b->expire_time) {
+        return a->expire_time < b->expire_time;
+    }
+    return a->seq < b->seq;
+}
+
+static void token_sift_up(int i)
+{
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!token_before(&g_tokens[i], &g_tokens[parent])) break;
+        token_swap(i, parent);
+        i = parent;
+    }
+}
+
+static void token_sift_down(int i)
+{
+    for (;;) {
+        int min = i, l = 2 * i + 1, r = 2 * i + 2;
+        if (l < g_token_count && token_before(&g_tokens[l], &g_tokens[min])) min = l;
+        if (r < g_token_count && token_before(&g_tokens[r], &g_tokens[min])) min = r;
+        if (min == i) break;
+        token_swap(i, min);
+        i = min;
+    }
+}
+
+static void token_push(const AuthToken *tok)
+{
+    g_tokens[g_token_count] = *tok;
+    token_sift_up(g_token_count++);
+}
+
+static void token_remove_at(int i)
+{
+    g_tokens[i] = g_tokens[--g_token_count];
+    if (i < g_token_count) {
+        token_sift_down(i);
+        token_sift_up(i);
+    }
+    memset(&g_tokens[g_token_count], 0, sizeof(AuthToken));
+}
+
+/**
+ * 查找Token（扫描全部槽位，耗时与匹配位置无关）
+ * @return 下标，-1未找到
+ */
+static int token_find(const char *token)
+{
+    int found = -1;
     
-    snprintf(sql, sizeof(sql),
-        "DELETE FROM auth_tokens WHERE expire_time <= %lld;", now);
+    if (strlen(token) != AUTH_TOKEN_SIZE - 1) {
+        return -1;
+    }
+    for (int i = 0; i < g_token_count; i++) {
+        if (token_equal(g_tokens[i].token, token)) {
+            found = i;
+        }
+    }
+    return found;
+}
+
+/**
+ * 弹出已过期Token
+ * @return 弹出数量
+ */
+static int token_expire(long long now)
+{
+    int n = 0;
+    while (g_token_count > 0 && g_tokens[0].expire_time <= now) {
+        token_remove_at(0);
+        n++;
+    }
+    return n;
+}
+
+/**
+ * 持久化任务（DB工作线程）
+ */
+static void auth_persist_job(void *arg)
+{
+    AuthPersistJob *job = (AuthPersistJob *)arg;
+    
+    switch (job->op) {
+        case AUTH_PERSIST_INSERT: {
+            DbValue args[] = { DB_ARG_TEXT(job->tok.token), DB_ARG_INT(job->tok.expire_time),
+                               DB_ARG_INT(job->tok.created_at), DB_ARG_END };
+            db_query_each("INSERT OR REPLACE INTO auth_tokens (token, expire_time, created_at) "
+                          "VALUES (?1, ?2, ?3);", args, NULL, NULL);
+            break;
+        }
+        case AUTH_PERSIST_DELETE: {
+            DbValue args[] = { DB_ARG_TEXT(job->tok.token), DB_ARG_END };
+            db_query_each("DELETE FROM auth_tokens WHERE token = ?1;", args, NULL, NULL);
+            break;
+        }
+        case AUTH_PERSIST_CLEAR:
+            db_execute("DELETE FROM auth_tokens;");
+            break;
+        case AUTH_PERSIST_PURGE: {
+            DbValue args[] = { DB_ARG_INT(job->tok.expire_time), DB_ARG_END };
+            db_query_each("DELETE FROM auth_tokens WHERE expire_time <= ?1;", args, NULL, NULL);
+            break;
+        }
+    }
+    free(job);
+}
+
+/**
+ * 提交持久化任务（调用者持有 g_token_mutex，保证写库顺序与内存中的增删顺序一致）
+ */
+static void auth_persist(AuthPersistOp op, const AuthToken *tok)
+{
+    AuthPersistJob *job = calloc(1, sizeof(AuthPersistJob));
+    if (!job) return;
     
-    return db_execute_safe(sql);
+    job->op = op;
+    if (tok) {
+        job->tok = *tok;
+    }
+    db_async_submit_ordered(auth_persist_job, NULL, job);
 }
 
 /**
- * 获取当前Token数量
+ * 弹出过期Token并持久化清理（调用者持有 g_token_mutex）
  */
-static int get_token_count(void)
+static void token_expire_and_purge(void)
 {
-    return db_query_int("SELECT COUNT(*) FROM auth_tokens;", 0);
+    long long now = (long long)time(NULL);
+    
+    if (token_expire(now) > 0) {
+        AuthToken tok = { .expire_time = now };
+        auth_persist(AUTH_PERSIST_PURGE, &tok);
+    }
 }
 
 /**
- * 删除最早的Token
+ * 从数据库加载未过期Token（保留最新的 AUTH_MAX_TOKENS 个）
  */
-static int delete_oldest_token(void)
+static int token_load_row(const DbValue *cols, int ncols, void *ctx)
+{
+    (void)ctx;
+    if (ncols < 4 || cols[0].type != DB_TYPE_TEXT || cols[0].len != AUTH_TOKEN_SIZE - 1) {
+        return 0;
+    }
+    
+    AuthToken tok;
+    memcpy(tok.token, cols[0].data, AUTH_TOKEN_SIZE - 1);
+    tok.token[AUTH_TOKEN_SIZE - 1] = '\0';
+    tok.expire_time = cols[1].i;
+    tok.created_at = cols[2].i;
+    tok.seq = cols[3].i;
+    if (tok.seq > g_token_seq) {
+        g_token_seq = tok.seq;
+    }
+    token_push(&tok);
+    
+    return g_token_count >= AUTH_MAX_TOKENS;
+}
+
+static void token_load(void)
 {
-    return db_execute_safe(
-        "DELETE FROM auth_tokens WHERE id = "
-        "(SELECT id FROM auth_tokens ORDER BY created_at ASC LIMIT 1);");
+    long long now = (long long)time(NULL);
+    DbValue args[] = { DB_ARG_INT(now), DB_ARG_END };
+    
+    pthread_mutex_lock(&g_token_mutex);
+    g_token_count = 0;
+    db_query_each("SELECT token, expire_time, created_at, id FROM auth_tokens "
+                  "WHERE expire_time > ?1 ORDER BY expire_time DESC, id DESC;",
+                  args, token_load_row, NULL);
+    pthread_mutex_unlock(&g_token_mutex);
+    
+    /* 清理数据库中的过期Token */
+    db_query_each("DELETE FROM auth_tokens WHERE expire_time <= ?1;", args, NULL, NULL);
+    printf("[AUTH] 已加载 %d 个有效Token\n", g_token_count);
 }
 
 
@@ -121,8 +325,8 @@ int auth_init(void)
         }
     }
     
-    /* 启动时清理过期Token */
-    cleanup_expired_tokens();
+    /* 启动时加载有效Token到内存 */
+    token_load();
     
     printf("[AUTH] 认证模块初始化完成\n");
     return 0;
@@ -130,10 +334,6 @@ int auth_init(void)
 
 int auth_login(const char *password, char *token, size_t token_size)
 {
-    char sql[512];
-    long long now, expire_time;
-    int count;
-    
     if (!password || !token || token_size < AUTH_TOKEN_SIZE) {
         return -2;
     }
@@ -146,69 +346,58 @@ int auth_login(const char *password, char *token, size_t token_size)
         return -1;
     }
     
-    /* 先清理过期Token */
-    cleanup_expired_tokens();
-    
-    /* 检查Token数量，超过限制则删除最早的 */
-    count = get_token_count();
-    while (count >= AUTH_MAX_TOKENS && count > 0) {
-        printf("[AUTH] Token数量已达上限(%d)，删除最早的Token\n", AUTH_MAX_TOKENS);
-        delete_oldest_token();
-        count--;
-    }
-    
     /* 生成新Token */
-    if (generate_token(token, token_size) != 0) {
+    AuthToken tok;
+    if (generate_token(tok.token, sizeof(tok.token)) != 0) {
         printf("[AUTH] 生成Token失败\n");
         return -2;
     }
     
     /* 计算过期时间 */
-    now = (long long)time(NULL);
-    expire_time = now + AUTH_TOKEN_EXPIRE_SECONDS;
+    tok.created_at = (long long)time(NULL);
+    tok.expire_time = tok.created_at + AUTH_TOKEN_EXPIRE_SECONDS;
     
-    /* 插入新Token */
-    snprintf(sql, sizeof(sql),
-        "INSERT INTO auth_tokens (token, expire_time, created_at) VALUES ('%s', %lld, %lld);",
-        token, expire_time, now);
+    pthread_mutex_lock(&g_token_mutex);
+    tok.seq = ++g_token_seq;
+    token_expire_and_purge();
     
-    if (db_execute_safe(sql) != 0) {
-        printf("[AUTH] 保存Token失败\n");
-        return -2;
+    /* Token数量已达上限，删除最早的（堆顶） */
+    if (g_token_count >= AUTH_MAX_TOKENS) {
+        printf("[AUTH] Token数量已达上限(%d)，删除最早的Token\n", AUTH_MAX_TOKENS);
+        auth_persist(AUTH_PERSIST_DELETE, &g_tokens[0]);
+        token_remove_at(0);
     }
     
+    token_push(&tok);
+    auth_persist(AUTH_PERSIST_INSERT, &tok);
     printf("[AUTH] 登录成功，Token有效期: %d秒，当前Token数: %d\n", 
-           AUTH_TOKEN_EXPIRE_SECONDS, get_token_count());
+           AUTH_TOKEN_EXPIRE_SECONDS, g_token_count);
+    pthread_mutex_unlock(&g_token_mutex);
+    
+    strncpy(token, tok.token, token_size - 1);
+    token[token_size - 1] = '\0';
     return 0;
 }
 
 
 int auth_verify_token(const char *token)
 {
-    char sql[512];
-    long long now;
-    int count;
+    int found;
     
     if (!token || strlen(token) == 0) {
         return -1;
     }
     
-    now = (long long)time(NULL);
-    
-    /* 查询Token是否存在且未过期 */
-    snprintf(sql, sizeof(sql),
-        "SELECT COUNT(*) FROM auth_tokens WHERE token='%s' AND expire_time > %lld;",
-        token, now);
-    
-    count = db_query_int(sql, 0);
-    
-    if (count > 0) {
-        return 0;  /* Token有效 */
+    pthread_mutex_lock(&g_token_mutex);
+    found = token_find(token);
+    if (found >= 0 && g_tokens[found].expire_time <= (long long)time(NULL)) {
+        /* 已过期 */
+        token_expire_and_purge();
+        found = -1;
     }
+    pthread_mutex_unlock(&g_token_mutex);
     
-    /* Token无效或已过期，尝试清理 */
-    cleanup_expired_tokens();
-    return -1;
+    return found >= 0 ? 0 : -1;
 }
 
 int auth_change_password(const char *old_password, const char *new_password)
@@ -242,7 +431,11 @@ int auth_change_password(const char *old_password, const char *new_password)
     }
     
     /* 清除所有Token，强制所有设备重新登录 */
-    db_execute_safe("DELETE FROM auth_tokens;");
+    pthread_mutex_lock(&g_token_mutex);
+    memset(g_tokens, 0, sizeof(g_tokens));
+    g_token_count = 0;
+    auth_persist(AUTH_PERSIST_CLEAR, NULL);
+    pthread_mutex_unlock(&g_token_mutex);
     
     printf("[AUTH] 密码修改成功，所有设备需重新登录\n");
     return 0;
@@ -250,19 +443,20 @@ int auth_change_password(const char *old_password, const char *new_password)
 
 int auth_logout(const char *token)
 {
-    char sql[256];
+    int found;
     
     if (!token || strlen(token) == 0) {
         return -1;
     }
     
     /* 只删除指定Token，不影响其他设备 */
-    snprintf(sql, sizeof(sql),
-        "DELETE FROM auth_tokens WHERE token='%s';", token);
-    
-    if (db_execute_safe(sql) != 0) {
-        return -1;
+    pthread_mutex_lock(&g_token_mutex);
+    found = token_find(token);
+    if (found >= 0) {
+        auth_persist(AUTH_PERSIST_DELETE, &g_tokens[found]);
+        token_remove_at(found);
     }
+    pthread_mutex_unlock(&g_token_mutex);
     
     printf("[AUTH] 登出成功\n");
     return 0;
@@ -270,22 +464,15 @@ int auth_logout(const char *token)
 
 int auth_get_status(int *logged_in)
 {
-    int count;
-    
     if (!logged_in) {
         return -1;
     }
     
-    *logged_in = 0;
-    
-    /* 先清理过期Token */
-    cleanup_expired_tokens();
-    
-    /* 检查是否有有效Token */
-    count = get_token_count();
-    if (count > 0) {
-        *logged_in = 1;
-    }
+    /* 先清理过期Token，再检查是否有有效Token */
+    pthread_mutex_lock(&g_token_mutex);
+    token_expire_and_purge();
+    *logged_in = g_token_count > 0 ? 1 : 0;
+    pthread_mutex_unlock(&g_token_mutex);
     
     return 0;
 }
@@ -100,18 +100,28 @@ static int set_charging(int enable) {
     return 0;
 }
 
-/* 加载充电配置 - 从SQLite数据库读取 */
+/* 加载充电配置 - 从配置缓存读取 */
 static void load_charge_config(void) {
+    pthread_mutex_lock(&charge_mutex);
     charge_config.enabled = config_get_int("charge_enabled", 0);
     charge_config.start_threshold = config_get_int("charge_start_threshold", 20);
     charge_config.stop_threshold = config_get_int("charge_stop_threshold", 80);
+    pthread_mutex_unlock(&charge_mutex);
 }
 
-/* 保存充电配置 - 写入SQLite数据库 */
-static void save_charge_config(void) {
-    config_set_int("charge_enabled", charge_config.enabled);
-    config_set_int("charge_start_threshold", charge_config.start_threshold);
-    config_set_int("charge_stop_threshold", charge_config.stop_threshold);
+/* 保存充电配置 - 单事务写入SQLite数据库，生效由配置变更回调完成 */
+static int save_charge_config(const ChargeConfig *cfg) {
+    char enabled[16], start[16], stop[16];
+    snprintf(enabled, sizeof(enabled), "%d", cfg->enabled);
+    snprintf(start, sizeof(start), "%d", cfg->start_threshold);
+    snprintf(stop, sizeof(stop), "%d", cfg->stop_threshold);
+
+    ConfigKV kvs[] = {
+        { "charge_enabled", enabled },
+        { "charge_start_threshold", start },
+        { "charge_stop_threshold", stop },
+    };
+    return config_set_many(kvs, sizeof(kvs) / sizeof(kvs[0]));
 }
 
 /* 检查并控制充电 */
@@ -289,9 +299,53 @@ static void stop_charge_monitor(void) {
     printf("[charge] uevent 监听已停止\n");
 }
 
+/* 重新加载配置并启停监控 */
+static void apply_charge_config(void) {
+    pthread_mutex_lock(&charge_mutex);
+    int was_enabled = charge_config.enabled;
+    pthread_mutex_unlock(&charge_mutex);
+
+    load_charge_config();
+
+    pthread_mutex_lock(&charge_mutex);
+    int enabled = charge_config.enabled;
+    pthread_mutex_unlock(&charge_mutex);
+
+    if (enabled) {
+        start_charge_monitor();
+    } else if (was_enabled) {
+        stop_charge_monitor();
+    }
+}
+
+/* 已排队、尚未执行的配置重新加载 */
+static gint charge_apply_pending = 0;
+
+static gboolean apply_charge_config_idle(gpointer user_data) {
+    (void)user_data;
+    g_atomic_int_set(&charge_apply_pending, 0);
+    apply_charge_config();
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * 配置变更回调 - charge_* 键被写入时触发
+ * 一次保存会写入多个键，合并为主循环中的一次重新加载。
+ * 高优先级保证在处理下一个HTTP请求之前生效
+ */
+static void on_charge_config_changed(const char *key, const char *value, void *user_data) {
+    (void)value;
+    (void)user_data;
+    printf("[charge] 配置变更: %s\n", key);
+    if (g_atomic_int_compare_and_exchange(&charge_apply_pending, 0, 1)) {
+        g_idle_add_full(G_PRIORITY_HIGH, apply_charge_config_idle, NULL, NULL);
+    }
+}
+
 /* 初始化充电控制 */
 void init_charge(void) {
     load_charge_config();
+    config_watch("charge_", on_charge_config_changed, NULL);
 
     if (charge_config.enabled) {
         start_charge_monitor();
@@ -348,20 +402,11 @@ void handle_charge_config(struct mg_connection *c, struct mg_http_message *hm) {
             return;
         }
 
-        /* 更新配置 */
-        pthread_mutex_lock(&charge_mutex);
-        int was_enabled = charge_config.enabled;
-        charge_config.enabled = enabled;
-        charge_config.start_threshold = start;
-        charge_config.stop_threshold = stop;
-        pthread_mutex_unlock(&charge_mutex);
-
-        save_charge_config();
-
-        if (enabled) {
-            start_charge_monitor();
-        } else if (was_enabled) {
-            stop_charge_monitor();
+        /* 保存配置，由 on_charge_config_changed 合并后重新加载并启停监控 */
+        ChargeConfig cfg = { enabled, start, stop };
+        if (save_charge_config(&cfg) != 0) {
+            HTTP_OK(c, "{\"Code\":1,\"Error\":\"保存充电配置失败\",\"Data\":null}");
+            return;
         }
 
         HTTP_OK(c, "{\"Code\":0,\"Error\":\"\",\"Data\":\"充电配置已更新\"}");
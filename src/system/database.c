@@ -1,6 +1,9 @@
 /**
  * @file database.c
  * @brief 数据库操作模块实现 - SQLite3 统一接口
+ *
+ * 基于SQLite C API，进程内保持单一长连接（WAL模式），
+ * 并按SQL文本缓存预编译语句，所有访问由 g_db_mutex 串行化
  */
 
 #include <stdio.h>
@@ -8,26 +11,380 @@
 #include <string.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <sqlite3.h>
+#include <glib.h>
 #include "database.h"
-#include "exec_utils.h"
+#include "metrics.h"
 
 /*============================================================================
  * 全局变量
  *============================================================================*/
 
+/* 预编译语句缓存容量 */
+#define DB_STMT_CACHE_SIZE 24
+
+/* 忙等待超时（毫秒），外部进程持有写锁时使用 */
+#define DB_BUSY_TIMEOUT_MS 3000
+
+/* 组提交收集窗口（微秒）：上一事务提交期间有其他写者到达时，再等这么久合并后续写入 */
+#define CONFIG_GROUP_COMMIT_WINDOW_US 3000
+
+/* 异步任务队列容量 */
+#define DB_ASYNC_QUEUE_SIZE 64
+
+/* 热数据库目录（tmpfs）与默认检查点间隔（秒） */
+#define DB_HOT_DIR "/tmp"
+#define DB_CHECKPOINT_INTERVAL_DEFAULT 300
+#define DB_CHECKPOINT_INTERVAL_MIN 30
+
+/* 检查点每步复制的页数与步间让出时间（毫秒）：步与步之间释放 g_db_mutex，主循环的查询不必等整库写完 */
+#define DB_CHECKPOINT_STEP_PAGES 64
+#define DB_CHECKPOINT_STEP_SLEEP_MS 2
+
+/* 预编译语句缓存项（按SQL文本索引） */
+typedef struct {
+    char *sql;
+    unsigned int hash;
+    sqlite3_stmt *stmt;
+    unsigned long last_used;
+} DbStmtCacheEntry;
+
 static char g_db_path[256] = "6677.db";
+static char g_db_hot_path[sizeof(DB_HOT_DIR) + sizeof(g_db_path)] = "";  /* 非空表示热数据库模式 */
+static long long g_db_checkpoint_changes = -1;
+static guint g_db_checkpoint_source = 0;
 static pthread_mutex_t g_db_mutex = PTHREAD_MUTEX_INITIALIZER;
 static int g_db_initialized = 0;
+static sqlite3 *g_db = NULL;
+static DbStmtCacheEntry g_stmt_cache[DB_STMT_CACHE_SIZE];
+static unsigned long g_stmt_clock = 0;
+
+/* 配置变更监听项 */
+typedef struct {
+    char prefix[64];
+    config_change_callback_t callback;
+    void *user_data;
+} ConfigWatcher;
+
+/* config 表内存缓存（读写锁保护），NULL表示尚未加载 */
+static GHashTable *g_config_cache = NULL;
+static pthread_rwlock_t g_config_lock = PTHREAD_RWLOCK_INITIALIZER;
+static ConfigWatcher g_config_watchers[CONFIG_MAX_WATCHERS];
+static int g_config_watcher_count = 0;
+
+/* 组提交：写请求队列（节点位于各写者栈上，完成前有效） */
+typedef struct ConfigWriteReq {
+    const ConfigKV *kvs;
+    size_t n;
+    unsigned char *changed;
+    int result;
+    int done;
+    struct ConfigWriteReq *next;
+} ConfigWriteReq;
+
+static pthread_mutex_t g_commit_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_commit_cond = PTHREAD_COND_INITIALIZER;
+static ConfigWriteReq *g_commit_head = NULL;
+static ConfigWriteReq *g_commit_tail = NULL;
+static int g_commit_leader = 0;
+
+/* 异步任务 */
+typedef struct {
+    db_job_func_t job;
+    db_done_func_t done;
+    void *arg;
+} DbAsyncTask;
+
+/* 异步工作线程与有界任务队列（环形缓冲） */
+static pthread_t g_async_thread;
+static pthread_mutex_t g_async_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_async_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t g_async_space_cond = PTHREAD_COND_INITIALIZER;   /* 出队时通知 */
+static DbAsyncTask g_async_queue[DB_ASYNC_QUEUE_SIZE];
+static int g_async_head = 0;
+static int g_async_count = 0;
+static int g_async_running = 0;
+
+/* 前向声明 */
+static int config_cache_load(void);
+static void config_cache_free(void);
 
 /*============================================================================
- * 内部函数
+ * 内部函数（调用者必须持有 g_db_mutex）
  *============================================================================*/
 
 /**
- * 创建数据库表结构
+ * 当前实际读写的数据库文件（热数据库模式下位于tmpfs）
+ */
+static const char *db_live_path(void) {
+    return g_db_hot_path[0] ? g_db_hot_path : g_db_path;
+}
+
+/**
+ * SQL文本哈希 (FNV-1a)
+ */
+static unsigned int db_hash_sql(const char *sql) {
+    unsigned int h = 2166136261u;
+    while (*sql) {
+        h ^= (unsigned char)*sql++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * 释放所有缓存的预编译语句
  */
-static int db_create_tables(void) {
-    const char *sql = 
+static void db_stmt_cache_clear(void) {
+    for (int i = 0; i < DB_STMT_CACHE_SIZE; i++) {
+        if (g_stmt_cache[i].stmt) {
+            sqlite3_finalize(g_stmt_cache[i].stmt);
+        }
+        free(g_stmt_cache[i].sql);
+        memset(&g_stmt_cache[i], 0, sizeof(DbStmtCacheEntry));
+    }
+}
+
+/**
+ * 打开数据库连接（已打开则直接返回）
+ * 使用WAL模式：读写互不阻塞，提交只追加日志，减少闪存fsync
+ */
+static int db_open_locked(void) {
+    if (g_db) {
+        return 0;
+    }
+    
+    int rc = sqlite3_open_v2(db_live_path(), &g_db,
+        SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, NULL);
+    if (rc != SQLITE_OK) {
+        printf("[DB] 打开数据库失败: %s\n", g_db ? sqlite3_errmsg(g_db) : sqlite3_errstr(rc));
+        if (g_db) {
+            sqlite3_close(g_db);
+            g_db = NULL;
+        }
+        return -1;
+    }
+    
+    sqlite3_busy_timeout(g_db, DB_BUSY_TIMEOUT_MS);
+    sqlite3_exec(g_db, "PRAGMA journal_mode=WAL;", NULL, NULL, NULL);
+    sqlite3_exec(g_db, "PRAGMA synchronous=NORMAL;", NULL, NULL, NULL);
+    return 0;
+}
+
+/**
+ * 关闭数据库连接
+ */
+static void db_close_locked(void) {
+    db_stmt_cache_clear();
+    if (g_db) {
+        sqlite3_close(g_db);
+        g_db = NULL;
+    }
+}
+
+/**
+ * 获取预编译语句（优先从缓存获取）
+ * @param sql SQL语句
+ * @param stmt 输出语句句柄（已reset并清除绑定）
+ * @return 0成功, 1为多条语句（需走sqlite3_exec）, -1失败
+ */
+static int db_prepare_locked(const char *sql, sqlite3_stmt **stmt) {
+    unsigned int hash = db_hash_sql(sql);
+    int victim = 0;
+    
+    *stmt = NULL;
+    if (db_open_locked() != 0) {
+        return -1;
+    }
+    
+    for (int i = 0; i < DB_STMT_CACHE_SIZE; i++) {
+        DbStmtCacheEntry *e = &g_stmt_cache[i];
+        if (e->stmt && e->hash == hash && strcmp(e->sql, sql) == 0) {
+            e->last_used = ++g_stmt_clock;
+            sqlite3_reset(e->stmt);
+            sqlite3_clear_bindings(e->stmt);
+            *stmt = e->stmt;
+            return 0;
+        }
+        if (!e->stmt) {
+            victim = i;
+        } else if (g_stmt_cache[victim].stmt && e->last_used < g_stmt_cache[victim].last_used) {
+            victim = i;
+        }
+    }
+    
+    const char *tail = NULL;
+    sqlite3_stmt *new_stmt = NULL;
+    if (sqlite3_prepare_v2(g_db, sql, -1, &new_stmt, &tail) != SQLITE_OK) {
+        printf("[DB] SQL编译失败: %s (%.200s)\n", sqlite3_errmsg(g_db), sql);
+        return -1;
+    }
+    
+    /* 多条语句不进缓存 */
+    while (tail && (*tail == ' ' || *tail == '\t' || *tail == '\r' || *tail == '\n' || *tail == ';')) {
+        tail++;
+    }
+    if (!new_stmt || (tail && *tail)) {
+        sqlite3_finalize(new_stmt);
+        return 1;
+    }
+    
+    char *sql_copy = strdup(sql);
+    if (!sql_copy) {
+        sqlite3_finalize(new_stmt);
+        return -1;
+    }
+    
+    /* 淘汰最久未使用的缓存项 */
+    DbStmtCacheEntry *e = &g_stmt_cache[victim];
+    if (e->stmt) {
+        sqlite3_finalize(e->stmt);
+    }
+    free(e->sql);
+    e->sql = sql_copy;
+    e->hash = hash;
+    e->stmt = new_stmt;
+    e->last_used = ++g_stmt_clock;
+    
+    *stmt = new_stmt;
+    return 0;
+}
+
+/**
+ * 执行SQL（可包含多条语句）
+ */
+static int db_execute_locked(const char *sql) {
+    sqlite3_stmt *stmt = NULL;
+    int ret = db_prepare_locked(sql, &stmt);
+    
+    if (ret < 0) {
+        return -1;
+    }
+    
+    if (ret == 1) {
+        char *errmsg = NULL;
+        if (sqlite3_exec(g_db, sql, NULL, NULL, &errmsg) != SQLITE_OK) {
+            printf("[DB] SQL执行失败: %s (%.200s)\n", errmsg ? errmsg : "", sql);
+            sqlite3_free(errmsg);
+            return -1;
+        }
+        return 0;
+    }
+    
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        /* 丢弃结果行 */
+    }
+    sqlite3_reset(stmt);
+    
+    if (rc != SQLITE_DONE) {
+        printf("[DB] SQL执行失败: %s (%.200s)\n", sqlite3_errmsg(g_db), sql);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 查询并将结果格式化为文本（与sqlite3命令行输出格式一致）
+ * 列之间用separator分隔，行之间用换行分隔，NULL输出为空串
+ */
+static int db_query_text_locked(const char *sql, const char *separator, char *buf, size_t size) {
+    sqlite3_stmt *stmt = NULL;
+    size_t pos = 0;
+    int rc;
+    
+    buf[0] = '\0';
+    if (db_prepare_locked(sql, &stmt) != 0) {
+        return -1;
+    }
+    
+    size_t sep_len = strlen(separator);
+    int first_row = 1;
+    
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        int cols = sqlite3_column_count(stmt);
+        
+        if (!first_row && pos < size - 1) {
+            buf[pos++] = '\n';
+        }
+        first_row = 0;
+        
+        for (int i = 0; i < cols; i++) {
+            if (i > 0) {
+                size_t n = sep_len < size - 1 - pos ? sep_len : size - 1 - pos;
+                memcpy(buf + pos, separator, n);
+                pos += n;
+            }
+            const unsigned char *text = sqlite3_column_text(stmt, i);
+            if (text) {
+                size_t len = (size_t)sqlite3_column_bytes(stmt, i);
+                size_t n = len < size - 1 - pos ? len : size - 1 - pos;
+                memcpy(buf + pos, text, n);
+                pos += n;
+            }
+        }
+    }
+    buf[pos] = '\0';
+    sqlite3_reset(stmt);
+    
+    if (rc != SQLITE_DONE) {
+        printf("[DB] SQL查询失败: %s (%.200s)\n", sqlite3_errmsg(g_db), sql);
+        buf[0] = '\0';
+        return -1;
+    }
+    return 0;
+}
+
+/*============================================================================
+ * 表结构迁移
+ *
+ * 按版本号顺序登记的迁移步骤，当前版本记录在 PRAGMA user_version 中。
+ * db_init 时在一个事务内执行所有未执行的步骤，已是最新版本则不做任何操作。
+ * 新增表/字段/索引时追加新步骤，不要修改已发布的步骤。
+ *============================================================================*/
+
+/* 迁移步骤：sql 与 apply 二选一 */
+typedef struct {
+    int version;
+    const char *description;
+    const char *sql;
+    int (*apply)(void);
+} DbMigration;
+
+/**
+ * 检查表中是否存在指定字段
+ */
+static int db_column_exists_locked(const char *table, const char *column) {
+    char sql[128];
+    sqlite3_stmt *stmt = NULL;
+    int found = 0;
+    
+    snprintf(sql, sizeof(sql), "PRAGMA table_info(%s);", table);
+    if (sqlite3_prepare_v2(g_db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+        return 0;
+    }
+    while (!found && sqlite3_step(stmt) == SQLITE_ROW) {
+        const unsigned char *name = sqlite3_column_text(stmt, 1);
+        found = name && strcmp((const char *)name, column) == 0;
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+/**
+ * v2: 旧数据库的 sms_config 缺少 sms_fix_enabled 字段
+ */
+static int db_migrate_sms_fix_column(void) {
+    if (db_column_exists_locked("sms_config", "sms_fix_enabled")) {
+        return 0;
+    }
+    return sqlite3_exec(g_db,
+        "ALTER TABLE sms_config ADD COLUMN sms_fix_enabled INTEGER DEFAULT 0;",
+        NULL, NULL, NULL) == SQLITE_OK ? 0 : -1;
+}
+
+static const DbMigration g_migrations[] = {
+    { 1, "初始表结构",
         "CREATE TABLE IF NOT EXISTS sms ("
         "id INTEGER PRIMARY KEY AUTOINCREMENT,"
         "sender TEXT NOT NULL,"
@@ -53,8 +410,7 @@ static int db_create_tables(void) {
         "CREATE TABLE IF NOT EXISTS sms_config ("
         "id INTEGER PRIMARY KEY,"
         "max_count INTEGER DEFAULT 50,"
-        "max_sent_count INTEGER DEFAULT 10,"
-        "sms_fix_enabled INTEGER DEFAULT 0"
+        "max_sent_count INTEGER DEFAULT 10"
         ");"
         "CREATE TABLE IF NOT EXISTS config ("
         "key TEXT PRIMARY KEY,"
@@ -65,9 +421,383 @@ static int db_create_tables(void) {
         "token TEXT UNIQUE NOT NULL,"
         "expire_time INTEGER NOT NULL,"
         "created_at INTEGER NOT NULL"
-        ");";
+        ");"
+        "CREATE TABLE IF NOT EXISTS apn_templates ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "name TEXT NOT NULL,"
+        "apn TEXT NOT NULL,"
+        "protocol TEXT DEFAULT 'dual',"
+        "username TEXT,"
+        "password TEXT,"
+        "auth_method TEXT DEFAULT 'chap',"
+        "created_at INTEGER NOT NULL"
+        ");"
+        "CREATE TABLE IF NOT EXISTS apn_config ("
+        "id INTEGER PRIMARY KEY DEFAULT 1,"
+        "mode INTEGER DEFAULT 0,"
+        "template_id INTEGER,"
+        "auto_start INTEGER DEFAULT 0"
+        ");",
+        NULL },
+    { 2, "sms_config 增加 sms_fix_enabled 字段", NULL, db_migrate_sms_fix_column },
+    /* auth_tokens(token) 已有 UNIQUE 自动索引；sms.id 为 rowid，倒序扫描无需索引 */
+    { 3, "auth_tokens 过期/创建时间索引",
+        "CREATE INDEX IF NOT EXISTS idx_auth_tokens_expire ON auth_tokens(expire_time);"
+        "CREATE INDEX IF NOT EXISTS idx_auth_tokens_created ON auth_tokens(created_at);",
+        NULL },
+};
+
+#define DB_SCHEMA_VERSION \
+    (g_migrations[sizeof(g_migrations) / sizeof(g_migrations[0]) - 1].version)
+
+/**
+ * 执行所有未执行的迁移（单个事务）
+ */
+static int db_migrate(void) {
+    sqlite3_stmt *stmt = NULL;
+    int current = 0;
+    int ret = 0;
     
-    return db_execute(sql);
+    pthread_mutex_lock(&g_db_mutex);
+    if (db_open_locked() != 0) {
+        pthread_mutex_unlock(&g_db_mutex);
+        return -1;
+    }
+    
+    if (sqlite3_prepare_v2(g_db, "PRAGMA user_version;", -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            current = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+    
+    if (current >= DB_SCHEMA_VERSION) {
+        pthread_mutex_unlock(&g_db_mutex);
+        return 0;
+    }
+    
+    printf("[DB] 数据库版本 %d -> %d\n", current, DB_SCHEMA_VERSION);
+    
+    if (sqlite3_exec(g_db, "BEGIN IMMEDIATE;", NULL, NULL, NULL) != SQLITE_OK) {
+        printf("[DB] 迁移事务开始失败: %s\n", sqlite3_errmsg(g_db));
+        pthread_mutex_unlock(&g_db_mutex);
+        return -1;
+    }
+    
+    for (size_t i = 0; i < sizeof(g_migrations) / sizeof(g_migrations[0]); i++) {
+        const DbMigration *m = &g_migrations[i];
+        if (m->version <= current) {
+            continue;
+        }
+        
+        printf("[DB] 执行迁移 v%d: %s\n", m->version, m->description);
+        if (m->sql) {
+            char *errmsg = NULL;
+            if (sqlite3_exec(g_db, m->sql, NULL, NULL, &errmsg) != SQLITE_OK) {
+                printf("[DB] 迁移 v%d 失败: %s\n", m->version, errmsg ? errmsg : "");
+                sqlite3_free(errmsg);
+                ret = -1;
+            }
+        } else if (m->apply && m->apply() != 0) {
+            printf("[DB] 迁移 v%d 失败: %s\n", m->version, sqlite3_errmsg(g_db));
+            ret = -1;
+        }
+        if (ret != 0) {
+            break;
+        }
+    }
+    
+    if (ret == 0) {
+        char sql[64];
+        snprintf(sql, sizeof(sql), "PRAGMA user_version = %d;", DB_SCHEMA_VERSION);
+        if (sqlite3_exec(g_db, sql, NULL, NULL, NULL) != SQLITE_OK ||
+            sqlite3_exec(g_db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+            ret = -1;
+        }
+    }
+    if (ret != 0) {
+        sqlite3_exec(g_db, "ROLLBACK;", NULL, NULL, NULL);
+    }
+    
+    /* 表结构变化后缓存的语句需重新编译 */
+    db_stmt_cache_clear();
+    pthread_mutex_unlock(&g_db_mutex);
+    
+    return ret;
+}
+
+/*============================================================================
+ * 异步工作线程
+ *============================================================================*/
+
+/**
+ * 完成回调包装 - 在 GLib 默认主上下文中执行
+ */
+typedef struct {
+    db_done_func_t done;
+    void *arg;
+} DbAsyncDone;
+
+static gboolean db_async_done_idle(gpointer data) {
+    DbAsyncDone *d = (DbAsyncDone *)data;
+    d->done(d->arg);
+    g_free(d);
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * 执行一个任务并投递完成回调
+ */
+static void db_async_run(const DbAsyncTask *task) {
+    if (task->job) {
+        task->job(task->arg);
+    }
+    if (task->done) {
+        DbAsyncDone *d = g_new(DbAsyncDone, 1);
+        d->done = task->done;
+        d->arg = task->arg;
+        g_idle_add(db_async_done_idle, d);
+    }
+}
+
+static void *db_async_thread_func(void *arg) {
+    (void)arg;
+    
+    pthread_mutex_lock(&g_async_mutex);
+    while (1) {
+        while (g_async_running && g_async_count == 0) {
+            pthread_cond_wait(&g_async_cond, &g_async_mutex);
+        }
+        /* 退出前排空队列 */
+        if (g_async_count == 0) {
+            break;
+        }
+        
+        DbAsyncTask task = g_async_queue[g_async_head];
+        g_async_head = (g_async_head + 1) % DB_ASYNC_QUEUE_SIZE;
+        g_async_count--;
+        pthread_cond_broadcast(&g_async_space_cond);
+        pthread_mutex_unlock(&g_async_mutex);
+        
+        db_async_run(&task);
+        
+        pthread_mutex_lock(&g_async_mutex);
+    }
+    pthread_mutex_unlock(&g_async_mutex);
+    return NULL;
+}
+
+/**
+ * 启动异步工作线程（已启动则忽略）
+ */
+static void db_async_start(void) {
+    pthread_mutex_lock(&g_async_mutex);
+    if (!g_async_running) {
+        g_async_running = 1;
+        if (pthread_create(&g_async_thread, NULL, db_async_thread_func, NULL) != 0) {
+            printf("[DB] 创建异步工作线程失败\n");
+            g_async_running = 0;
+        }
+    }
+    pthread_mutex_unlock(&g_async_mutex);
+}
+
+/**
+ * 停止异步工作线程（等待已排队任务执行完）
+ */
+static void db_async_stop(void) {
+    pthread_mutex_lock(&g_async_mutex);
+    int running = g_async_running;
+    g_async_running = 0;
+    pthread_cond_signal(&g_async_cond);
+    pthread_mutex_unlock(&g_async_mutex);
+    
+    if (running) {
+        pthread_join(g_async_thread, NULL);
+    }
+}
+
+int db_async_submit(db_job_func_t job, db_done_func_t done, void *arg) {
+    if (!job && !done) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&g_async_mutex);
+    if (!g_async_running || g_async_count >= DB_ASYNC_QUEUE_SIZE) {
+        pthread_mutex_unlock(&g_async_mutex);
+        return -1;
+    }
+    
+    int tail = (g_async_head + g_async_count) % DB_ASYNC_QUEUE_SIZE;
+    g_async_queue[tail].job = job;
+    g_async_queue[tail].done = done;
+    g_async_queue[tail].arg = arg;
+    g_async_count++;
+    pthread_cond_signal(&g_async_cond);
+    pthread_mutex_unlock(&g_async_mutex);
+    
+    return 0;
+}
+
+void db_async_run_or_submit(db_job_func_t job, db_done_func_t done, void *arg) {
+    if (db_async_submit(job, done, arg) != 0) {
+        /* 队列已满或线程未启动：在当前线程同步执行 */
+        DbAsyncTask task = { job, done, arg };
+        db_async_run(&task);
+    }
+}
+
+void db_async_submit_ordered(db_job_func_t job, db_done_func_t done, void *arg) {
+    DbAsyncTask task = { job, done, arg };
+    
+    pthread_mutex_lock(&g_async_mutex);
+    /* 工作线程自身提交时等待会死锁，只能直接执行 */
+    if (g_async_running && pthread_equal(pthread_self(), g_async_thread)) {
+        pthread_mutex_unlock(&g_async_mutex);
+        db_async_run(&task);
+        return;
+    }
+    while (g_async_running && g_async_count >= DB_ASYNC_QUEUE_SIZE) {
+        pthread_cond_wait(&g_async_space_cond, &g_async_mutex);
+    }
+    if (g_async_running) {
+        int tail = (g_async_head + g_async_count) % DB_ASYNC_QUEUE_SIZE;
+        g_async_queue[tail] = task;
+        g_async_count++;
+        pthread_cond_signal(&g_async_cond);
+        pthread_mutex_unlock(&g_async_mutex);
+        return;
+    }
+    /* 工作线程已停止：等已排队任务执行完再同步执行 */
+    while (g_async_count > 0) {
+        pthread_cond_wait(&g_async_space_cond, &g_async_mutex);
+    }
+    pthread_mutex_unlock(&g_async_mutex);
+    db_async_run(&task);
+}
+
+/*============================================================================
+ * 热数据库（tmpfs）
+ *
+ * 开启 db_hot_mode 后，运行中的数据库位于 DB_HOT_DIR，写入不再落到闪存；
+ * 定时及正常退出时通过 SQLite 在线备份接口整库写回闪存文件。
+ * 备份在目标库的单个事务内完成，闪存副本始终是某一时刻的完整快照，
+ * 掉电最多丢失一个检查点间隔内的写入。
+ *
+ * 启动时若热数据库文件已存在（进程异常退出、未重启系统），说明它比闪存
+ * 副本更新，直接沿用；否则从闪存副本恢复。正常退出写回后删除热数据库。
+ *============================================================================*/
+
+/**
+ * 删除热数据库文件（含WAL/SHM）
+ */
+static void db_hot_remove_files(const char *path) {
+    char buf[280];
+    
+    unlink(path);
+    snprintf(buf, sizeof(buf), "%s-wal", path);
+    unlink(buf);
+    snprintf(buf, sizeof(buf), "%s-shm", path);
+    unlink(buf);
+}
+
+/**
+ * 整库备份 src -> dest_path（调用者持有 g_db_mutex）
+ * @param step_pages 每步复制的页数，-1 一步完成；大于0时步间释放 g_db_mutex，
+ *        期间经同一连接 src 的写入由 SQLite 自动同步到备份中
+ */
+static int db_backup_to_file_locked(sqlite3 *src, const char *dest_path, int step_pages) {
+    sqlite3 *dest = NULL;
+    int rc = sqlite3_open_v2(dest_path, &dest,
+        SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, NULL);
+    
+    if (rc == SQLITE_OK) {
+        sqlite3_busy_timeout(dest, DB_BUSY_TIMEOUT_MS);
+        sqlite3_exec(dest, "PRAGMA synchronous=FULL;", NULL, NULL, NULL);
+        
+        sqlite3_backup *backup = sqlite3_backup_init(dest, "main", src, "main");
+        if (backup) {
+            int step;
+            while ((step = sqlite3_backup_step(backup, step_pages)) == SQLITE_OK ||
+                   step == SQLITE_BUSY || step == SQLITE_LOCKED) {
+                pthread_mutex_unlock(&g_db_mutex);
+                sqlite3_sleep(DB_CHECKPOINT_STEP_SLEEP_MS);
+                pthread_mutex_lock(&g_db_mutex);
+            }
+            sqlite3_backup_finish(backup);
+        }
+        rc = sqlite3_errcode(dest);
+    }
+    
+    if (rc != SQLITE_OK) {
+        printf("[DB] 备份到 %s 失败: %s\n", dest_path,
+               dest ? sqlite3_errmsg(dest) : sqlite3_errstr(rc));
+    }
+    sqlite3_close(dest);
+    return rc == SQLITE_OK ? 0 : -1;
+}
+
+/**
+ * 切换到热数据库：必要时从闪存副本恢复，之后所有读写走tmpfs
+ */
+static int db_hot_enable(void) {
+    const char *name = strrchr(g_db_path, '/');
+    name = name ? name + 1 : g_db_path;
+    
+    pthread_mutex_lock(&g_db_mutex);
+    snprintf(g_db_hot_path, sizeof(g_db_hot_path), "%s/%s", DB_HOT_DIR, name);
+    
+    if (access(g_db_hot_path, F_OK) == 0) {
+        printf("[DB] 沿用未写回的热数据库: %s\n", g_db_hot_path);
+    } else if (db_open_locked() == 0 && db_backup_to_file_locked(g_db, g_db_hot_path, -1) == 0) {
+        printf("[DB] 已从闪存恢复热数据库: %s\n", g_db_hot_path);
+    } else {
+        db_hot_remove_files(g_db_hot_path);
+        g_db_hot_path[0] = '\0';
+        pthread_mutex_unlock(&g_db_mutex);
+        return -1;
+    }
+    
+    /* 切换连接，首个检查点总是执行 */
+    db_close_locked();
+    g_db_checkpoint_changes = -1;
+    int ret = db_open_locked();
+    pthread_mutex_unlock(&g_db_mutex);
+    
+    return ret;
+}
+
+static void db_checkpoint_job(void *arg) {
+    (void)arg;
+    db_checkpoint();
+}
+
+static gboolean db_checkpoint_timer(gpointer user_data) {
+    (void)user_data;
+    db_async_run_or_submit(db_checkpoint_job, NULL, NULL);
+    return G_SOURCE_CONTINUE;
+}
+
+int db_checkpoint(void) {
+    int ret = 0;
+    gint64 start = g_get_monotonic_time();
+    
+    pthread_mutex_lock(&g_db_mutex);
+    if (g_db_hot_path[0] && g_db) {
+        /* 自上次检查点以来无写入则跳过，避免无谓的闪存写 */
+        long long changes = (long long)sqlite3_total_changes(g_db);
+        if (changes != g_db_checkpoint_changes) {
+            ret = db_backup_to_file_locked(g_db, g_db_path, DB_CHECKPOINT_STEP_PAGES);
+            if (ret == 0) {
+                g_db_checkpoint_changes = changes;
+                printf("[DB] 检查点已写回闪存: %s\n", g_db_path);
+            }
+        }
+    }
+    pthread_mutex_unlock(&g_db_mutex);
+    
+    metrics_observe(METRIC_DB_QUERY_DURATION, "checkpoint", NULL, start);
+    return ret;
 }
 
 /*============================================================================
@@ -79,20 +809,55 @@ int db_init(const char *path) {
         return 0;
     }
     
-    if (path && strlen(path) > 0) {
+    pthread_mutex_lock(&g_db_mutex);
+    if (path && strlen(path) > 0 && strcmp(path, g_db_path) != 0) {
+        /* 路径变更：关闭可能已按默认路径懒打开的连接 */
+        db_close_locked();
         strncpy(g_db_path, path, sizeof(g_db_path) - 1);
         g_db_path[sizeof(g_db_path) - 1] = '\0';
     }
     
     printf("[DB] 初始化数据库: %s\n", g_db_path);
+    int ret = db_open_locked();
+    pthread_mutex_unlock(&g_db_mutex);
     
-    if (db_create_tables() != 0) {
-        printf("[DB] 创建表失败\n");
+    if (ret != 0) {
         return -1;
     }
     
-    /* 为旧数据库添加新字段（忽略错误，字段可能已存在） */
-    db_execute("ALTER TABLE sms_config ADD COLUMN sms_fix_enabled INTEGER DEFAULT 0;");
+    if (db_migrate() != 0) {
+        printf("[DB] 数据库迁移失败\n");
+        return -1;
+    }
+    
+    /* 加载配置缓存（路径可能已变更，总是重新加载） */
+    config_cache_load();
+    
+    /* 热数据库模式（修改后重启生效） */
+    char hot_mode[8] = "";
+    if (config_get("db_hot_mode", hot_mode, sizeof(hot_mode)) == 0 &&
+        strcmp(hot_mode, "1") == 0) {
+        if (db_hot_enable() == 0 && db_migrate() == 0) {
+            config_cache_load();
+        } else {
+            printf("[DB] 热数据库启用失败，继续使用闪存数据库\n");
+            pthread_mutex_lock(&g_db_mutex);
+            db_close_locked();
+            g_db_hot_path[0] = '\0';
+            pthread_mutex_unlock(&g_db_mutex);
+        }
+    }
+    
+    db_async_start();
+    
+    if (g_db_hot_path[0]) {
+        int interval = config_get_int("db_checkpoint_interval", DB_CHECKPOINT_INTERVAL_DEFAULT);
+        if (interval < DB_CHECKPOINT_INTERVAL_MIN) {
+            interval = DB_CHECKPOINT_INTERVAL_MIN;
+        }
+        g_db_checkpoint_source = g_timeout_add_seconds(interval, db_checkpoint_timer, NULL);
+        printf("[DB] 热数据库模式，检查点间隔 %d 秒\n", interval);
+    }
     
     g_db_initialized = 1;
     printf("[DB] 数据库初始化完成\n");
@@ -100,146 +865,222 @@ int db_init(const char *path) {
 }
 
 void db_deinit(void) {
+    if (g_db_checkpoint_source) {
+        g_source_remove(g_db_checkpoint_source);
+        g_db_checkpoint_source = 0;
+    }
+    db_async_stop();
+    
+    /* 热数据库最终写回，成功后删除tmpfs副本，下次启动从闪存恢复 */
+    int hot_saved = g_db_hot_path[0] && db_checkpoint() == 0;
+    config_cache_free();
+    
+    pthread_mutex_lock(&g_db_mutex);
+    db_close_locked();
+    if (hot_saved) {
+        db_hot_remove_files(g_db_hot_path);
+    }
+    g_db_hot_path[0] = '\0';
     g_db_initialized = 0;
+    pthread_mutex_unlock(&g_db_mutex);
     printf("[DB] 数据库模块已关闭\n");
 }
 
 const char *db_get_path(void) {
-    return g_db_path;
+    return db_live_path();
 }
 
 int db_execute(const char *sql) {
-    char output[1024];
-    int ret = -1;
-    
     if (!sql || strlen(sql) == 0) {
         return -1;
     }
     
-    /* 对于长SQL或包含特殊字符的SQL，使用临时文件 */
-    size_t sql_len = strlen(sql);
-    if (sql_len > 1000 || strchr(sql, '"') || strchr(sql, '\n')) {
-        const char *tmp_sql = "/tmp/db_sql.tmp";
-        FILE *fp = fopen(tmp_sql, "w");
-        if (!fp) {
-            printf("[DB] SQL执行失败: 无法创建临时文件\n");
-            return -1;
-        }
-        fputs(sql, fp);
-        fclose(fp);
-        
-        char cmd[512];
-        snprintf(cmd, sizeof(cmd), "sqlite3 '%s' < %s", g_db_path, tmp_sql);
-        ret = run_command(output, sizeof(output), "sh", "-c", cmd, NULL);
-        
-        unlink(tmp_sql);
-    } else {
-        char cmd[4096];
-        snprintf(cmd, sizeof(cmd), "sqlite3 '%s' \"%s\"", g_db_path, sql);
-        ret = run_command(output, sizeof(output), "sh", "-c", cmd, NULL);
-    }
+    gint64 start = g_get_monotonic_time();
+    pthread_mutex_lock(&g_db_mutex);
+    int ret = db_execute_locked(sql);
+    pthread_mutex_unlock(&g_db_mutex);
     
-    if (ret != 0) {
-        printf("[DB] SQL执行失败: %.200s...\n", sql);
-        return -1;
-    }
-    return 0;
+    metrics_observe(METRIC_DB_QUERY_DURATION, "execute", NULL, start);
+    return ret;
 }
 
 int db_execute_safe(const char *sql) {
-    pthread_mutex_lock(&g_db_mutex);
-    int ret = db_execute(sql);
-    pthread_mutex_unlock(&g_db_mutex);
-    return ret;
+    return db_execute(sql);
 }
 
 int db_query_int(const char *sql, int default_val) {
-    char cmd[1024];
-    char output[256] = {0};
+    sqlite3_stmt *stmt = NULL;
+    int result = default_val;
     
     if (!sql || strlen(sql) == 0) {
         return default_val;
     }
     
-    snprintf(cmd, sizeof(cmd), "sqlite3 '%s' \"%s\"", g_db_path, sql);
-    
+    gint64 start = g_get_monotonic_time();
     pthread_mutex_lock(&g_db_mutex);
-    int ret = run_command(output, sizeof(output), "sh", "-c", cmd, NULL);
-    pthread_mutex_unlock(&g_db_mutex);
-    
-    if (ret != 0 || strlen(output) == 0) {
-        return default_val;
-    }
-    
-    /* 去除换行符 */
-    size_t len = strlen(output);
-    if (len > 0 && output[len-1] == '\n') {
-        output[len-1] = '\0';
+    if (db_prepare_locked(sql, &stmt) == 0) {
+        if (sqlite3_step(stmt) == SQLITE_ROW &&
+            sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+            result = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_reset(stmt);
     }
+    pthread_mutex_unlock(&g_db_mutex);
     
-    return atoi(output);
+    metrics_observe(METRIC_DB_QUERY_DURATION, "query_int", NULL, start);
+    return result;
 }
 
 int db_query_string(const char *sql, char *buf, size_t size) {
-    char cmd[1024];
-    
     if (!sql || !buf || size == 0) {
         return -1;
     }
     
-    buf[0] = '\0';
-    snprintf(cmd, sizeof(cmd), "sqlite3 '%s' \"%s\"", g_db_path, sql);
-    
+    gint64 start = g_get_monotonic_time();
     pthread_mutex_lock(&g_db_mutex);
-    int ret = run_command(buf, size, "sh", "-c", cmd, NULL);
+    int ret = db_query_text_locked(sql, "|", buf, size);
     pthread_mutex_unlock(&g_db_mutex);
     
-    if (ret != 0) {
-        buf[0] = '\0';
+    metrics_observe(METRIC_DB_QUERY_DURATION, "query_string", NULL, start);
+    return ret;
+}
+
+int db_query_rows(const char *sql, const char *separator, char *buf, size_t size) {
+    if (!sql || !buf || size == 0) {
         return -1;
     }
     
-    /* 去除换行符 */
-    size_t len = strlen(buf);
-    if (len > 0 && buf[len-1] == '\n') {
-        buf[len-1] = '\0';
+    if (!separator || strlen(separator) == 0) {
+        separator = "|";
     }
     
-    return 0;
+    gint64 start = g_get_monotonic_time();
+    pthread_mutex_lock(&g_db_mutex);
+    int ret = db_query_text_locked(sql, separator, buf, size);
+    pthread_mutex_unlock(&g_db_mutex);
+    
+    metrics_observe(METRIC_DB_QUERY_DURATION, "query_rows", NULL, start);
+    return ret;
 }
 
-int db_query_rows(const char *sql, const char *separator, char *buf, size_t size) {
-    char cmd[2048];
+int db_query_each(const char *sql, const DbValue *args, db_row_callback_t callback, void *ctx) {
+    sqlite3_stmt *stmt = NULL;
+    DbValue cols[32];
+    int rows = 0;
+    int rc;
     
-    if (!sql || !buf || size == 0) {
+    if (!sql || strlen(sql) == 0) {
         return -1;
     }
     
-    buf[0] = '\0';
+    gint64 start = g_get_monotonic_time();
+    pthread_mutex_lock(&g_db_mutex);
+    if (db_prepare_locked(sql, &stmt) != 0) {
+        pthread_mutex_unlock(&g_db_mutex);
+        return -1;
+    }
     
-    if (separator && strlen(separator) > 0) {
-        snprintf(cmd, sizeof(cmd), "sqlite3 -separator '%s' '%s' \"%s\"", 
-                 separator, g_db_path, sql);
-    } else {
-        snprintf(cmd, sizeof(cmd), "sqlite3 '%s' \"%s\"", g_db_path, sql);
+    /* 绑定参数 */
+    for (int i = 0; args && args[i].type != DB_TYPE_END; i++) {
+        const DbValue *a = &args[i];
+        switch (a->type) {
+            case DB_TYPE_INT:
+                sqlite3_bind_int64(stmt, i + 1, a->i);
+                break;
+            case DB_TYPE_FLOAT:
+                sqlite3_bind_double(stmt, i + 1, a->f);
+                break;
+            case DB_TYPE_TEXT:
+                sqlite3_bind_text(stmt, i + 1, (const char *)a->data, a->len, SQLITE_STATIC);
+                break;
+            case DB_TYPE_BLOB:
+                sqlite3_bind_blob(stmt, i + 1, a->data, a->len, SQLITE_STATIC);
+                break;
+            default:
+                sqlite3_bind_null(stmt, i + 1);
+                break;
+        }
     }
     
-    pthread_mutex_lock(&g_db_mutex);
-    int ret = run_command(buf, size, "sh", "-c", cmd, NULL);
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        int ncols = sqlite3_column_count(stmt);
+        if (ncols > (int)(sizeof(cols) / sizeof(cols[0]))) {
+            ncols = (int)(sizeof(cols) / sizeof(cols[0]));
+        }
+        
+        for (int i = 0; i < ncols; i++) {
+            DbValue *v = &cols[i];
+            memset(v, 0, sizeof(DbValue));
+            switch (sqlite3_column_type(stmt, i)) {
+                case SQLITE_INTEGER:
+                    v->type = DB_TYPE_INT;
+                    v->i = sqlite3_column_int64(stmt, i);
+                    break;
+                case SQLITE_FLOAT:
+                    v->type = DB_TYPE_FLOAT;
+                    v->f = sqlite3_column_double(stmt, i);
+                    v->i = (long long)v->f;
+                    break;
+                case SQLITE_TEXT:
+                    v->type = DB_TYPE_TEXT;
+                    v->data = sqlite3_column_text(stmt, i);
+                    v->len = sqlite3_column_bytes(stmt, i);
+                    break;
+                case SQLITE_BLOB:
+                    v->type = DB_TYPE_BLOB;
+                    v->data = sqlite3_column_blob(stmt, i);
+                    v->len = sqlite3_column_bytes(stmt, i);
+                    break;
+                default:
+                    v->type = DB_TYPE_NULL;
+                    break;
+            }
+        }
+        
+        rows++;
+        if (callback && callback(cols, ncols, ctx) != 0) {
+            rc = SQLITE_DONE;
+            break;
+        }
+    }
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    
+    if (rc != SQLITE_DONE) {
+        printf("[DB] SQL查询失败: %s (%.200s)\n", sqlite3_errmsg(g_db), sql);
+        rows = -1;
+    }
     pthread_mutex_unlock(&g_db_mutex);
     
-    if (ret != 0) {
-        buf[0] = '\0';
-        return -1;
+    /* 含行回调的执行时间 */
+    metrics_observe(METRIC_DB_QUERY_DURATION, "query_each", NULL, start);
+    return rows;
+}
+
+void db_value_copy(const DbValue *v, char *buf, size_t size) {
+    if (!buf || size == 0) {
+        return;
     }
     
-    /* 去除末尾换行符 */
-    size_t len = strlen(buf);
-    if (len > 0 && buf[len-1] == '\n') {
-        buf[len-1] = '\0';
+    buf[0] = '\0';
+    if (!v) {
+        return;
     }
     
-    return 0;
+    if (v->type == DB_TYPE_TEXT || v->type == DB_TYPE_BLOB) {
+        size_t n = v->len > 0 ? (size_t)v->len : 0;
+        if (n > size - 1) {
+            n = size - 1;
+        }
+        if (n > 0) {
+            memcpy(buf, v->data, n);
+        }
+        buf[n] = '\0';
+    } else if (v->type == DB_TYPE_INT) {
+        snprintf(buf, size, "%lld", v->i);
+    } else if (v->type == DB_TYPE_FLOAT) {
+        snprintf(buf, size, "%g", v->f);
+    }
 }
 
 
@@ -307,48 +1148,285 @@ void db_unescape_string(char *str) {
  * 配置管理
  *============================================================================*/
 
+/**
+ * 配置缓存加载回调 - 列: key, value
+ */
+static int config_cache_row(const DbValue *cols, int ncols, void *ctx) {
+    GHashTable *table = (GHashTable *)ctx;
+    if (ncols < 2 || cols[0].type == DB_TYPE_NULL) return 0;
+    
+    g_hash_table_replace(table,
+        g_strndup((const char *)cols[0].data, cols[0].len),
+        cols[1].type == DB_TYPE_NULL ? g_strdup("") :
+            g_strndup((const char *)cols[1].data, cols[1].len));
+    return 0;
+}
+
+/**
+ * 从数据库加载整张 config 表到内存
+ */
+static int config_cache_load(void) {
+    GHashTable *table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    
+    if (db_query_each("SELECT key, value FROM config;", NULL, config_cache_row, table) < 0) {
+        g_hash_table_destroy(table);
+        return -1;
+    }
+    
+    pthread_rwlock_wrlock(&g_config_lock);
+    if (g_config_cache) {
+        g_hash_table_destroy(g_config_cache);
+    }
+    g_config_cache = table;
+    pthread_rwlock_unlock(&g_config_lock);
+    
+    printf("[DB] 配置缓存已加载: %u 项\n", g_hash_table_size(table));
+    return 0;
+}
+
+/**
+ * 确保配置缓存已加载（db_init之前的访问会懒加载）
+ */
+static int config_cache_ensure(void) {
+    pthread_rwlock_rdlock(&g_config_lock);
+    int loaded = g_config_cache != NULL;
+    pthread_rwlock_unlock(&g_config_lock);
+    
+    return loaded ? 0 : config_cache_load();
+}
+
+/**
+ * 释放配置缓存
+ */
+static void config_cache_free(void) {
+    pthread_rwlock_wrlock(&g_config_lock);
+    if (g_config_cache) {
+        g_hash_table_destroy(g_config_cache);
+        g_config_cache = NULL;
+    }
+    pthread_rwlock_unlock(&g_config_lock);
+}
+
+/**
+ * 通知配置变更（在锁外调用回调）
+ */
+static void config_notify(const char *key, const char *value) {
+    ConfigWatcher matched[CONFIG_MAX_WATCHERS];
+    int count = 0;
+    
+    pthread_rwlock_rdlock(&g_config_lock);
+    for (int i = 0; i < g_config_watcher_count; i++) {
+        const char *prefix = g_config_watchers[i].prefix;
+        if (strncmp(key, prefix, strlen(prefix)) == 0) {
+            matched[count++] = g_config_watchers[i];
+        }
+    }
+    pthread_rwlock_unlock(&g_config_lock);
+    
+    for (int i = 0; i < count; i++) {
+        matched[i].callback(key, value, matched[i].user_data);
+    }
+}
+
 int config_get(const char *key, char *value, size_t value_size) {
-    char cmd[512];
+    int ret = -1;
     
     if (!key || !value || value_size == 0) {
         return -1;
     }
     
     value[0] = '\0';
-    snprintf(cmd, sizeof(cmd), 
-        "sqlite3 '%s' \"SELECT value FROM config WHERE key='%s';\"", 
-        g_db_path, key);
+    if (config_cache_ensure() != 0) {
+        return -1;
+    }
+    
+    pthread_rwlock_rdlock(&g_config_lock);
+    const char *cached = g_config_cache ? g_hash_table_lookup(g_config_cache, key) : NULL;
+    if (cached && cached[0]) {
+        strncpy(value, cached, value_size - 1);
+        value[value_size - 1] = '\0';
+        ret = 0;
+    }
+    pthread_rwlock_unlock(&g_config_lock);
+    
+    return ret;
+}
+
+/**
+ * 执行一组排队的写请求：整组一个事务（一次提交/fsync），每个请求一个保存点，
+ * 单个请求失败只回滚自身
+ */
+static void config_commit_group(ConfigWriteReq *group) {
+    sqlite3_stmt *stmt = NULL;
+    int ok;
     
     pthread_mutex_lock(&g_db_mutex);
-    int ret = run_command(value, value_size, "sh", "-c", cmd, NULL);
+    ok = db_open_locked() == 0 &&
+         sqlite3_exec(g_db, "BEGIN IMMEDIATE;", NULL, NULL, NULL) == SQLITE_OK;
+    
+    for (ConfigWriteReq *r = group; r; r = r->next) {
+        r->result = -1;
+        if (!ok) continue;
+        
+        sqlite3_exec(g_db, "SAVEPOINT config_write;", NULL, NULL, NULL);
+        int failed = db_prepare_locked(
+            "INSERT OR REPLACE INTO config (key, value) VALUES (?1, ?2);", &stmt) != 0;
+        for (size_t i = 0; !failed && i < r->n; i++) {
+            sqlite3_bind_text(stmt, 1, r->kvs[i].key, -1, SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 2, r->kvs[i].value, -1, SQLITE_STATIC);
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                printf("[DB] 配置写入失败: %s (%s)\n", sqlite3_errmsg(g_db), r->kvs[i].key);
+                failed = 1;
+            }
+            sqlite3_reset(stmt);
+        }
+        
+        if (failed) {
+            sqlite3_exec(g_db, "ROLLBACK TO config_write;", NULL, NULL, NULL);
+        } else {
+            r->result = 0;
+        }
+        sqlite3_exec(g_db, "RELEASE config_write;", NULL, NULL, NULL);
+    }
+    
+    if (ok && sqlite3_exec(g_db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+        printf("[DB] 配置事务提交失败: %s\n", sqlite3_errmsg(g_db));
+        sqlite3_exec(g_db, "ROLLBACK;", NULL, NULL, NULL);
+        ok = 0;
+    }
     pthread_mutex_unlock(&g_db_mutex);
     
-    if (ret != 0 || strlen(value) == 0) {
-        value[0] = '\0';
+    /* 落盘成功后按提交顺序更新缓存，并记录实际变化的键 */
+    pthread_rwlock_wrlock(&g_config_lock);
+    for (ConfigWriteReq *r = group; r; r = r->next) {
+        if (!ok) r->result = -1;
+        if (r->result != 0) continue;
+        
+        for (size_t i = 0; i < r->n; i++) {
+            r->changed[i] = 1;
+            if (g_config_cache) {
+                const char *old = g_hash_table_lookup(g_config_cache, r->kvs[i].key);
+                r->changed[i] = !old || strcmp(old, r->kvs[i].value) != 0;
+                g_hash_table_replace(g_config_cache,
+                    g_strdup(r->kvs[i].key), g_strdup(r->kvs[i].value));
+            }
+        }
+    }
+    pthread_rwlock_unlock(&g_config_lock);
+}
+
+/**
+ * 提交写请求并等待完成（组提交）
+ * 第一个到达的写者成为leader：立即提交队列中的请求，提交期间到达的写请求
+ * 在下一轮合并为一个事务（此时确有并发写者，先等一个短窗口再收集），直到队列清空；
+ * 其余写者只需等待自己的请求完成。没有并发写者时（通常是事件循环线程）不等待
+ */
+static int config_write(const ConfigKV *kvs, size_t n, unsigned char *changed) {
+    ConfigWriteReq req = { kvs, n, changed, -1, 0, NULL };
+    
+    pthread_mutex_lock(&g_commit_mutex);
+    if (g_commit_tail) {
+        g_commit_tail->next = &req;
+    } else {
+        g_commit_head = &req;
+    }
+    g_commit_tail = &req;
+    
+    if (g_commit_leader) {
+        while (!req.done) {
+            pthread_cond_wait(&g_commit_cond, &g_commit_mutex);
+        }
+        pthread_mutex_unlock(&g_commit_mutex);
+        return req.result;
+    }
+    
+    g_commit_leader = 1;
+    for (int round = 0; g_commit_head; round++) {
+        if (round > 0) {
+            pthread_mutex_unlock(&g_commit_mutex);
+            usleep(CONFIG_GROUP_COMMIT_WINDOW_US);
+            pthread_mutex_lock(&g_commit_mutex);
+        }
+        
+        ConfigWriteReq *group = g_commit_head;
+        g_commit_head = g_commit_tail = NULL;
+        pthread_mutex_unlock(&g_commit_mutex);
+        
+        config_commit_group(group);
+        
+        pthread_mutex_lock(&g_commit_mutex);
+        while (group) {
+            ConfigWriteReq *next = group->next;
+            group->done = 1;  /* 置位后请求可能立即出栈，不可再访问 */
+            group = next;
+        }
+        pthread_cond_broadcast(&g_commit_cond);
+    }
+    g_commit_leader = 0;
+    pthread_mutex_unlock(&g_commit_mutex);
+    
+    return req.result;
+}
+
+int config_set_many(const ConfigKV *kvs, size_t n) {
+    if (!kvs || n == 0) {
         return -1;
     }
     
-    /* 去除换行符 */
-    size_t len = strlen(value);
-    if (len > 0 && value[len-1] == '\n') {
-        value[len-1] = '\0';
+    for (size_t i = 0; i < n; i++) {
+        if (!kvs[i].key || !kvs[i].value) {
+            return -1;
+        }
     }
     
-    return 0;
+    config_cache_ensure();
+    
+    unsigned char *changed = calloc(n, 1);
+    if (!changed) {
+        return -1;
+    }
+    
+    /* 含组提交的等待窗口 */
+    gint64 start = g_get_monotonic_time();
+    int ret = config_write(kvs, n, changed);
+    metrics_observe(METRIC_DB_QUERY_DURATION, "config_write", NULL, start);
+    
+    if (ret == 0) {
+        for (size_t i = 0; i < n; i++) {
+            if (changed[i]) {
+                config_notify(kvs[i].key, kvs[i].value);
+            }
+        }
+    }
+    
+    free(changed);
+    return ret;
 }
 
 int config_set(const char *key, const char *value) {
-    char sql[1024];
+    ConfigKV kv = { key, value };
+    return config_set_many(&kv, 1);
+}
+
+int config_watch(const char *prefix, config_change_callback_t callback, void *user_data) {
+    int ret = -1;
     
-    if (!key || !value) {
+    if (!callback) {
         return -1;
     }
     
-    snprintf(sql, sizeof(sql),
-        "INSERT OR REPLACE INTO config (key, value) VALUES ('%s', '%s');",
-        key, value);
+    pthread_rwlock_wrlock(&g_config_lock);
+    if (g_config_watcher_count < CONFIG_MAX_WATCHERS) {
+        ConfigWatcher *w = &g_config_watchers[g_config_watcher_count++];
+        strncpy(w->prefix, prefix ? prefix : "", sizeof(w->prefix) - 1);
+        w->prefix[sizeof(w->prefix) - 1] = '\0';
+        w->callback = callback;
+        w->user_data = user_data;
+        ret = 0;
+    }
+    pthread_rwlock_unlock(&g_config_lock);
     
-    return db_execute_safe(sql);
+    return ret;
 }
 
 int config_get_int(const char *key, int default_val) {
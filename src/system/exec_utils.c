@@ -10,7 +10,9 @@
 #include <unistd.h>
 #include <sys/wait.h>
 #include <signal.h>
+#include <glib.h>
 #include "exec_utils.h"
+#include "metrics.h"
 
 int run_command(char *output, size_t size, const char *cmd, ...) {
     va_list args;
@@ -27,6 +29,8 @@ int run_command(char *output, size_t size, const char *cmd, ...) {
     va_end(args);
     argv[argc] = NULL;
 
+    gint64 start = g_get_monotonic_time();
+
     /* 创建管道 */
     int pipefd[2];
     if (pipe(pipefd) == -1) return -1;
@@ -69,7 +73,12 @@ int run_command(char *output, size_t size, const char *cmd, ...) {
         output[--total] = '\0';
     }
 
-    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+    int ret = WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+
+    /* 按可执行文件名统计 */
+    const char *exe = strrchr(cmd, '/');
+    metrics_observe(METRIC_COMMAND_DURATION, exe ? exe + 1 : cmd, ret == 0 ? "ok" : "error", start);
+    return ret;
 }
 
 int run_command_timeout(int timeout_sec, char *output, size_t size, const char *cmd, ...) {
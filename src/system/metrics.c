@@ -0,0 +1,455 @@
+/**
+ * @file metrics.c
+ * @brief 运行指标实现
+ *
+ * 序列表只追加：新序列在互斥锁内填好后才以 release 写入索引，
+ * 读者用 acquire 读取索引，因此查找不需要加锁。
+ * 每个分片是 [序列][槽] 的计数数组，只由持有它的线程写（relaxed 原子加），
+ * 采集线程读取时与写入并发，各计数单独看都是一致的。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <glib.h>
+#include "metrics.h"
+
+/* 每个序列在分片中的槽：各桶计数（最后一个为 +Inf）+ 耗时总和（微秒）；计数器只用第0个 */
+#define METRICS_SLOT_SIZE   (METRICS_HISTOGRAM_BUCKETS + 2)
+#define METRICS_SLOT_SUM    (METRICS_HISTOGRAM_BUCKETS + 1)
+
+/* 序列索引（开放寻址，容量为2的幂且大于序列上限） */
+#define METRICS_INDEX_SIZE  512
+
+/* 最小桶上界 2^7 微秒 */
+#define METRICS_BUCKET_SHIFT 7
+
+typedef enum {
+    METRIC_TYPE_COUNTER,
+    METRIC_TYPE_GAUGE,
+    METRIC_TYPE_HISTOGRAM,
+} MetricType;
+
+typedef struct {
+    const char *name;
+    MetricType type;
+    const char *help;
+    const char *labels[2];
+    const char *span;           /* 请求耗时分解中的名称，NULL不计入 */
+} MetricFamilyDef;
+
+static const MetricFamilyDef g_families[METRIC_FAMILY_COUNT] = {
+    [METRIC_HTTP_REQUEST_DURATION] = {
+        "ofono_http_request_duration_seconds", METRIC_TYPE_HISTOGRAM,
+        "HTTP request handling time by route pattern and status", { "route", "status" } },
+    [METRIC_HTTP_CACHE_HITS] = {
+        "ofono_http_cache_hits_total", METRIC_TYPE_COUNTER,
+        "GET responses served from the response cache", { "route" } },
+    [METRIC_HTTP_CONNECTIONS] = {
+        "ofono_http_connections", METRIC_TYPE_GAUGE,
+        "Open HTTP client connections" },
+    [METRIC_HTTP_WORKER_QUEUE] = {
+        "ofono_http_worker_queue_depth", METRIC_TYPE_GAUGE,
+        "Blocking requests waiting for a worker thread" },
+    [METRIC_HTTP_WORKER_REJECTED] = {
+        "ofono_http_worker_rejected_total", METRIC_TYPE_COUNTER,
+        "Blocking requests rejected with 503 because the worker queue was full" },
+    [METRIC_AT_COMMAND_DURATION] = {
+        "ofono_at_command_duration_seconds", METRIC_TYPE_HISTOGRAM,
+        "AT command time including serialization wait, by command prefix", { "command", "result" }, "at" },
+    [METRIC_DBUS_CALL_DURATION] = {
+        "ofono_dbus_call_duration_seconds", METRIC_TYPE_HISTOGRAM,
+        "Synchronous oFono D-Bus call time by interface.method", { "method", "result" }, "dbus" },
+    [METRIC_COMMAND_DURATION] = {
+        "ofono_command_duration_seconds", METRIC_TYPE_HISTOGRAM,
+        "External command run time by executable", { "exe", "result" }, "exec" },
+    [METRIC_DB_QUERY_DURATION] = {
+        "ofono_db_query_duration_seconds", METRIC_TYPE_HISTOGRAM,
+        "Database call time including lock wait, by operation", { "op" }, "db" },
+};
+
+/* 序列：指标族 + 标签值 */
+typedef struct {
+    MetricFamily family;
+    char labels[2][METRICS_LABEL_MAX];
+} MetricSeries;
+
+/* 分片：in_use 表示已被某个存活线程持有 */
+typedef struct {
+    int in_use;
+    guint64 *values;                /* [METRICS_MAX_SERIES][METRICS_SLOT_SIZE]，首次使用时分配 */
+} MetricsShard;
+
+static MetricSeries g_series[METRICS_MAX_SERIES];
+static int g_series_count = 0;
+static int g_series_index[METRICS_INDEX_SIZE];     /* 序列下标+1，0为空 */
+static pthread_mutex_t g_series_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* 最后一个是溢出分片，由领取不到分片的线程共用 */
+static MetricsShard g_shards[METRICS_MAX_SHARDS + 1];
+static gint64 g_gauges[METRIC_FAMILY_COUNT];
+
+/* 请求耗时分解：同名同描述的区间合并 */
+typedef struct {
+    const char *name;
+    char desc[METRICS_LABEL_MAX];
+    gint64 us;
+    int count;
+} MetricsSpan;
+
+typedef struct {
+    int count;
+    MetricsSpan spans[METRICS_TRACE_MAX_SPANS];
+} MetricsTrace;
+
+static __thread MetricsShard *t_shard = NULL;
+static __thread MetricsTrace *t_trace = NULL;
+static pthread_key_t g_shard_key;
+static pthread_once_t g_shard_once = PTHREAD_ONCE_INIT;
+
+/*============================================================================
+ * 分片
+ *============================================================================*/
+
+/* 线程退出：归还分片，计数保留给下一个持有者继续累加 */
+static void metrics_shard_release(void *arg) {
+    MetricsShard *shard = (MetricsShard *)arg;
+    __atomic_store_n(&shard->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static void metrics_shard_key_init(void) {
+    pthread_key_create(&g_shard_key, metrics_shard_release);
+}
+
+static guint64 *metrics_shard_values(MetricsShard *shard) {
+    guint64 *values = __atomic_load_n(&shard->values, __ATOMIC_ACQUIRE);
+    if (values) {
+        return values;
+    }
+
+    /* 溢出分片可能被多个线程同时初始化，只保留先发布的一份 */
+    guint64 *fresh = g_new0(guint64, (gsize)METRICS_MAX_SERIES * METRICS_SLOT_SIZE);
+    if (__atomic_compare_exchange_n(&shard->values, &values, fresh, FALSE,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return fresh;
+    }
+    g_free(fresh);
+    return values;
+}
+
+static guint64 *metrics_thread_values(void) {
+    if (t_shard) {
+        return metrics_shard_values(t_shard);
+    }
+
+    pthread_once(&g_shard_once, metrics_shard_key_init);
+    for (int i = 0; i < METRICS_MAX_SHARDS; i++) {
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&g_shards[i].in_use, &expected, 1, FALSE,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            t_shard = &g_shards[i];
+            pthread_setspecific(g_shard_key, t_shard);
+            return metrics_shard_values(t_shard);
+        }
+    }
+
+    t_shard = &g_shards[METRICS_MAX_SHARDS];
+    return metrics_shard_values(t_shard);
+}
+
+/*============================================================================
+ * 序列登记
+ *============================================================================*/
+
+static guint metrics_series_hash(MetricFamily family, const char *l1, const char *l2) {
+    guint h = 2166136261u ^ (guint)family;
+    for (const char *p = l1; *p; p++) h = (h ^ (guchar)*p) * 16777619u;
+    h = (h ^ 0xff) * 16777619u;
+    for (const char *p = l2; *p; p++) h = (h ^ (guchar)*p) * 16777619u;
+    return h;
+}
+
+static int metrics_series_find(MetricFamily family, const char *l1, const char *l2, guint hash) {
+    for (guint i = 0; i < METRICS_INDEX_SIZE; i++) {
+        guint pos = (hash + i) & (METRICS_INDEX_SIZE - 1);
+        int v = __atomic_load_n(&g_series_index[pos], __ATOMIC_ACQUIRE);
+        if (v == 0) {
+            return -(int)pos - 1;       /* 未找到，返回可插入位置 */
+        }
+        const MetricSeries *s = &g_series[v - 1];
+        if (s->family == family && strcmp(s->labels[0], l1) == 0 && strcmp(s->labels[1], l2) == 0) {
+            return v - 1;
+        }
+    }
+    return -(int)METRICS_INDEX_SIZE - 1;
+}
+
+/**
+ * 查找或登记序列
+ * @return 序列下标，序列表已满返回-1
+ */
+static int metrics_series_get(MetricFamily family, const char *v1, const char *v2) {
+    char l1[METRICS_LABEL_MAX], l2[METRICS_LABEL_MAX];
+    const MetricFamilyDef *def = &g_families[family];
+
+    /* 未声明的标签忽略，标签值截断后再比较 */
+    g_strlcpy(l1, def->labels[0] && v1 ? v1 : "", sizeof(l1));
+    g_strlcpy(l2, def->labels[1] && v2 ? v2 : "", sizeof(l2));
+
+    guint hash = metrics_series_hash(family, l1, l2);
+    int idx = metrics_series_find(family, l1, l2, hash);
+    if (idx >= 0) {
+        return idx;
+    }
+
+    pthread_mutex_lock(&g_series_mutex);
+    idx = metrics_series_find(family, l1, l2, hash);
+    if (idx < 0) {
+        int pos = -idx - 1;
+        if (g_series_count < METRICS_MAX_SERIES && pos < METRICS_INDEX_SIZE) {
+            MetricSeries *s = &g_series[g_series_count];
+            s->family = family;
+            memcpy(s->labels[0], l1, sizeof(l1));
+            memcpy(s->labels[1], l2, sizeof(l2));
+            idx = g_series_count;
+            __atomic_store_n(&g_series_index[pos], idx + 1, __ATOMIC_RELEASE);
+            __atomic_store_n(&g_series_count, idx + 1, __ATOMIC_RELEASE);
+        } else {
+            idx = -1;
+        }
+    }
+    pthread_mutex_unlock(&g_series_mutex);
+
+    return idx;
+}
+
+/* 耗时所在的桶：上界 >= 耗时的最小桶，超出最大上界归入 +Inf */
+static int metrics_bucket(gint64 us) {
+    if (us <= (1 << METRICS_BUCKET_SHIFT)) {
+        return 0;
+    }
+    int bits = 64 - __builtin_clzll((unsigned long long)(us - 1));
+    int bucket = bits - METRICS_BUCKET_SHIFT;
+    return bucket < METRICS_HISTOGRAM_BUCKETS ? bucket : METRICS_HISTOGRAM_BUCKETS;
+}
+
+/* 记入当前线程的请求耗时分解（未开启时为空操作） */
+static void metrics_trace_add(const char *name, const char *desc, gint64 us) {
+    MetricsTrace *trace = t_trace;
+    MetricsSpan *span = NULL;
+
+    if (!trace) {
+        return;
+    }
+    if (!desc) {
+        desc = "";
+    }
+
+    for (int i = 0; i < trace->count && !span; i++) {
+        if (strcmp(trace->spans[i].name, name) == 0 && strcmp(trace->spans[i].desc, desc) == 0) {
+            span = &trace->spans[i];
+        }
+    }
+    if (!span) {
+        if (trace->count >= METRICS_TRACE_MAX_SPANS) {
+            return;
+        }
+        span = &trace->spans[trace->count++];
+        span->name = name;
+        g_strlcpy(span->desc, desc, sizeof(span->desc));
+    }
+    span->us += us;
+    span->count++;
+}
+
+/*============================================================================
+ * 公共接口
+ *============================================================================*/
+
+void metrics_observe(MetricFamily family, const char *l1, const char *l2, gint64 start_us) {
+    gint64 us = g_get_monotonic_time() - start_us;
+    if (us < 0) {
+        us = 0;
+    }
+    if (g_families[family].span) {
+        metrics_trace_add(g_families[family].span, l1, us);
+    }
+
+    int idx = metrics_series_get(family, l1, l2);
+    if (idx < 0) {
+        return;
+    }
+
+    guint64 *slot = metrics_thread_values() + (gsize)idx * METRICS_SLOT_SIZE;
+    __atomic_fetch_add(&slot[metrics_bucket(us)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&slot[METRICS_SLOT_SUM], (guint64)us, __ATOMIC_RELAXED);
+}
+
+void metrics_inc(MetricFamily family, const char *l1, const char *l2) {
+    int idx = metrics_series_get(family, l1, l2);
+    if (idx < 0) {
+        return;
+    }
+
+    guint64 *slot = metrics_thread_values() + (gsize)idx * METRICS_SLOT_SIZE;
+    __atomic_fetch_add(&slot[0], 1, __ATOMIC_RELAXED);
+}
+
+void metrics_gauge_add(MetricFamily family, gint64 delta) {
+    __atomic_fetch_add(&g_gauges[family], delta, __ATOMIC_RELAXED);
+}
+
+void metrics_gauge_set(MetricFamily family, gint64 value) {
+    __atomic_store_n(&g_gauges[family], value, __ATOMIC_RELAXED);
+}
+
+void metrics_trace_begin(void) {
+    if (!t_trace) {
+        t_trace = g_new0(MetricsTrace, 1);
+    }
+}
+
+void metrics_span(const char *name, const char *desc, gint64 start_us) {
+    if (t_trace) {
+        metrics_trace_add(name, desc, MAX(g_get_monotonic_time() - start_us, 0));
+    }
+}
+
+void metrics_trace_end(GString *out) {
+    MetricsTrace *trace = t_trace;
+
+    if (!trace) {
+        return;
+    }
+    t_trace = NULL;
+
+    for (int i = 0; out && i < trace->count; i++) {
+        const MetricsSpan *span = &trace->spans[i];
+        g_string_append_printf(out, "%s%s", out->len ? ", " : "", span->name);
+        if (span->desc[0]) {
+            /* 描述放在引号内，去掉引号和反斜杠 */
+            g_string_append(out, ";desc=\"");
+            for (const char *p = span->desc; *p; p++) {
+                if (*p != '"' && *p != '\\' && (guchar)*p >= 0x20) g_string_append_c(out, *p);
+            }
+            if (span->count > 1) g_string_append_printf(out, " x%d", span->count);
+            g_string_append_c(out, '"');
+        } else if (span->count > 1) {
+            g_string_append_printf(out, ";desc=\"x%d\"", span->count);
+        }
+        g_string_append_printf(out, ";dur=%.2f", (double)span->us / 1000.0);
+    }
+    g_free(trace);
+}
+
+/*============================================================================
+ * 文本暴露格式
+ *============================================================================*/
+
+/* 输出 {a="x",b="y"，不含右括号；extra 为追加的标签（如 le） */
+static void metrics_render_labels(GString *out, const MetricFamilyDef *def,
+                                  const MetricSeries *s, const char *extra) {
+    int n = 0;
+
+    for (int i = 0; i < 2; i++) {
+        if (!def->labels[i]) continue;
+        g_string_append_printf(out, "%s%s=\"", n++ ? "," : "{", def->labels[i]);
+        for (const char *p = s->labels[i]; *p; p++) {
+            if (*p == '\\' || *p == '"') g_string_append_c(out, '\\');
+            if (*p == '\n') {
+                g_string_append(out, "\\n");
+            } else {
+                g_string_append_c(out, *p);
+            }
+        }
+        g_string_append_c(out, '"');
+    }
+    if (extra) {
+        g_string_append_printf(out, "%s%s", n++ ? "," : "{", extra);
+    }
+    if (n) {
+        g_string_append_c(out, '}');
+    }
+}
+
+/* 把所有分片中某个序列的槽相加 */
+static void metrics_series_sum(int idx, guint64 *sum) {
+    memset(sum, 0, sizeof(guint64) * METRICS_SLOT_SIZE);
+    for (int i = 0; i <= METRICS_MAX_SHARDS; i++) {
+        guint64 *values = __atomic_load_n(&g_shards[i].values, __ATOMIC_ACQUIRE);
+        if (!values) continue;
+        guint64 *slot = values + (gsize)idx * METRICS_SLOT_SIZE;
+        for (int j = 0; j < METRICS_SLOT_SIZE; j++) {
+            sum[j] += __atomic_load_n(&slot[j], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static void metrics_render_histogram(GString *out, const MetricFamilyDef *def,
+                                     const MetricSeries *s, const guint64 *sum) {
+    guint64 cumulative = 0;
+    char le[32];
+
+    for (int b = 0; b <= METRICS_HISTOGRAM_BUCKETS; b++) {
+        cumulative += sum[b];
+        if (b < METRICS_HISTOGRAM_BUCKETS) {
+            snprintf(le, sizeof(le), "le=\"%.6f\"",
+                     (double)(1ULL << (b + METRICS_BUCKET_SHIFT)) / 1e6);
+        } else {
+            snprintf(le, sizeof(le), "le=\"+Inf\"");
+        }
+        g_string_append_printf(out, "%s_bucket", def->name);
+        metrics_render_labels(out, def, s, le);
+        g_string_append_printf(out, " %" G_GUINT64_FORMAT "\n", cumulative);
+    }
+
+    g_string_append_printf(out, "%s_sum", def->name);
+    metrics_render_labels(out, def, s, NULL);
+    g_string_append_printf(out, " %.6f\n", (double)sum[METRICS_SLOT_SUM] / 1e6);
+
+    g_string_append_printf(out, "%s_count", def->name);
+    metrics_render_labels(out, def, s, NULL);
+    g_string_append_printf(out, " %" G_GUINT64_FORMAT "\n", cumulative);
+}
+
+void metrics_render(GString *out) {
+    static const char *type_names[] = { "counter", "gauge", "histogram" };
+    guint64 sum[METRICS_SLOT_SIZE];
+    int count = __atomic_load_n(&g_series_count, __ATOMIC_ACQUIRE);
+
+    for (int f = 0; f < METRIC_FAMILY_COUNT; f++) {
+        const MetricFamilyDef *def = &g_families[f];
+        int found = 0;
+
+        g_string_append_printf(out, "# HELP %s %s\n# TYPE %s %s\n",
+                               def->name, def->help, def->name, type_names[def->type]);
+
+        if (def->type == METRIC_TYPE_GAUGE) {
+            g_string_append_printf(out, "%s %" G_GINT64_FORMAT "\n", def->name,
+                                   __atomic_load_n(&g_gauges[f], __ATOMIC_RELAXED));
+            continue;
+        }
+
+        for (int i = 0; i < count; i++) {
+            const MetricSeries *s = &g_series[i];
+            if (s->family != (MetricFamily)f) continue;
+
+            found = 1;
+            metrics_series_sum(i, sum);
+            if (def->type == METRIC_TYPE_HISTOGRAM) {
+                metrics_render_histogram(out, def, s, sum);
+            } else {
+                g_string_append(out, def->name);
+                metrics_render_labels(out, def, s, NULL);
+                g_string_append_printf(out, " %" G_GUINT64_FORMAT "\n", sum[0]);
+            }
+        }
+
+        /* 无标签计数器尚未记录时也输出0，便于告警规则引用 */
+        if (!found && def->type == METRIC_TYPE_COUNTER && !def->labels[0]) {
+            g_string_append_printf(out, "%s 0\n", def->name);
+        }
+    }
+}
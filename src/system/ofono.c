@@ -17,6 +17,7 @@
 #include "ofono.h"
 #include "dbus_core.h"
 #include "sysinfo.h"
+#include "metrics.h"
 
 /* ==================== 常量定义 ==================== */
 #define OFONO_MODEM_IFACE   "org.ofono.Modem"
@@ -80,6 +81,67 @@ static int validate_at_command(const char *cmd) {
     return 0;
 }
 
+/* 统计标签 "接口.方法"，省略 org.ofono. 前缀 */
+static void dbus_metric_label(const char *iface, const char *method, char *buf, size_t size) {
+    if (iface && g_str_has_prefix(iface, "org.ofono.")) {
+        iface += strlen("org.ofono.");
+    }
+    snprintf(buf, size, "%s.%s", iface ? iface : "", method);
+}
+
+/* g_dbus_proxy_call_sync，记录调用耗时 */
+static GVariant *dbus_proxy_call_timed(GDBusProxy *proxy, const gchar *method, GVariant *parameters,
+                                       GDBusCallFlags flags, gint timeout_ms,
+                                       GCancellable *cancellable, GError **error) {
+    char label[METRICS_LABEL_MAX];
+    gint64 start = g_get_monotonic_time();
+
+    GVariant *ret = g_dbus_proxy_call_sync(proxy, method, parameters, flags,
+                                           timeout_ms, cancellable, error);
+
+    dbus_metric_label(g_dbus_proxy_get_interface_name(proxy), method, label, sizeof(label));
+    metrics_observe(METRIC_DBUS_CALL_DURATION, label, ret ? "ok" : "error", start);
+    return ret;
+}
+
+/* g_dbus_connection_call_sync，记录调用耗时 */
+static GVariant *dbus_connection_call_timed(GDBusConnection *conn, const gchar *bus_name,
+                                            const gchar *object_path, const gchar *iface,
+                                            const gchar *method, GVariant *parameters,
+                                            const GVariantType *reply_type, GDBusCallFlags flags,
+                                            gint timeout_ms, GCancellable *cancellable,
+                                            GError **error) {
+    char label[METRICS_LABEL_MAX];
+    gint64 start = g_get_monotonic_time();
+
+    GVariant *ret = g_dbus_connection_call_sync(conn, bus_name, object_path, iface, method,
+                                                parameters, reply_type, flags,
+                                                timeout_ms, cancellable, error);
+
+    dbus_metric_label(iface, method, label, sizeof(label));
+    metrics_observe(METRIC_DBUS_CALL_DURATION, label, ret ? "ok" : "error", start);
+    return ret;
+}
+
+/**
+ * AT 命令的统计标签：命令名加 '=' 或 '?'，不含参数，统一大写
+ * 如 AT+CFUN=1 -> AT+CFUN=，AT+CSQ -> AT+CSQ
+ */
+static void at_metric_label(const char *command, char *buf, size_t size) {
+    size_t n = 0;
+
+    while (command[n] && n + 2 < size &&
+           (g_ascii_isalnum(command[n]) || strchr("+^$&#%*", command[n]))) {
+        buf[n] = g_ascii_toupper(command[n]);
+        n++;
+    }
+    if (command[n] == '=' || command[n] == '?') {
+        buf[n] = command[n];
+        n++;
+    }
+    buf[n] = '\0';
+}
+
 /* ==================== dbus_core.h 接口实现 ==================== */
 
 const char *dbus_get_last_error(void) {
@@ -180,6 +242,9 @@ int execute_at(const char *command, char **result) {
         }
     }
 
+    /* 耗时含等待互斥锁和重试 */
+    gint64 start = g_get_monotonic_time();
+
     /* 获取互斥锁，确保串行执行 */
     pthread_mutex_lock(&g_at_mutex);
 
@@ -190,7 +255,7 @@ int execute_at(const char *command, char **result) {
         error = NULL;
 
         /* 调用 oFono 的 SendAtcmd 方法 */
-        ret = g_dbus_proxy_call_sync(
+        ret = dbus_proxy_call_timed(
             g_modem_proxy,
             "SendAtcmd",
             g_variant_new("(s)", command),
@@ -248,6 +313,138 @@ int execute_at(const char *command, char **result) {
     }
 
     pthread_mutex_unlock(&g_at_mutex);
+
+    char label[32];
+    at_metric_label(command, label, sizeof(label));
+    metrics_observe(METRIC_AT_COMMAND_DURATION, label, rc == 0 ? "ok" : "error", start);
+    return rc;
+}
+
+/* ==================== 查询作用域 ==================== */
+
+/* 当前线程作用域内记住的查询结果：命令 -> 结果 */
+static __thread GHashTable *t_scope_results = NULL;
+static __thread int t_scope_depth = 0;
+
+/* ofono_get_datacard 在作用域中的键（不会与AT命令冲突） */
+#define SCOPE_KEY_DATACARD "#datacard"
+
+void modem_query_scope_begin(void) {
+    if (t_scope_depth++ == 0) {
+        t_scope_results = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    }
+}
+
+void modem_query_scope_end(void) {
+    if (t_scope_depth > 0 && --t_scope_depth == 0) {
+        g_hash_table_destroy(t_scope_results);
+        t_scope_results = NULL;
+    }
+}
+
+/* 作用域内已有结果时返回其副本 */
+static char *scope_lookup(const char *key) {
+    const char *value = t_scope_results ? g_hash_table_lookup(t_scope_results, key) : NULL;
+    return value ? g_strdup(value) : NULL;
+}
+
+static void scope_store(const char *key, const char *value) {
+    if (t_scope_results && value) {
+        g_hash_table_replace(t_scope_results, g_strdup(key), g_strdup(value));
+    }
+}
+
+/* ==================== 只读查询合并 ==================== */
+
+/* 执行中的查询 */
+typedef struct AtFlight {
+    char *command;
+    int done;
+    int rc;
+    char *result;
+    int refs;                   /* 执行者 + 等待者 */
+    struct AtFlight *next;
+} AtFlight;
+
+static pthread_mutex_t g_flight_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_flight_cond = PTHREAD_COND_INITIALIZER;
+static AtFlight *g_flights = NULL;
+
+/* 释放一个引用，最后一个引用负责释放（需持有 g_flight_mutex） */
+static void at_flight_release(AtFlight *f) {
+    if (--f->refs > 0) {
+        return;
+    }
+    g_free(f->command);
+    g_free(f->result);
+    g_free(f);
+}
+
+int execute_at_query(const char *command, char **result) {
+    AtFlight *f;
+    int rc;
+
+    if (!command || !result) {
+        set_error("无效的参数");
+        return -1;
+    }
+    *result = scope_lookup(command);
+    if (*result) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&g_flight_mutex);
+    for (f = g_flights; f != NULL; f = f->next) {
+        if (strcmp(f->command, command) == 0) {
+            break;
+        }
+    }
+
+    if (f) {
+        /* 已有相同查询在执行，等待其结果 */
+        f->refs++;
+        printf("合并 AT 查询: %s\n", command);
+        while (!f->done) {
+            pthread_cond_wait(&g_flight_cond, &g_flight_mutex);
+        }
+        rc = f->rc;
+        if (rc == 0 && f->result) {
+            *result = g_strdup(f->result);
+        }
+        at_flight_release(f);
+        pthread_mutex_unlock(&g_flight_mutex);
+        scope_store(command, *result);
+        return rc;
+    }
+
+    f = g_new0(AtFlight, 1);
+    f->command = g_strdup(command);
+    f->refs = 1;
+    f->next = g_flights;
+    g_flights = f;
+    pthread_mutex_unlock(&g_flight_mutex);
+
+    char *res = NULL;
+    rc = execute_at(command, &res);
+
+    pthread_mutex_lock(&g_flight_mutex);
+    for (AtFlight **pp = &g_flights; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == f) {
+            *pp = f->next;
+            break;
+        }
+    }
+    f->done = 1;
+    f->rc = rc;
+    f->result = res;
+    if (rc == 0 && res) {
+        *result = g_strdup(res);    /* 调用者可能就地修改结果，各自持有副本 */
+    }
+    pthread_cond_broadcast(&g_flight_cond);
+    at_flight_release(f);
+    pthread_mutex_unlock(&g_flight_mutex);
+
+    scope_store(command, *result);
     return rc;
 }
 
@@ -293,7 +490,7 @@ int ofono_network_get_mode_sync(const char* modem_path, char* buffer, int size,
         return -1;
     }
 
-    result = g_dbus_proxy_call_sync(
+    result = dbus_proxy_call_timed(
         proxy, "GetProperties", NULL,
         G_DBUS_CALL_FLAGS_NONE, timeout_ms, NULL, &error
     );
@@ -341,7 +538,12 @@ char* ofono_get_datacard(void) {
         return NULL;
     }
 
-    result = g_dbus_connection_call_sync(
+    datacard_path = scope_lookup(SCOPE_KEY_DATACARD);
+    if (datacard_path) {
+        return datacard_path;
+    }
+
+    result = dbus_connection_call_timed(
         g_dbus_conn, OFONO_SERVICE, "/", "org.ofono.Manager",
         "GetDataCard", NULL, G_VARIANT_TYPE("(o)"),
         G_DBUS_CALL_FLAGS_NONE, 5000, NULL, &error
@@ -359,6 +561,7 @@ char* ofono_get_datacard(void) {
     }
 
     g_variant_unref(result);
+    scope_store(SCOPE_KEY_DATACARD, datacard_path);
     return datacard_path;
 }
 
@@ -416,7 +619,7 @@ int ofono_network_set_mode_sync(const char* modem_path, int mode, int timeout_ms
         return -3;
     }
 
-    result = g_dbus_proxy_call_sync(
+    result = dbus_proxy_call_timed(
         proxy, "SetProperty",
         g_variant_new("(sv)", "TechnologyPreference", g_variant_new_string(mode_str)),
         G_DBUS_CALL_FLAGS_NONE, timeout_ms, NULL, &error
@@ -453,7 +656,7 @@ int ofono_modem_set_online(const char* modem_path, int online, int timeout_ms) {
         return -2;
     }
 
-    result = g_dbus_proxy_call_sync(
+    result = dbus_proxy_call_timed(
         proxy, "SetProperty",
         g_variant_new("(sv)", "Online", g_variant_new_boolean(online ? TRUE : FALSE)),
         G_DBUS_CALL_FLAGS_NONE, timeout_ms, NULL, &error
@@ -479,7 +682,7 @@ int ofono_set_datacard(const char* modem_path) {
         return 0;
     }
 
-    result = g_dbus_connection_call_sync(
+    result = dbus_connection_call_timed(
         g_dbus_conn, OFONO_SERVICE, "/", "org.ofono.Manager",
         "SetDataCard", g_variant_new("(o)", modem_path),
         NULL, G_DBUS_CALL_FLAGS_NONE, 5000, NULL, &error
@@ -515,7 +718,7 @@ int ofono_network_get_signal_strength(const char* modem_path, int* strength, int
         return -2;
     }
 
-    result = g_dbus_proxy_call_sync(
+    result = dbus_proxy_call_timed(
         proxy, "GetProperties", NULL,
         G_DBUS_CALL_FLAGS_NONE, timeout_ms, NULL, &error
     );
@@ -600,7 +803,7 @@ static int find_internet_context_path(char *path_buf, size_t buf_size) {
     }
 
     /* 调用 GetContexts 获取所有 context */
-    result = g_dbus_proxy_call_sync(
+    result = dbus_proxy_call_timed(
         proxy, "GetContexts", NULL,
         G_DBUS_CALL_FLAGS_NONE, OFONO_TIMEOUT_MS, NULL, &error
     );
@@ -702,7 +905,7 @@ int ofono_get_data_status(int *active) {
         return -2;
     }
 
-    result = g_dbus_proxy_call_sync(
+    result = dbus_proxy_call_timed(
         proxy, "GetProperties", NULL,
         G_DBUS_CALL_FLAGS_NONE, OFONO_TIMEOUT_MS, NULL, &error
     );
@@ -761,7 +964,7 @@ int ofono_set_data_status(int active) {
         return -2;
     }
 
-    result = g_dbus_proxy_call_sync(
+    result = dbus_proxy_call_timed(
         proxy, "SetProperty",
         g_variant_new("(sv)", "Active", g_variant_new_boolean(active ? TRUE : FALSE)),
         G_DBUS_CALL_FLAGS_NONE, OFONO_TIMEOUT_MS, NULL, &error
@@ -803,7 +1006,7 @@ int ofono_get_roaming_status(int *roaming_allowed, int *is_roaming) {
         return -2;
     }
 
-    result = g_dbus_proxy_call_sync(
+    result = dbus_proxy_call_timed(
         proxy, "GetProperties", NULL,
         G_DBUS_CALL_FLAGS_NONE, OFONO_TIMEOUT_MS, NULL, &error
     );
@@ -844,7 +1047,7 @@ int ofono_get_roaming_status(int *roaming_allowed, int *is_roaming) {
         return ret;  /* 返回已获取的 roaming_allowed */
     }
 
-    result = g_dbus_proxy_call_sync(
+    result = dbus_proxy_call_timed(
         proxy, "GetProperties", NULL,
         G_DBUS_CALL_FLAGS_NONE, OFONO_TIMEOUT_MS, NULL, &error
     );
@@ -897,7 +1100,7 @@ int ofono_set_roaming_allowed(int allowed) {
         return -2;
     }
 
-    result = g_dbus_proxy_call_sync(
+    result = dbus_proxy_call_timed(
         proxy, "SetProperty",
         g_variant_new("(sv)", "RoamingAllowed", g_variant_new_boolean(allowed ? TRUE : FALSE)),
         G_DBUS_CALL_FLAGS_NONE, OFONO_TIMEOUT_MS, NULL, &error
@@ -940,7 +1143,7 @@ int ofono_get_all_apn_contexts(ApnContext *contexts, int max_count) {
     }
 
     /* 调用 GetContexts */
-    result = g_dbus_proxy_call_sync(
+    result = dbus_proxy_call_timed(
         proxy, "GetContexts", NULL,
         G_DBUS_CALL_FLAGS_NONE, OFONO_TIMEOUT_MS, NULL, &error
     );
@@ -1040,7 +1243,7 @@ int ofono_set_apn_property(const char *context_path, const char *property, const
         return -2;
     }
 
-    result = g_dbus_proxy_call_sync(
+    result = dbus_proxy_call_timed(
         proxy, "SetProperty",
         g_variant_new("(sv)", property, g_variant_new_string(value)),
         G_DBUS_CALL_FLAGS_NONE, OFONO_TIMEOUT_MS, NULL, &error
@@ -1084,7 +1287,7 @@ int ofono_set_apn_properties(const char *context_path,
         return -2;
     }
 
-    result = g_dbus_proxy_call_sync(
+    result = dbus_proxy_call_timed(
         proxy, "GetProperties", NULL,
         G_DBUS_CALL_FLAGS_NONE, OFONO_TIMEOUT_MS, NULL, &error
     );
@@ -1112,7 +1315,7 @@ int ofono_set_apn_properties(const char *context_path,
             NULL, &error
         );
         if (proxy) {
-            result = g_dbus_proxy_call_sync(
+            result = dbus_proxy_call_timed(
                 proxy, "SetProperty",
                 g_variant_new("(sv)", "Active", g_variant_new_boolean(FALSE)),
                 G_DBUS_CALL_FLAGS_NONE, OFONO_TIMEOUT_MS, NULL, &error
@@ -1151,7 +1354,7 @@ int ofono_set_apn_properties(const char *context_path,
             NULL, &error
         );
         if (proxy) {
-            result = g_dbus_proxy_call_sync(
+            result = dbus_proxy_call_timed(
                 proxy, "SetProperty",
                 g_variant_new("(sv)", "Active", g_variant_new_boolean(TRUE)),
                 G_DBUS_CALL_FLAGS_NONE, OFONO_TIMEOUT_MS, NULL, &error
@@ -1194,7 +1397,7 @@ int ofono_get_serving_cell_tech(char *tech, int size) {
     }
 
     /* 调用 GetServingCellInformation */
-    result = g_dbus_proxy_call_sync(
+    result = dbus_proxy_call_timed(
         proxy, "GetServingCellInformation", NULL,
         G_DBUS_CALL_FLAGS_NONE, OFONO_TIMEOUT_MS, NULL, &error
     );
@@ -1268,7 +1471,7 @@ int ofono_get_network_status(char *status, int size) {
         return -2;
     }
 
-    result = g_dbus_proxy_call_sync(
+    result = dbus_proxy_call_timed(
         proxy, "GetProperties", NULL,
         G_DBUS_CALL_FLAGS_NONE, OFONO_TIMEOUT_MS, NULL, &error
     );
@@ -1354,7 +1557,7 @@ int ofono_check_and_restore_data(char *result, int size) {
         return -1;
     }
 
-    ctx_result = g_dbus_proxy_call_sync(
+    ctx_result = dbus_proxy_call_timed(
         proxy, "GetProperties", NULL,
         G_DBUS_CALL_FLAGS_NONE, OFONO_TIMEOUT_MS, NULL, &error
     );
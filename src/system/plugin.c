@@ -87,27 +87,6 @@ int execute_shell(const char *cmd, char *output, size_t size) {
 }
 
 
-/* JSON字符串转义 */
-static void json_escape(const char *src, char *dst, size_t dst_size) {
-    size_t j = 0;
-    for (size_t i = 0; src[i] && j < dst_size - 2; i++) {
-        char c = src[i];
-        switch (c) {
-            case '"':  if (j + 2 < dst_size) { dst[j++] = '\\'; dst[j++] = '"'; } break;
-            case '\\': if (j + 2 < dst_size) { dst[j++] = '\\'; dst[j++] = '\\'; } break;
-            case '\n': if (j + 2 < dst_size) { dst[j++] = '\\'; dst[j++] = 'n'; } break;
-            case '\r': if (j + 2 < dst_size) { dst[j++] = '\\'; dst[j++] = 'r'; } break;
-            case '\t': if (j + 2 < dst_size) { dst[j++] = '\\'; dst[j++] = 't'; } break;
-            default:
-                if ((unsigned char)c >= 0x20) {
-                    dst[j++] = c;
-                }
-                break;
-        }
-    }
-    dst[j] = '\0';
-}
-
 /* 从插件内容中提取元信息 */
 static int extract_plugin_meta(const char *content, char *name, char *version, 
                                 char *author, char *description, char *icon, char *color) {
@@ -148,22 +127,19 @@ static int extract_plugin_meta(const char *content, char *name, char *version,
     return 0;
 }
 
-/* 获取插件列表 */
-int get_plugin_list(char *json_output, size_t size) {
+/* 开始遍历插件目录 */
+void plugin_list_open(PluginList *list) {
     ensure_plugin_dir();
+    list->dir = opendir(PLUGIN_DIR);
+    list->count = 0;
+}
 
-    DIR *dir = opendir(PLUGIN_DIR);
-    if (!dir) {
-        snprintf(json_output, size, "[]");
-        return 0;
-    }
-
-    int offset = 0;
-    int count = 0;
-    offset += snprintf(json_output + offset, size - offset, "[");
-
+/* 写入下一个插件，跳过无法读取或过大的文件 */
+int plugin_list_next(PluginList *list, JsonWriter *w) {
+    DIR *dir = (DIR *)list->dir;
     struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL && count < PLUGIN_MAX_COUNT) {
+
+    while (dir && list->count < PLUGIN_MAX_COUNT && (entry = readdir(dir)) != NULL) {
         /* 只处理.js文件 */
         const char *ext = strrchr(entry->d_name, '.');
         if (!ext || strcmp(ext, ".js") != 0) continue;
@@ -190,37 +166,39 @@ int get_plugin_list(char *json_output, size_t size) {
             continue;
         }
 
-        fread(content, 1, fsize, fp);
-        content[fsize] = '\0';
+        size_t nread = fread(content, 1, fsize, fp);
+        content[nread] = '\0';
         fclose(fp);
 
         /* 提取元信息 */
         char name[128], version[32], author[64], description[256], icon[64], color[128];
         extract_plugin_meta(content, name, version, author, description, icon, color);
 
-        /* 转义内容 */
-        char *escaped_content = malloc(fsize * 2 + 1);
-        if (escaped_content) {
-            json_escape(content, escaped_content, fsize * 2 + 1);
-
-            /* 添加到JSON数组 */
-            offset += snprintf(json_output + offset, size - offset,
-                "%s{\"filename\":\"%s\",\"name\":\"%s\",\"version\":\"%s\","
-                "\"author\":\"%s\",\"description\":\"%s\",\"icon\":\"%s\","
-                "\"color\":\"%s\",\"content\":\"%s\"}",
-                count > 0 ? "," : "",
-                entry->d_name, name, version, author, description, icon, color, escaped_content);
-
-            free(escaped_content);
-            count++;
-        }
+        json_begin_object(w);
+        json_kv_string(w, "filename", entry->d_name);
+        json_kv_string(w, "name", name);
+        json_kv_string(w, "version", version);
+        json_kv_string(w, "author", author);
+        json_kv_string(w, "description", description);
+        json_kv_string(w, "icon", icon);
+        json_kv_string(w, "color", color);
+        json_key(w, "content");
+        json_string_n(w, content, nread);
+        json_end_object(w);
+
         free(content);
+        list->count++;
+        return 1;
     }
+    return 0;
+}
 
-    closedir(dir);
-    offset += snprintf(json_output + offset, size - offset, "]");
-
-    return count;
+/* 结束遍历 */
+void plugin_list_close(PluginList *list) {
+    if (list->dir) {
+        closedir((DIR *)list->dir);
+        list->dir = NULL;
+    }
 }
 
 
@@ -153,14 +153,11 @@ void sha256_final(SHA256_CTX *ctx, uint8_t *hash)
     }
 }
 
-void sha256_hash_data(const uint8_t *data, size_t len, char *hex_out)
+void sha256_final_hex(SHA256_CTX *ctx, char *hex_out)
 {
-    SHA256_CTX ctx;
     uint8_t hash[SHA256_BLOCK_SIZE];
 
-    sha256_init(&ctx);
-    sha256_update(&ctx, data, len);
-    sha256_final(&ctx, hash);
+    sha256_final(ctx, hash);
 
     /* 转换为hex字符串 */
     for (int i = 0; i < SHA256_BLOCK_SIZE; i++) {
@@ -169,6 +166,15 @@ void sha256_hash_data(const uint8_t *data, size_t len, char *hex_out)
     hex_out[SHA256_HEX_SIZE - 1] = '\0';
 }
 
+void sha256_hash_data(const uint8_t *data, size_t len, char *hex_out)
+{
+    SHA256_CTX ctx;
+
+    sha256_init(&ctx);
+    sha256_update(&ctx, data, len);
+    sha256_final_hex(&ctx, hex_out);
+}
+
 void sha256_hash_string(const char *str, char *hex_out)
 {
     sha256_hash_data((const uint8_t *)str, strlen(str), hex_out);
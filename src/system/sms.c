@@ -6,17 +6,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <pthread.h>
+#include <unistd.h>
 #include <gio/gio.h>
 #include "sms.h"
 #include "database.h"
 #include "exec_utils.h"
+#include "events.h"
 
 /* 短信模块专用互斥锁 */
 static pthread_mutex_t g_sms_mutex = PTHREAD_MUTEX_INITIALIZER;
 static GDBusConnection *g_sms_dbus_conn = NULL;
 static guint g_signal_subscription_id = 0;
 static guint g_name_watch_id = 0;
+static guint g_maintenance_source = 0;
 static int g_sms_initialized = 0;
 static int g_ofono_available = 0;
 
@@ -29,19 +33,23 @@ static WebhookConfig g_webhook_config = {0};
 static int g_max_sms_count = DEFAULT_MAX_SMS_COUNT;
 static int g_max_sent_count = DEFAULT_MAX_SENT_COUNT;
 
+/* D-Bus连接维护检查间隔（秒） */
+#define SMS_MAINTENANCE_INTERVAL 30
+
 /* 前向声明 */
 static void on_incoming_message(GDBusConnection *conn, const gchar *sender_name,
     const gchar *object_path, const gchar *interface_name, const gchar *signal_name,
     GVariant *parameters, gpointer user_data);
 static int save_sms_to_db(const char *sender, const char *content, time_t timestamp);
 static int save_sent_sms_to_db(const char *recipient, const char *content, time_t timestamp, const char *status);
-static void send_webhook_notification(const SmsMessage *msg);
+static void send_webhook_notification(const WebhookConfig *config, const SmsMessage *msg);
 static void load_sms_config(void);
 static void subscribe_sms_signal(void);
 static void unsubscribe_sms_signal(void);
 static void on_ofono_appeared(GDBusConnection *conn, const gchar *name, const gchar *name_owner, gpointer user_data);
 static void on_ofono_vanished(GDBusConnection *conn, const gchar *name, gpointer user_data);
 static void apply_sms_fix_on_init(void);
+static gboolean sms_maintenance_timer(gpointer user_data);
 
 /* JSON解析辅助函数 - 解析JSON字符串值，处理转义字符 */
 static int parse_json_string(const char *json, const char *key, char *out, size_t out_size) {
@@ -103,23 +111,6 @@ static long parse_json_number(const char *json, const char *key) {
     return atol(start);
 }
 
-/* Hex解码函数 - 将hex字符串解码为原始字节 */
-static void hex_decode(const char *hex, char *out, size_t out_size) {
-    size_t i = 0, j = 0;
-    size_t hex_len = strlen(hex);
-    
-    while (i < hex_len && j < out_size - 1) {
-        unsigned int byte;
-        if (sscanf(hex + i, "%2x", &byte) == 1) {
-            out[j++] = (char)byte;
-            i += 2;
-        } else {
-            break;
-        }
-    }
-    out[j] = '\0';
-}
-
 /* 保存短信到数据库 */
 static int save_sms_to_db(const char *sender, const char *content, time_t timestamp) {
     char sql[2048];
@@ -255,6 +246,38 @@ static void on_dbus_connection_closed(GDBusConnection *conn, gboolean remote_pee
     g_sms_dbus_conn = NULL;
 }
 
+/* 新短信任务：Webhook配置在主循环提交时复制，工作线程不读全局配置 */
+typedef struct {
+    SmsMessage msg;
+    WebhookConfig webhook;
+} IncomingSmsJob;
+
+/* 复制当前Webhook配置（与 sms_save_webhook_config 的更新互斥） */
+static void webhook_config_snapshot(WebhookConfig *out) {
+    pthread_mutex_lock(&g_sms_mutex);
+    memcpy(out, &g_webhook_config, sizeof(WebhookConfig));
+    pthread_mutex_unlock(&g_sms_mutex);
+}
+
+/* DB工作线程：保存新短信并发送Webhook通知 */
+static void incoming_sms_job(void *arg) {
+    IncomingSmsJob *job = (IncomingSmsJob *)arg;
+    SmsMessage *msg = &job->msg;
+    
+    if (save_sms_to_db(msg->sender, msg->content, msg->timestamp) == 0) {
+        printf("[SMS] 短信已保存到数据库\n");
+        
+        /* 发送Webhook通知 */
+        send_webhook_notification(&job->webhook, msg);
+    }
+}
+
+/* 主循环：短信或发送记录已入库，通知事件订阅者 */
+static void sms_saved_done(void *arg) {
+    free(arg);
+    events_invalidate("/api/sms/state");
+}
+
 /* D-Bus信号处理 - 接收新短信 */
 static void on_incoming_message(GDBusConnection *conn, const gchar *sender_name,
     const gchar *object_path, const gchar *interface_name, const gchar *signal_name,
@@ -291,35 +314,30 @@ static void on_incoming_message(GDBusConnection *conn, const gchar *sender_name,
     
     printf("[SMS] 新短信 - 发件人: %s, 内容: %s\n", sender, content);
     
-    /* 保存到数据库 */
-    time_t now = time(NULL);
-    if (save_sms_to_db(sender, content, now) == 0) {
-        printf("[SMS] 短信已保存到数据库\n");
-        
-        /* 发送Webhook通知 */
-        if (g_webhook_config.enabled && strlen(g_webhook_config.url) > 0) {
-            SmsMessage msg = {0};
-            strncpy(msg.sender, sender, sizeof(msg.sender) - 1);
-            strncpy(msg.content, content, sizeof(msg.content) - 1);
-            msg.timestamp = now;
-            send_webhook_notification(&msg);
-        }
+    /* 保存到数据库并转发 - 交给DB工作线程，信号处理不阻塞主循环 */
+    IncomingSmsJob *job = (IncomingSmsJob *)calloc(1, sizeof(IncomingSmsJob));
+    if (job) {
+        strncpy(job->msg.sender, sender, sizeof(job->msg.sender) - 1);
+        strncpy(job->msg.content, content, sizeof(job->msg.content) - 1);
+        job->msg.timestamp = time(NULL);
+        webhook_config_snapshot(&job->webhook);
+        db_async_run_or_submit(incoming_sms_job, sms_saved_done, job);
     }
     
     g_variant_unref(props);
 }
 
-/* 发送Webhook通知 */
-static void send_webhook_notification(const SmsMessage *msg) {
-    if (!g_webhook_config.enabled || strlen(g_webhook_config.url) == 0) {
+/* 发送Webhook通知（可在DB工作线程执行，只使用传入的配置副本） */
+static void send_webhook_notification(const WebhookConfig *config, const SmsMessage *msg) {
+    if (!config->enabled || strlen(config->url) == 0) {
         return;
     }
     
-    printf("[SMS] 发送Webhook通知到: %s\n", g_webhook_config.url);
+    printf("[SMS] 发送Webhook通知到: %s\n", config->url);
     
     /* 替换变量 */
     char body[4096];
-    strncpy(body, g_webhook_config.body, sizeof(body) - 1);
+    strncpy(body, config->body, sizeof(body) - 1);
     body[sizeof(body) - 1] = '\0';
     
     /* 简单的变量替换 */
@@ -342,22 +360,28 @@ static void send_webhook_notification(const SmsMessage *msg) {
     
     /* 替换 #{time} */
     char time_str[32];
-    struct tm *tm_info = localtime(&msg->timestamp);
-    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
+    struct tm tm_info;
+    localtime_r(&msg->timestamp, &tm_info);
+    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", &tm_info);
     while ((p = strstr(body, "#{time}")) != NULL) {
         *p = '\0';
         snprintf(temp, sizeof(temp), "%s%s%s", body, time_str, p + 7);
         strncpy(body, temp, sizeof(body) - 1);
     }
     
-    /* 将body写入临时文件，避免shell转义问题 */
-    const char *tmp_file = "/tmp/webhook_body.json";
-    FILE *fp = fopen(tmp_file, "w");
+    /* 将body写入临时文件，避免shell转义问题；每次通知独立一个文件，并发发送互不覆盖 */
+    char tmp_file[] = "/tmp/webhook_body_XXXXXX";
+    int fd = mkstemp(tmp_file);
+    FILE *fp = fd >= 0 ? fdopen(fd, "w") : NULL;
     if (fp) {
         fputs(body, fp);
         fclose(fp);
     } else {
         printf("[SMS] 无法创建临时文件\n");
+        if (fd >= 0) {
+            close(fd);
+            unlink(tmp_file);
+        }
         return;
     }
     
@@ -366,9 +390,9 @@ static void send_webhook_notification(const SmsMessage *msg) {
     char headers_part[1024] = "";
     
     /* 解析自定义headers（格式：Header1: Value1\nHeader2: Value2） */
-    if (strlen(g_webhook_config.headers) > 0) {
+    if (strlen(config->headers) > 0) {
         char headers_copy[512];
-        strncpy(headers_copy, g_webhook_config.headers, sizeof(headers_copy) - 1);
+        strncpy(headers_copy, config->headers, sizeof(headers_copy) - 1);
         headers_copy[sizeof(headers_copy) - 1] = '\0';
         
         char *line = strtok(headers_copy, "\n");
@@ -392,11 +416,11 @@ static void send_webhook_notification(const SmsMessage *msg) {
     if (strstr(headers_part, "Content-Type") == NULL) {
         snprintf(cmd, sizeof(cmd),
             "sh -c \"curl -s -X POST '%s' -H 'Content-Type: application/json'%s -d @%s; rm -f %s\" &",
-            g_webhook_config.url, headers_part, tmp_file, tmp_file);
+            config->url, headers_part, tmp_file, tmp_file);
     } else {
         snprintf(cmd, sizeof(cmd),
             "sh -c \"curl -s -X POST '%s'%s -d @%s; rm -f %s\" &",
-            g_webhook_config.url, headers_part, tmp_file, tmp_file);
+            config->url, headers_part, tmp_file, tmp_file);
     }
     
     printf("[SMS] 执行: %s\n", cmd);
@@ -455,6 +479,9 @@ int sms_init(const char *db_path) {
     subscribe_sms_signal();
     g_ofono_available = 1;  /* 假设oFono可用，后续会通过监控更新 */
     
+    /* 定期检查并恢复D-Bus连接 */
+    g_maintenance_source = g_timeout_add_seconds(SMS_MAINTENANCE_INTERVAL, sms_maintenance_timer, NULL);
+    
     printf("[SMS] 短信模块初始化成功\n");
     g_sms_initialized = 1;
     return 0;
@@ -467,6 +494,11 @@ void sms_deinit(void) {
     /* 取消信号订阅 */
     unsubscribe_sms_signal();
     
+    if (g_maintenance_source > 0) {
+        g_source_remove(g_maintenance_source);
+        g_maintenance_source = 0;
+    }
+    
     /* 取消oFono服务监控 */
     if (g_name_watch_id > 0) {
         g_bus_unwatch_name(g_name_watch_id);
@@ -484,6 +516,12 @@ void sms_deinit(void) {
 }
 
 
+/* DB工作线程：保存发送记录 */
+static void sent_sms_job(void *arg) {
+    SentSmsMessage *sent = (SentSmsMessage *)arg;
+    save_sent_sms_to_db(sent->recipient, sent->content, sent->timestamp, sent->status);
+}
+
 /* 发送短信 */
 int sms_send(const char *recipient, const char *content, char *result_path, size_t path_size) {
     GError *error = NULL;
@@ -534,94 +572,70 @@ int sms_send(const char *recipient, const char *content, char *result_path, size
     printf("[SMS] 短信发送成功，路径: %s\n", path ? path : "N/A");
     g_variant_unref(result);
     
-    /* 保存发送记录到数据库 */
-    save_sent_sms_to_db(recipient, content, time(NULL), "sent");
+    /* 保存发送记录到数据库（异步） */
+    SentSmsMessage *sent = (SentSmsMessage *)calloc(1, sizeof(SentSmsMessage));
+    if (sent) {
+        strncpy(sent->recipient, recipient, sizeof(sent->recipient) - 1);
+        strncpy(sent->content, content, sizeof(sent->content) - 1);
+        strncpy(sent->status, "sent", sizeof(sent->status) - 1);
+        sent->timestamp = time(NULL);
+        db_async_run_or_submit(sent_sms_job, sms_saved_done, sent);
+    }
     
     return 0;
 }
 
-/* 获取短信列表 - 使用hex编码避免特殊字符问题，兼容无JSON扩展的SQLite */
+/* 短信列表行回调上下文 */
+typedef struct {
+    void *messages;
+    int max_count;
+    int count;
+} SmsListCtx;
+
+/* 收件箱行回调 - 列: id, sender, content, timestamp, is_read */
+static int sms_list_row(const DbValue *cols, int ncols, void *ctx) {
+    SmsListCtx *list = (SmsListCtx *)ctx;
+    if (ncols < 5 || list->count >= list->max_count) return 1;
+    
+    SmsMessage *msg = &((SmsMessage *)list->messages)[list->count++];
+    msg->id = (int)cols[0].i;
+    db_value_copy(&cols[1], msg->sender, sizeof(msg->sender));
+    db_value_copy(&cols[2], msg->content, sizeof(msg->content));
+    msg->timestamp = (time_t)cols[3].i;
+    msg->is_read = (int)cols[4].i;
+    return 0;
+}
+
+/* 获取短信列表 */
 int sms_get_list(SmsMessage *messages, int max_count) {
-    char sql[512];
-    char *output = NULL;
+    return sms_get_list_range(messages, max_count, 0, 0);
+}
+
+/* 按ID区间获取短信列表（id 是主键，区间条件直接走主键范围扫描） */
+int sms_get_list_range(SmsMessage *messages, int max_count, int before_id, int since_id) {
+    SmsListCtx ctx = { messages, max_count, 0 };
     
     if (!messages || max_count <= 0) return -1;
     
-    /* 分配大缓冲区 */
-    output = (char *)malloc(256 * 1024);
-    if (!output) return -1;
-    
-    /* 使用hex编码content字段，用|分隔，每行一条记录 */
-    snprintf(sql, sizeof(sql),
-        "SELECT id || '|' || sender || '|' || hex(content) || '|' || timestamp || '|' || is_read FROM sms ORDER BY id DESC LIMIT %d;",
-        max_count);
+    DbValue args[] = {
+        DB_ARG_INT(max_count), DB_ARG_INT(since_id), DB_ARG_INT(before_id > 0 ? before_id : INT_MAX),
+        DB_ARG_END
+    };
     
     pthread_mutex_lock(&g_sms_mutex);
-    int ret = db_query_string(sql, output, 256 * 1024);
+    int ret = db_query_each(
+        "SELECT id, sender, content, timestamp, is_read FROM sms "
+        "WHERE id > ?2 AND id < ?3 ORDER BY id DESC LIMIT ?1;",
+        args, sms_list_row, &ctx);
     pthread_mutex_unlock(&g_sms_mutex);
     
-    if (ret != 0 || strlen(output) == 0) {
-        printf("[SMS] 获取短信列表失败或为空\n");
-        free(output);
+    if (ret < 0) {
+        printf("[SMS] 获取短信列表失败\n");
         return 0;
     }
     
-    /* 解析输出 - 格式: id|sender|hex_content|timestamp|is_read\n */
-    int count = 0;
-    char *line = output;
-    char *next_line;
-    
-    while (line && *line && count < max_count) {
-        /* 找到行尾 */
-        next_line = strchr(line, '\n');
-        if (next_line) {
-            *next_line = '\0';
-            next_line++;
-        }
-        
-        /* 跳过空行 */
-        if (strlen(line) == 0) {
-            line = next_line;
-            continue;
-        }
-        
-        /* 解析字段: id|sender|hex_content|timestamp|is_read */
-        char *fields[5] = {NULL};
-        int field_count = 0;
-        char *p = line;
-        char *field_start = p;
-        
-        while (*p && field_count < 5) {
-            if (*p == '|') {
-                *p = '\0';
-                fields[field_count++] = field_start;
-                field_start = p + 1;
-            }
-            p++;
-        }
-        if (field_count < 5 && field_start) {
-            fields[field_count++] = field_start;
-        }
-        
-        if (field_count >= 5) {
-            messages[count].id = atoi(fields[0]);
-            strncpy(messages[count].sender, fields[1], sizeof(messages[count].sender) - 1);
-            messages[count].sender[sizeof(messages[count].sender) - 1] = '\0';
-            
-            /* hex解码content */
-            hex_decode(fields[2], messages[count].content, sizeof(messages[count].content));
-            
-            messages[count].timestamp = (time_t)atol(fields[3]);
-            messages[count].is_read = atoi(fields[4]);
-            count++;
-        }
-        
-        line = next_line;
-    }
-    
-    free(output);
-    printf("[SMS] 获取到 %d 条短信\n", count);
-    return count;
+    printf("[SMS] 获取到 %d 条短信\n", ctx.count);
+    return ctx.count;
 }
 
 /* 获取短信总数 */
@@ -733,8 +747,10 @@ int sms_save_webhook_config(const WebhookConfig *config) {
     pthread_mutex_unlock(&g_sms_mutex);
     
     if (ret == 0) {
-        /* 更新内存中的配置 */
+        /* 更新内存中的配置（工作线程通过 webhook_config_snapshot 读取副本） */
+        pthread_mutex_lock(&g_sms_mutex);
         memcpy(&g_webhook_config, config, sizeof(WebhookConfig));
+        pthread_mutex_unlock(&g_sms_mutex);
         printf("[SMS] Webhook配置保存成功\n");
     } else {
         printf("[SMS] Webhook配置保存失败\n");
@@ -753,12 +769,15 @@ int sms_test_webhook(void) {
         .is_read = 0
     };
     
-    if (!g_webhook_config.enabled || strlen(g_webhook_config.url) == 0) {
+    WebhookConfig config;
+    
+    webhook_config_snapshot(&config);
+    if (!config.enabled || strlen(config.url) == 0) {
         printf("[SMS] Webhook未启用或URL为空\n");
         return -1;
     }
     
-    send_webhook_notification(&test_msg);
+    send_webhook_notification(&config, &test_msg);
     return 0;
 }
 
@@ -770,11 +789,17 @@ int sms_check_status(void) {
 }
 
 /* 定期维护短信模块 - 增强版 */
+static gboolean sms_maintenance_timer(gpointer user_data) {
+    (void)user_data;
+    sms_maintenance();
+    return G_SOURCE_CONTINUE;
+}
+
 void sms_maintenance(void) {
     static int check_count = 0;
     check_count++;
     
-    /* 每10次检查输出一次状态（约10秒一次，假设1秒调用一次） */
+    /* 每10次检查输出一次状态 */
     if (check_count % 10 == 0) {
         printf("[SMS] 维护检查 #%d - D-Bus: %p, oFono: %d, 订阅ID: %u\n",
                check_count, (void*)g_sms_dbus_conn, g_ofono_available, g_signal_subscription_id);
@@ -915,89 +940,77 @@ int sms_delete_sent(int id) {
     return ret;
 }
 
-/* 获取发送记录列表 - 使用hex编码避免特殊字符问题，兼容无JSON扩展的SQLite */
+/* 发件箱行回调 - 列: id, recipient, content, timestamp, status */
+static int sms_sent_list_row(const DbValue *cols, int ncols, void *ctx) {
+    SmsListCtx *list = (SmsListCtx *)ctx;
+    if (ncols < 5 || list->count >= list->max_count) return 1;
+    
+    SentSmsMessage *msg = &((SentSmsMessage *)list->messages)[list->count++];
+    msg->id = (int)cols[0].i;
+    db_value_copy(&cols[1], msg->recipient, sizeof(msg->recipient));
+    db_value_copy(&cols[2], msg->content, sizeof(msg->content));
+    msg->timestamp = (time_t)cols[3].i;
+    db_value_copy(&cols[4], msg->status, sizeof(msg->status));
+    return 0;
+}
+
+/* 获取发送记录列表 */
 int sms_get_sent_list(SentSmsMessage *messages, int max_count) {
-    char sql[512];
-    char *output = NULL;
+    return sms_get_sent_list_range(messages, max_count, 0, 0);
+}
+
+/* 按ID区间获取发送记录列表 */
+int sms_get_sent_list_range(SentSmsMessage *messages, int max_count, int before_id, int since_id) {
+    SmsListCtx ctx = { messages, max_count, 0 };
     
     if (!messages || max_count <= 0) return -1;
     
-    /* 分配大缓冲区 */
-    output = (char *)malloc(256 * 1024);
-    if (!output) return -1;
-    
-    /* 使用hex编码content字段，用|分隔，每行一条记录 */
-    snprintf(sql, sizeof(sql),
-        "SELECT id || '|' || recipient || '|' || hex(content) || '|' || timestamp || '|' || status FROM sent_sms ORDER BY id DESC LIMIT %d;",
-        max_count);
+    DbValue args[] = {
+        DB_ARG_INT(max_count), DB_ARG_INT(since_id), DB_ARG_INT(before_id > 0 ? before_id : INT_MAX),
+        DB_ARG_END
+    };
     
     pthread_mutex_lock(&g_sms_mutex);
-    int ret = db_query_string(sql, output, 256 * 1024);
+    int ret = db_query_each(
+        "SELECT id, recipient, content, timestamp, status FROM sent_sms "
+        "WHERE id > ?2 AND id < ?3 ORDER BY id DESC LIMIT ?1;",
+        args, sms_sent_list_row, &ctx);
     pthread_mutex_unlock(&g_sms_mutex);
     
-    if (ret != 0 || strlen(output) == 0) {
-        printf("[SMS] 获取发送记录列表失败或为空\n");
-        free(output);
+    if (ret < 0) {
+        printf("[SMS] 获取发送记录列表失败\n");
         return 0;
     }
     
-    /* 解析输出 - 格式: id|recipient|hex_content|timestamp|status\n */
-    int count = 0;
-    char *line = output;
-    char *next_line;
-    
-    while (line && *line && count < max_count) {
-        /* 找到行尾 */
-        next_line = strchr(line, '\n');
-        if (next_line) {
-            *next_line = '\0';
-            next_line++;
-        }
-        
-        /* 跳过空行 */
-        if (strlen(line) == 0) {
-            line = next_line;
-            continue;
-        }
-        
-        /* 解析字段: id|recipient|hex_content|timestamp|status */
-        char *fields[5] = {NULL};
-        int field_count = 0;
-        char *p = line;
-        char *field_start = p;
-        
-        while (*p && field_count < 5) {
-            if (*p == '|') {
-                *p = '\0';
-                fields[field_count++] = field_start;
-                field_start = p + 1;
-            }
-            p++;
-        }
-        if (field_count < 5 && field_start) {
-            fields[field_count++] = field_start;
-        }
-        
-        if (field_count >= 5) {
-            messages[count].id = atoi(fields[0]);
-            strncpy(messages[count].recipient, fields[1], sizeof(messages[count].recipient) - 1);
-            messages[count].recipient[sizeof(messages[count].recipient) - 1] = '\0';
-            
-            /* hex解码content */
-            hex_decode(fields[2], messages[count].content, sizeof(messages[count].content));
-            
-            messages[count].timestamp = (time_t)atol(fields[3]);
-            strncpy(messages[count].status, fields[4], sizeof(messages[count].status) - 1);
-            messages[count].status[sizeof(messages[count].status) - 1] = '\0';
-            count++;
-        }
-        
-        line = next_line;
-    }
+    printf("[SMS] 获取到 %d 条发送记录\n", ctx.count);
+    return ctx.count;
+}
+
+/* 概况行回调 - 列: total, latest_id, sent_total, sent_latest_id */
+static int sms_state_row(const DbValue *cols, int ncols, void *ctx) {
+    SmsState *state = (SmsState *)ctx;
+    if (ncols < 4) return 1;
+    
+    state->total = (int)cols[0].i;
+    state->latest_id = (int)cols[1].i;
+    state->sent_total = (int)cols[2].i;
+    state->sent_latest_id = (int)cols[3].i;
+    return 1;
+}
+
+/* 获取收件箱/发件箱概况 */
+int sms_get_state(SmsState *state) {
+    if (!state) return -1;
+    memset(state, 0, sizeof(*state));
+    
+    pthread_mutex_lock(&g_sms_mutex);
+    int ret = db_query_each(
+        "SELECT (SELECT COUNT(*) FROM sms), (SELECT IFNULL(MAX(id), 0) FROM sms), "
+        "(SELECT COUNT(*) FROM sent_sms), (SELECT IFNULL(MAX(id), 0) FROM sent_sms);",
+        NULL, sms_state_row, state);
+    pthread_mutex_unlock(&g_sms_mutex);
     
-    free(output);
-    printf("[SMS] 获取到 %d 条发送记录\n", count);
-    return count;
+    return ret < 0 ? -1 : 0;
 }
 
 /* 获取最大存储数量 */
@@ -263,14 +263,13 @@ int get_system_info(SystemInfo *info) {
 /* AT+CGEQOSRDP 返回: +CGEQOSRDP: 1,8,0,0,0,0,500000,60000 */
 /* 索引1=QCI, 索引6=下行速率(kbps), 索引7=上行速率(kbps) */
 int get_qos_info(int *qci, int *downlink, int *uplink) {
-    extern int execute_at(const char *command, char **result);
     char *result = NULL;
     
     *qci = 0;
     *downlink = 0;
     *uplink = 0;
 
-    if (execute_at("AT+CGEQOSRDP", &result) != 0 || !result) {
+    if (execute_at_query(AT_QUERY_QOS, &result) != 0 || !result) {
         return -1;
     }
 
@@ -362,6 +361,7 @@ static unsigned long long prev_user = 0, prev_nice = 0, prev_system = 0;
 static unsigned long long prev_idle = 0, prev_iowait = 0, prev_irq = 0;
 static unsigned long long prev_softirq = 0, prev_steal = 0;
 static int cpu_initialized = 0;
+G_LOCK_DEFINE_STATIC(cpu_prev);     /* /api/info 可能在多个工作线程中同时执行 */
 
 double get_cpu_usage(void) {
     char buf[1024];
@@ -389,6 +389,8 @@ double get_cpu_usage(void) {
     if (ret < 7) softirq = 0;
     if (ret < 8) steal = 0;
     
+    G_LOCK(cpu_prev);
+    
     /* 首次调用，保存数据并返回0 */
     if (!cpu_initialized) {
         prev_user = user;
@@ -400,6 +402,7 @@ double get_cpu_usage(void) {
         prev_softirq = softirq;
         prev_steal = steal;
         cpu_initialized = 1;
+        G_UNLOCK(cpu_prev);
         return 0;
     }
     
@@ -426,6 +429,7 @@ double get_cpu_usage(void) {
     prev_irq = irq;
     prev_softirq = softirq;
     prev_steal = steal;
+    G_UNLOCK(cpu_prev);
     
     /* 避免除零 */
     if (total_diff == 0) return 0;
@@ -37,10 +37,17 @@ static TrafficConfig read_traffic_config(void) {
     return config;
 }
 
-/* 保存流量配置 - 写入SQLite数据库 */
+/* 保存流量配置 - 单事务写入SQLite数据库 */
 static void save_traffic_config(TrafficConfig *config) {
-    config_set_int("traffic_switch", config->switch_on);
-    config_set_ll("traffic_much", config->much);
+    char switch_str[16], much_str[32];
+    snprintf(switch_str, sizeof(switch_str), "%d", config->switch_on);
+    snprintf(much_str, sizeof(much_str), "%lld", config->much);
+
+    ConfigKV kvs[] = {
+        { "traffic_switch", switch_str },
+        { "traffic_much", much_str },
+    };
+    config_set_many(kvs, sizeof(kvs) / sizeof(kvs[0]));
 }
 
 
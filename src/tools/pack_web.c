@@ -0,0 +1,196 @@
+/**
+ * @file pack_web.c
+ * @brief 构建工具：把前端构建产物打包为 C 源文件（mongoose packed FS）
+ *
+ * 用法: pack_web <dist目录> > web_fs.c
+ *
+ * 递归收集目录下的所有文件，按路径排序后输出文件数据数组和路径索引，
+ * 并实现 mongoose 所需的 mg_unpack/mg_unlist。
+ * 每个文件只内置一份：有 .gz 预压缩副本的只内置 .gz（不支持gzip的客户端由
+ * 服务端解压后发送，见 packed_fs.c），.br 副本不内置，其余文件内置原文件。
+ * 路径以 "/" 开头、相对于 dist 目录，如 "/index.html"、"/assets/index-xxx.js"。
+ * 目录不存在时输出空文件系统，服务端会退回磁盘目录。
+ * 该工具在构建主机上运行（HOSTCC），不进入设备程序。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+typedef struct {
+    char *name;         /* 相对路径（以 "/" 开头） */
+    char *path;         /* 磁盘路径 */
+    long mtime;
+    int drop;           /* 不内置 */
+} PackEntry;
+
+static PackEntry *g_entries = NULL;
+static size_t g_count = 0;
+static size_t g_capacity = 0;
+
+static void add_entry(const char *name, const char *path, long mtime) {
+    if (g_count == g_capacity) {
+        g_capacity = g_capacity ? g_capacity * 2 : 64;
+        g_entries = realloc(g_entries, g_capacity * sizeof(PackEntry));
+        if (!g_entries) {
+            fprintf(stderr, "pack_web: out of memory\n");
+            exit(1);
+        }
+    }
+    g_entries[g_count].name = strdup(name);
+    g_entries[g_count].path = strdup(path);
+    g_entries[g_count].mtime = mtime;
+    g_entries[g_count].drop = 0;
+    g_count++;
+}
+
+static void scan_dir(const char *root, const char *rel) {
+    char dir_path[4096];
+    snprintf(dir_path, sizeof(dir_path), "%s%s", root, rel);
+
+    DIR *dir = opendir(dir_path);
+    if (!dir) return;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        /* 跳过隐藏文件，以及无法直接写入C字符串的文件名 */
+        if (entry->d_name[0] == '.' || strpbrk(entry->d_name, "\"\\") != NULL) continue;
+
+        char name[4096], path[4096];
+        struct stat st;
+        snprintf(name, sizeof(name), "%s/%s", rel, entry->d_name);
+        snprintf(path, sizeof(path), "%s%s", root, name);
+        if (stat(path, &st) != 0) continue;
+
+        if (S_ISDIR(st.st_mode)) {
+            scan_dir(root, name);
+        } else if (S_ISREG(st.st_mode)) {
+            add_entry(name, path, (long)st.st_mtime);
+        }
+    }
+    closedir(dir);
+}
+
+static int entry_cmp(const void *a, const void *b) {
+    return strcmp(((const PackEntry *)a)->name, ((const PackEntry *)b)->name);
+}
+
+static int has_suffix(const char *name, const char *suffix) {
+    size_t n = strlen(name), m = strlen(suffix);
+    return n > m && strcmp(name + n - m, suffix) == 0;
+}
+
+/* 已排序的列表中是否有 name.gz */
+static int has_gzip_variant(const char *name) {
+    char gz[4096];
+    PackEntry key;
+
+    snprintf(gz, sizeof(gz), "%s.gz", name);
+    key.name = gz;
+    return bsearch(&key, g_entries, g_count, sizeof(PackEntry), entry_cmp) != NULL;
+}
+
+/* 去掉不需要内置的文件：.br 副本，以及有 .gz 副本的原文件 */
+static void drop_redundant(void) {
+    size_t kept = 0;
+
+    for (size_t i = 0; i < g_count; i++) {
+        g_entries[i].drop = has_suffix(g_entries[i].name, ".br") || has_gzip_variant(g_entries[i].name);
+    }
+    for (size_t i = 0; i < g_count; i++) {
+        if (g_entries[i].drop) {
+            free(g_entries[i].name);
+            free(g_entries[i].path);
+        } else {
+            g_entries[kept++] = g_entries[i];
+        }
+    }
+    g_count = kept;
+}
+
+/* 输出一个文件的数据数组，末尾补0以便按字符串使用 */
+static int emit_data(size_t index, const PackEntry *e, size_t *size) {
+    FILE *fp = fopen(e->path, "rb");
+    if (!fp) {
+        fprintf(stderr, "pack_web: cannot open %s\n", e->path);
+        return -1;
+    }
+
+    printf("static const unsigned char v%zu[] = {", index);
+    int ch;
+    size_t n = 0;
+    while ((ch = fgetc(fp)) != EOF) {
+        printf("%s%d,", n % 24 == 0 ? "\n  " : "", ch);
+        n++;
+    }
+    printf("%s0\n};\n\n", n % 24 == 0 ? "\n  " : "");
+    fclose(fp);
+
+    *size = n;
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <dist-dir> > web_fs.c\n", argv[0]);
+        return 2;
+    }
+
+    const char *root = argv[1];
+    size_t root_len = strlen(root);
+    char root_buf[4096];
+    snprintf(root_buf, sizeof(root_buf), "%.*s", (int)(root_len > 0 && root[root_len - 1] == '/'
+                                                       ? root_len - 1 : root_len), root);
+
+    scan_dir(root_buf, "");
+    qsort(g_entries, g_count, sizeof(PackEntry), entry_cmp);
+    drop_redundant();
+
+    size_t *sizes = calloc(g_count ? g_count : 1, sizeof(size_t));
+    if (!sizes) return 1;
+
+    printf("/* 由 tools/pack_web.c 从 %s 生成，请勿手动修改 */\n\n", root_buf);
+    printf("#include <stddef.h>\n#include <string.h>\n#include <time.h>\n\n");
+
+    for (size_t i = 0; i < g_count; i++) {
+        if (emit_data(i, &g_entries[i], &sizes[i]) != 0) return 1;
+    }
+
+    printf("static const struct packed_entry {\n"
+           "    const char *name;\n"
+           "    const unsigned char *data;\n"
+           "    size_t size;\n"
+           "    time_t mtime;\n"
+           "} packed_entries[] = {\n");
+    for (size_t i = 0; i < g_count; i++) {
+        printf("    { \"%s\", v%zu, %zu, %ld },\n",
+               g_entries[i].name, i, sizes[i], g_entries[i].mtime);
+    }
+    printf("    { NULL, NULL, 0, 0 }\n};\n\n");
+    printf("#define PACKED_COUNT %zu\n\n", g_count);
+
+    /* 路径索引已排序，二分查找 */
+    printf("const char *mg_unlist(size_t no) {\n"
+           "    return no < PACKED_COUNT ? packed_entries[no].name : NULL;\n"
+           "}\n\n"
+           "const char *mg_unpack(const char *name, size_t *size, time_t *mtime) {\n"
+           "    size_t lo = 0, hi = PACKED_COUNT;\n"
+           "    while (lo < hi) {\n"
+           "        size_t mid = lo + (hi - lo) / 2;\n"
+           "        int cmp = strcmp(name, packed_entries[mid].name);\n"
+           "        if (cmp == 0) {\n"
+           "            if (size != NULL) *size = packed_entries[mid].size;\n"
+           "            if (mtime != NULL) *mtime = packed_entries[mid].mtime;\n"
+           "            return (const char *)packed_entries[mid].data;\n"
+           "        }\n"
+           "        if (cmp < 0) hi = mid; else lo = mid + 1;\n"
+           "    }\n"
+           "    return NULL;\n"
+           "}\n");
+
+    fprintf(stderr, "pack_web: packed %zu files from %s\n", g_count, root_buf);
+    free(sizes);
+    return 0;
+}
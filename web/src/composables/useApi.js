@@ -13,11 +13,22 @@ function getAuthToken() {
 // 清除Token（登出时使用）
 export function clearAuthToken() {
   localStorage.removeItem('auth_token')
+  closeEvents()
 }
 
 // 设置Token
 export function setAuthToken(token) {
   localStorage.setItem('auth_token', token)
+  scheduleEventsConnect()
+}
+
+// 调试：localStorage.debug_timing 非空时请求附带 X-Debug-Timing，
+// 响应的 Server-Timing 耗时分解可在开发者工具网络面板的 Timing 中查看
+function addDebugHeaders(headers) {
+  if (localStorage.getItem('debug_timing')) {
+    headers['X-Debug-Timing'] = '1'
+  }
+  return headers
 }
 
 // 检查是否已登录
@@ -35,6 +46,7 @@ export async function authFetch(url, options = {}) {
   if (token) {
     headers['Authorization'] = `Bearer ${token}`
   }
+  addDebugHeaders(headers)
   
   const response = await fetch(url, {
     ...options,
@@ -62,6 +74,7 @@ async function request(url, options = {}) {
   if (token) {
     headers['Authorization'] = `Bearer ${token}`
   }
+  addDebugHeaders(headers)
   
   const response = await fetch(`${BASE_URL}${url}`, {
     headers,
@@ -82,11 +95,42 @@ async function request(url, options = {}) {
   return response.json()
 }
 
+// 同一轮事件循环内发起的只读请求合并为一次 POST /api/batch（如页面初始加载时各组件的查询）
+const batchQueue = []
+
+function batchedGet(url) {
+  return new Promise((resolve, reject) => {
+    batchQueue.push({ url, resolve, reject })
+    if (batchQueue.length === 1) setTimeout(flushBatch, 0)
+  })
+}
+
+async function flushBatch() {
+  const items = batchQueue.splice(0)
+  if (items.length === 1) {
+    request(items[0].url).then(items[0].resolve, items[0].reject)
+    return
+  }
+  try {
+    const results = await request('/api/batch', {
+      method: 'POST',
+      body: JSON.stringify({ requests: [...new Set(items.map(item => item.url))] })
+    })
+    items.forEach(({ url, resolve, reject }) => {
+      const result = results[url]
+      if (result && result.status >= 200 && result.status < 300) resolve(result.body)
+      else reject(new Error(`HTTP错误: ${result ? result.status : 500}`))
+    })
+  } catch (err) {
+    items.forEach(item => item.reject(err))
+  }
+}
+
 // ==================== 系统信息API ====================
 
 // 获取系统信息
 export async function fetchSystemInfo() {
-  return request('/api/info')
+  return batchedGet('/api/info')
 }
 
 // 清除系统缓存
@@ -145,12 +189,12 @@ export async function switchSlot(slot) {
 
 // 获取流量统计
 export async function getTrafficTotal() {
-  return request('/api/get/Total')
+  return batchedGet('/api/get/Total')
 }
 
 // 获取流量配置
 export async function getTrafficConfig() {
-  return request('/api/get/set')
+  return batchedGet('/api/get/set')
 }
 
 // 设置流量限制
@@ -199,7 +243,7 @@ export async function syncSystemTime() {
 
 // 获取数据连接状态
 export async function getDataStatus() {
-  return request('/api/data')
+  return batchedGet('/api/data')
 }
 
 // 设置数据连接状态
@@ -212,7 +256,7 @@ export async function setDataStatus(active) {
 
 // 获取漫游状态
 export async function getRoamingStatus() {
-  return request('/api/roaming')
+  return batchedGet('/api/roaming')
 }
 
 // 设置漫游允许状态
@@ -227,12 +271,12 @@ export async function setRoamingAllowed(allowed) {
 
 // 获取频段状态
 export async function getBands() {
-  return request('/api/bands')
+  return batchedGet('/api/bands')
 }
 
 // 获取当前连接的频段
 export async function getCurrentBand() {
-  return request('/api/current_band')
+  return batchedGet('/api/current_band')
 }
 
 // 锁定频段
@@ -250,7 +294,7 @@ export async function unlockBands() {
 
 // 获取小区信息
 export async function getCells() {
-  return request('/api/cells')
+  return batchedGet('/api/cells')
 }
 
 // 锁定小区
@@ -275,7 +319,7 @@ export async function unlockCell() {
 
 // 获取充电配置和电池状态
 export async function getChargeConfig() {
-  return request('/api/charge/config')
+  return batchedGet('/api/charge/config')
 }
 
 // 设置充电配置
@@ -311,7 +355,7 @@ export async function executeAT(command) {
 
 // 获取当前USB模式
 export async function getUsbMode() {
-  return request('/api/usb/mode')
+  return batchedGet('/api/usb/mode')
 }
 
 // 设置USB模式
@@ -465,7 +509,7 @@ export async function authLogin(password) {
   })
   const data = await response.json()
   if (response.ok && data.token) {
-    localStorage.setItem('auth_token', data.token)
+    setAuthToken(data.token)
   }
   return { ok: response.ok, data }
 }
@@ -495,3 +539,93 @@ export async function authGetStatus() {
   const response = await fetch('/api/auth/status', { headers })
   return response.json()
 }
+
+// ==================== 服务器推送事件 ====================
+// 所有组件共用一个 EventSource（/api/events），订阅的主题变化时重新连接。
+// 服务端只在值变化时推送，数据格式与对应的查询接口相同：
+// sysinfo=/api/info, signal=/api/current_band, cells=/api/cells,
+// traffic=/api/get/Total, battery=/api/charge/config, sms=/api/sms/state
+
+const eventHandlers = new Map()   // 主题 -> 回调集合
+const eventLast = new Map()       // 主题 -> 最近一次数据
+let eventSource = null
+let eventTopicsKey = ''
+let eventConnectPending = false
+let eventRetryTimer = null
+
+function closeEvents() {
+  if (eventRetryTimer) {
+    clearTimeout(eventRetryTimer)
+    eventRetryTimer = null
+  }
+  if (eventSource) {
+    eventSource.close()
+    eventSource = null
+  }
+  eventTopicsKey = ''
+}
+
+function connectEvents() {
+  eventConnectPending = false
+  const topics = [...eventHandlers.keys()].sort()
+  const key = topics.join(',')
+  const token = getAuthToken()
+
+  if (eventSource && key === eventTopicsKey) return
+  closeEvents()
+  if (!topics.length || !token) return
+
+  // EventSource 不能设置请求头，Token 通过查询参数传递
+  const es = new EventSource(`${BASE_URL}/api/events?topics=${key}&token=${encodeURIComponent(token)}`)
+  topics.forEach(topic => {
+    es.addEventListener(topic, e => {
+      let data
+      try { data = JSON.parse(e.data) } catch { return }
+      eventLast.set(topic, data)
+      eventHandlers.get(topic)?.forEach(fn => fn(data))
+    })
+  })
+  // 网络中断时浏览器会自动重连；被服务端拒绝（如重启后Token失效）时连接关闭，稍后重试
+  es.onerror = () => {
+    if (es.readyState === EventSource.CLOSED && eventSource === es) {
+      eventSource = null
+      eventTopicsKey = ''
+      eventRetryTimer = setTimeout(connectEvents, 5000)
+    }
+  }
+  eventSource = es
+  eventTopicsKey = key
+}
+
+// 同一轮中多个组件订阅/退订时只重连一次
+function scheduleEventsConnect() {
+  if (eventConnectPending) return
+  eventConnectPending = true
+  setTimeout(connectEvents, 0)
+}
+
+/**
+ * 订阅服务器推送主题
+ * @param {string} topic 主题名
+ * @param {Function} handler 收到数据时的回调（参数为解析后的JSON）
+ * @returns {Function} 取消订阅函数
+ */
+export function subscribeEvents(topic, handler) {
+  if (!eventHandlers.has(topic)) {
+    eventHandlers.set(topic, new Set())
+  }
+  eventHandlers.get(topic).add(handler)
+  if (eventLast.has(topic)) handler(eventLast.get(topic))
+  scheduleEventsConnect()
+
+  return () => {
+    const handlers = eventHandlers.get(topic)
+    if (!handlers) return
+    handlers.delete(handler)
+    if (handlers.size === 0) {
+      eventHandlers.delete(topic)
+      eventLast.delete(topic)
+      scheduleEventsConnect()
+    }
+  }
+}
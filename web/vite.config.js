@@ -1,8 +1,52 @@
 import { defineConfig } from 'vite'
 import vue from '@vitejs/plugin-vue'
+import { readdirSync, readFileSync, writeFileSync } from 'node:fs'
+import { join, resolve } from 'node:path'
+import { gzipSync, brotliCompressSync, constants as zlibConstants } from 'node:zlib'
+
+// 为可压缩的构建产物生成 .gz/.br 预压缩副本，服务端按 Accept-Encoding 选择发送
+function precompress() {
+  const compressible = /\.(js|css|html|svg|json|txt)$/
+  const minSize = 1024
+  let outDir
+
+  const walk = (dir) => readdirSync(dir, { withFileTypes: true }).flatMap((entry) =>
+    entry.isDirectory() ? walk(join(dir, entry.name)) : [join(dir, entry.name)])
+
+  return {
+    name: 'precompress',
+    apply: 'build',
+    configResolved(config) {
+      outDir = resolve(config.root, config.build.outDir)
+    },
+    closeBundle() {
+      for (const file of walk(outDir)) {
+        if (!compressible.test(file)) continue
+        const data = readFileSync(file)
+        if (data.length < minSize) continue
+
+        const variants = {
+          gz: gzipSync(data, { level: 9 }),
+          br: brotliCompressSync(data, {
+            params: {
+              [zlibConstants.BROTLI_PARAM_QUALITY]: zlibConstants.BROTLI_MAX_QUALITY,
+              [zlibConstants.BROTLI_PARAM_SIZE_HINT]: data.length
+            }
+          })
+        }
+        // 压缩收益不足10%时不生成，避免无意义的副本
+        for (const [ext, compressed] of Object.entries(variants)) {
+          if (compressed.length < data.length * 0.9) {
+            writeFileSync(`${file}.${ext}`, compressed)
+          }
+        }
+      }
+    }
+  }
+}
 
 export default defineConfig({
-  plugins: [vue()],
+  plugins: [vue(), precompress()],
   base: './',
   resolve: {
     alias: {